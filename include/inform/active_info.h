@@ -3,7 +3,9 @@
 // license that can be found in the LICENSE file.
 #pragma once
 
+#include <inform/dist.h>
 #include <inform/error.h>
+#include <inform/workspace.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -24,6 +26,24 @@ extern "C"
 EXPORT double inform_active_info(int const *series, size_t n, size_t m, int b,
     size_t k, inform_error *err);
 
+/**
+ * Compute the active information of an ensemble of time series
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_active_info.
+ *
+ * @param[in] series the ensemble of time series
+ * @param[in] n      the number of initial conditions
+ * @param[in] m      the number of time steps in each time series
+ * @param[in] b      the base or number of distinct states at each time step
+ * @param[in] k      the history length used to calculate the active information
+ * @param[in,out] ws the workspace
+ * @param[out] err   an error structure
+ * @return the active information for the ensemble
+ */
+EXPORT double inform_active_info_ws(int const *series, size_t n, size_t m,
+    int b, size_t k, inform_workspace *ws, inform_error *err);
+
 /**
  * Compute the local active information of a ensemble of time series
  *
@@ -39,6 +59,190 @@ EXPORT double inform_active_info(int const *series, size_t n, size_t m, int b,
 EXPORT double *inform_local_active_info(int const *series, size_t n, size_t m, int b,
     size_t k, double *ai, inform_error *err);
 
+/**
+ * Compute the local active information of a ensemble of time series
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_local_active_info.
+ *
+ * @param[in] series the ensemble of time series
+ * @param[in] n      the number of initial conditions
+ * @param[in] m      the number of time steps in each time series
+ * @param[in] b      the base or number of distinct states at each time step
+ * @param[in] k      the history length used to calculate the active information
+ * @param[out] ai    the local active information
+ * @param[in,out] ws the workspace
+ * @param[out] err   an error structure
+ * @return a pointer to the local active information array
+ */
+EXPORT double *inform_local_active_info_ws(int const *series, size_t n,
+    size_t m, int b, size_t k, double *ai, inform_workspace *ws,
+    inform_error *err);
+
+/**
+ * Plan the workspace needed for the active information of an ensemble
+ * of `n` time series of length `m`, without allocating anything.
+ *
+ * @param[in] n    the number of initial conditions
+ * @param[in] m    the number of time steps in each time series
+ * @param[in] b    the base or number of distinct states at each time step
+ * @param[in] k    the history length used to calculate the active information
+ * @param[out] err an error structure
+ * @return the workspace plan
+ */
+EXPORT inform_workspace_plan inform_active_info_plan(size_t n, size_t m, int b,
+    size_t k, inform_error *err);
+
+/**
+ * Plan the workspace needed for the local active information of an ensemble
+ * of `n` time series of length `m`, without allocating anything.
+ *
+ * @param[in] n    the number of initial conditions
+ * @param[in] m    the number of time steps in each time series
+ * @param[in] b    the base or number of distinct states at each time step
+ * @param[in] k    the history length used to calculate the active information
+ * @param[out] err an error structure
+ * @return the workspace plan
+ */
+EXPORT inform_workspace_plan inform_local_active_info_plan(size_t n,
+    size_t m, int b, size_t k, inform_error *err);
+
+/**
+ * An incremental accumulator for the active information of an ensemble
+ *
+ * The accumulator keeps the joint and marginal histograms of the histories
+ * and futures observed so far, along with the history of the time series
+ * currently being pushed. New time steps (inform_active_info_acc_push) and
+ * new initial conditions (inform_active_info_acc_restart) cost time in
+ * proportion to the number of states pushed, and the current active
+ * information (inform_active_info_acc_value) is available in constant
+ * time. Pushing each time series of an ensemble in turn, restarting between
+ * them, gives the same value as inform_active_info.
+ *
+ * The histograms are dense, with 64-bit counters which can't overflow.
+ */
+typedef struct inform_active_info_acc
+{
+    /// the base of the time series
+    int b;
+    /// the history length
+    size_t k;
+    /// the joint distribution of histories and futures
+    inform_dist *states;
+    /// the distribution of histories
+    inform_dist *histories;
+    /// the distribution of futures
+    inform_dist *futures;
+    /// the last (up to) `k` states of the current time series, encoded
+    uint64_t history;
+    /// the number of states of the current time series seen, up to `k`
+    size_t seen;
+} inform_active_info_acc;
+
+/**
+ * Allocate an empty active information accumulator.
+ *
+ * @param[in] b    the base or number of distinct states at each time step
+ * @param[in] k    the history length used to calculate the active information
+ * @param[out] err an error structure
+ * @return the accumulator, or `NULL` if the arguments are invalid or the
+ *         allocation fails
+ */
+EXPORT inform_active_info_acc *inform_active_info_acc_alloc(int b, size_t k,
+    inform_error *err);
+/**
+ * Free an active information accumulator.
+ *
+ * @param[in] acc the accumulator
+ */
+EXPORT void inform_active_info_acc_free(inform_active_info_acc *acc);
+
+/**
+ * Append `m` time steps to the time series currently being accumulated.
+ *
+ * If any of the states are invalid, none of them are accumulated.
+ *
+ * @param[in,out] acc the accumulator
+ * @param[in] series  the new time steps
+ * @param[in] m       the number of new time steps
+ * @param[out] err    an error structure
+ */
+EXPORT void inform_active_info_acc_push(inform_active_info_acc *acc,
+    int const *series, size_t m, inform_error *err);
+/**
+ * Begin a new time series, i.e. a new initial condition, so that the states
+ * pushed next are not taken to follow those pushed before.
+ *
+ * @param[in,out] acc the accumulator
+ */
+EXPORT void inform_active_info_acc_restart(inform_active_info_acc *acc);
+/**
+ * Forget every observation, leaving the accumulator as it was allocated.
+ *
+ * @param[in,out] acc the accumulator
+ */
+EXPORT void inform_active_info_acc_clear(inform_active_info_acc *acc);
+/**
+ * Get the active information of everything accumulated so far.
+ *
+ * This function will return `NaN` if the accumulator is `NULL` or has yet
+ * to see a history followed by a future.
+ *
+ * @param[in] acc  the accumulator
+ * @param[out] err an error structure
+ * @return the active information
+ */
+EXPORT double inform_active_info_acc_value(inform_active_info_acc const *acc,
+    inform_error *err);
+
+/**
+ * Compute the active information of an ensemble of time series over a
+ * sliding window of `w` time steps
+ *
+ * The `j`-th value is the active information of the ensemble restricted to
+ * the time steps `[j, j + w)`, as inform_active_info would compute it, for
+ * each of the `m - w + 1` positions of the window. As the window slides,
+ * the observations which enter it are added to the histograms and those
+ * which leave it are removed, keeping their entropies current, so the whole
+ * trace costs time in proportion to `n * m` rather than `n * m * w`.
+ *
+ * @param[in] series the ensemble of time series
+ * @param[in] n      the number of initial conditions
+ * @param[in] m      the number of time steps in each time series
+ * @param[in] b      the base or number of distinct states at each time step
+ * @param[in] k      the history length used to calculate the active information
+ * @param[in] w      the number of time steps in the window, greater than `k`
+ *                   and no greater than `m`
+ * @param[out] ai    the active information at each position of the window
+ * @param[out] err   an error structure
+ * @return a pointer to the array of active information
+ */
+EXPORT double *inform_windowed_active_info(int const *series, size_t n,
+    size_t m, int b, size_t k, size_t w, double *ai, inform_error *err);
+
+/**
+ * Compute the active information of an ensemble of time series for every history
+ * length from 1 to `K`
+ *
+ * The `k`-th value, `ai[k - 1]`, is what inform_active_info would compute with a
+ * history length of `k`. The data are scanned only once, for the longest
+ * history, and the histograms of the shorter histories are folded out of
+ * it, so the whole curve costs little more than its last point. When the
+ * support of the longest history is too large for a dense histogram, each
+ * history length is computed on its own.
+ *
+ * @param[in] series the ensemble of time series
+ * @param[in] n      the number of initial conditions
+ * @param[in] m      the number of time steps in each time series
+ * @param[in] b      the base or number of distinct states at each time step
+ * @param[in] K      the longest history length
+ * @param[out] ai    the active information for each history length
+ * @param[out] err   an error structure
+ * @return a pointer to the array of active informations
+ */
+EXPORT double *inform_active_info_sweep(int const *series, size_t n, size_t m,
+    int b, size_t K, double *ai, inform_error *err);
+
 #ifdef __cplusplus
 }
 #endif
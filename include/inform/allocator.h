@@ -0,0 +1,80 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/export.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * A set of memory allocation hooks
+ *
+ * Every allocation the library makes, from the histograms of a distribution
+ * to the scratch space of the measures and the arrays they return, goes
+ * through the installed allocator. The `alignment` passed to each hook is a
+ * power of two; memory returned by `alloc`, `zalloc` and `realloc` must be
+ * aligned to at least that boundary. The same alignment is passed to `free`
+ * and `realloc` as was used to allocate the block, along with its size, so
+ * that arenas and accounting allocators needn't record block sizes.
+ *
+ * The `alloc` and `free` hooks are required. If `zalloc` is `NULL`, memory
+ * from `alloc` is zeroed by the library. If `realloc` is `NULL`, the library
+ * allocates a new block and copies the contents over. Each hook receives the
+ * allocator's `context` as its last argument.
+ */
+typedef struct inform_allocator
+{
+    /// allocate `size` bytes
+    void *(*alloc)(size_t size, size_t alignment, void *context);
+    /// allocate `size` zeroed bytes
+    void *(*zalloc)(size_t size, size_t alignment, void *context);
+    /// resize a block of `old` bytes to `size` bytes, preserving its contents
+    void *(*realloc)(void *ptr, size_t old, size_t size, size_t alignment,
+        void *context);
+    /// release a block of `size` bytes; `ptr` is never `NULL`, and `size` is
+    /// `0` only for arrays returned by the library which the caller releases
+    /// with inform_free, as their size isn't known
+    void (*free)(void *ptr, size_t size, size_t alignment, void *context);
+    /// an opaque pointer passed to each of the hooks
+    void *context;
+} inform_allocator;
+
+/**
+ * Install the allocator used for all subsequent allocations.
+ *
+ * Passing `NULL`, or an allocator without an `alloc` or `free` hook,
+ * restores the default allocator which is built on the C library's
+ * `malloc` and `free`.
+ *
+ * The allocator must not be changed while any memory it allocated is still
+ * in use by the library, nor while any call into the library is running.
+ *
+ * @param[in] allocator the allocator to install
+ */
+EXPORT void inform_set_allocator(inform_allocator const *allocator);
+
+/**
+ * Get the allocator which is currently installed.
+ *
+ * @return the allocator
+ */
+EXPORT inform_allocator inform_get_allocator(void);
+
+/**
+ * Free an array returned by the library, e.g. by inform_local_active_info.
+ *
+ * With the default allocator, this is the same as calling `free`. If `ptr`
+ * is `NULL`, nothing happens.
+ *
+ * @param[in] ptr the array to free
+ */
+EXPORT void inform_free(void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
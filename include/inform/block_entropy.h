@@ -4,6 +4,7 @@
 #pragma once
 
 #include <inform/error.h>
+#include <inform/workspace.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -24,6 +25,24 @@ extern "C"
 EXPORT double inform_block_entropy(int const *series, size_t n, size_t m, int b,
     size_t k, inform_error *err);
 
+/**
+ * Compute the block entropy of an ensemble of time series
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_block_entropy.
+ *
+ * @param[in] series the ensemble of time series
+ * @param[in] n      the number of initial conditions
+ * @param[in] m      the number of time steps in each time series
+ * @param[in] b      the base or number of distinct states at each time step
+ * @param[in] k      the history length used to calculate the active information
+ * @param[in,out] ws the workspace
+ * @param[out] err   an error structure
+ * @return the block entropy for the ensemble
+ */
+EXPORT double inform_block_entropy_ws(int const *series, size_t n, size_t m,
+    int b, size_t k, inform_workspace *ws, inform_error *err);
+
 /**
  * Compute the local block entropy of a ensemble of time series
  *
@@ -39,6 +58,78 @@ EXPORT double inform_block_entropy(int const *series, size_t n, size_t m, int b,
 EXPORT double *inform_local_block_entropy(int const *series, size_t n, size_t m,
     int b, size_t k, double *ent, inform_error *err);
 
+/**
+ * Compute the local block entropy of a ensemble of time series
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_local_block_entropy.
+ *
+ * @param[in] series the ensemble of time series
+ * @param[in] n      the number of initial conditions
+ * @param[in] m      the number of time steps in each time series
+ * @param[in] b      the base or number of distinct states at each time step
+ * @param[in] k      the history length used to calculate the active information
+ * @param[out] ent   the local entropy
+ * @param[in,out] ws the workspace
+ * @param[out] err   an error structure
+ * @return a pointer to the local block entropy array
+ */
+EXPORT double *inform_local_block_entropy_ws(int const *series, size_t n,
+    size_t m, int b, size_t k, double *ent, inform_workspace *ws,
+    inform_error *err);
+
+/**
+ * Plan the workspace needed for the block entropy of an ensemble
+ * of `n` time series of length `m`, without allocating anything.
+ *
+ * @param[in] n    the number of initial conditions
+ * @param[in] m    the number of time steps in each time series
+ * @param[in] b    the base or number of distinct states at each time step
+ * @param[in] k    the block length
+ * @param[out] err an error structure
+ * @return the workspace plan
+ */
+EXPORT inform_workspace_plan inform_block_entropy_plan(size_t n,
+    size_t m, int b, size_t k, inform_error *err);
+
+/**
+ * Plan the workspace needed for the local block entropy of an ensemble
+ * of `n` time series of length `m`, without allocating anything.
+ *
+ * @param[in] n    the number of initial conditions
+ * @param[in] m    the number of time steps in each time series
+ * @param[in] b    the base or number of distinct states at each time step
+ * @param[in] k    the block length
+ * @param[out] err an error structure
+ * @return the workspace plan
+ */
+EXPORT inform_workspace_plan inform_local_block_entropy_plan(size_t n,
+    size_t m, int b, size_t k, inform_error *err);
+
+/**
+ * Compute the block entropy of an ensemble of time series for every block
+ * length from 1 to `K`
+ *
+ * The `k`-th value, `be[k - 1]`, is what inform_block_entropy would compute
+ * with a block length of `k`. Rather than a histogram over the `b^k`
+ * possible blocks, the curve is read off of a suffix array of the ensemble:
+ * the occurrences of each block of length `k` form a run of suffixes which
+ * share a prefix of at least `k` states. Building the suffix array takes
+ * time of order `N log N` and memory of order `N`, where `N = n * m`, no
+ * matter how long the blocks, so `K` is only limited by `m`.
+ *
+ * @param[in] series the ensemble of time series
+ * @param[in] n      the number of initial conditions
+ * @param[in] m      the number of time steps in each time series
+ * @param[in] b      the base or number of distinct states at each time step
+ * @param[in] K      the longest block length, less than `m`
+ * @param[out] be    the block entropy for each block length
+ * @param[out] err   an error structure
+ * @return a pointer to the array of block entropies
+ */
+EXPORT double *inform_block_entropy_sweep(int const *series, size_t n,
+    size_t m, int b, size_t K, double *be, inform_error *err);
+
 #ifdef __cplusplus
 }
 #endif
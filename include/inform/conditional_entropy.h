@@ -4,6 +4,7 @@
 #pragma once
 
 #include <inform/error.h>
+#include <inform/workspace.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -17,6 +18,17 @@ extern "C"
 EXPORT double inform_conditional_entropy(int const *xs, int const *ys,
     size_t n, int bx, int by, double b, inform_error *err);
 
+/**
+ * Compute the conditional entropy between two timeseries, using the
+ * first as the condition.
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_conditional_entropy.
+ */
+EXPORT double inform_conditional_entropy_ws(int const *xs, int const *ys,
+    size_t n, int bx, int by, double b, inform_workspace *ws,
+    inform_error *err);
+
 /**
  * Compute the local conditional entropy between two timeseries, using the
  * first as the condition.
@@ -24,6 +36,31 @@ EXPORT double inform_conditional_entropy(int const *xs, int const *ys,
 EXPORT double *inform_local_conditional_entropy(int const *xs, int const *ys,
     size_t n, int bx, int by, double b, double *mi, inform_error *err);
 
+/**
+ * Compute the local conditional entropy between two timeseries, using the
+ * first as the condition.
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_local_conditional_entropy.
+ */
+EXPORT double *inform_local_conditional_entropy_ws(int const *xs, int const *ys,
+    size_t n, int bx, int by, double b, double *mi, inform_workspace *ws,
+    inform_error *err);
+
+/**
+ * Plan the workspace needed to compute the conditional entropy between two
+ * timeseries of length `n`, without allocating anything.
+ */
+EXPORT inform_workspace_plan inform_conditional_entropy_plan(size_t n,
+    int bx, int by, inform_error *err);
+
+/**
+ * Plan the workspace needed to compute the local conditional entropy between two
+ * timeseries of length `n`, without allocating anything.
+ */
+EXPORT inform_workspace_plan inform_local_conditional_entropy_plan(size_t n,
+    int bx, int by, inform_error *err);
+
 #ifdef __cplusplus
 }
 #endif
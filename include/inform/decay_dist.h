@@ -0,0 +1,153 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/export.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * An exponentially decaying distribution of observed events
+ *
+ * Rather than counting every observation equally, a decaying distribution
+ * weighs each observation by `decay^a` where `a` is the number of
+ * observations made since, so that recent events dominate the distribution
+ * of a drifting stream. A decay of `2^(-1/h)` halves the weight of an
+ * observation every `h` observations; a decay of one weighs every
+ * observation equally.
+ *
+ * Rather than scaling every weight down with each observation, the weights
+ * are stored relative to a global scale which grows with each observation,
+ * and every stored weight is only rescaled once the scale becomes large.
+ * Each observation thus costs amortized constant time, and the memory used
+ * is proportional to the size of the support.
+ *
+ * The weight of the event `i` is `weights[i] / unit`, and the total weight
+ * of all events is `total / unit`.
+ */
+typedef struct inform_decay_distribution
+{
+    /// the scaled weight of each event
+    double *weights;
+    /// the size of the support
+    size_t size;
+    /// the factor by which every weight decays with each observation
+    double decay;
+    /// the scaled weight of the next observation
+    double unit;
+    /// the scaled total weight of all events
+    double total;
+} inform_decay_dist;
+
+/**
+ * Allocate an empty decaying distribution with a support of size `n`.
+ *
+ * The allocation returns `NULL` if `n` is zero, the decay is not in the
+ * interval `(0, 1]`, or the memory allocation fails for whatever reason.
+ *
+ * @param[in] n     the number of distinct events that could be observed
+ * @param[in] decay the factor by which every weight decays per observation
+ * @return the decaying distribution
+ */
+EXPORT inform_decay_dist *inform_decay_dist_alloc(size_t n, double decay);
+/**
+ * Free all dynamically allocated memory associated with a decaying
+ * distribution.
+ *
+ * @param[in] dist the distribution to free
+ */
+EXPORT void inform_decay_dist_free(inform_decay_dist *dist);
+
+/**
+ * Get the size of the distribution's support.
+ *
+ * If the distribution is `NULL`, then a support of `0` is returned.
+ *
+ * @param[in] dist the distribution
+ * @return the size of the distribution's support
+ */
+EXPORT size_t inform_decay_dist_size(inform_decay_dist const *dist);
+/**
+ * Get the total weight of the observations made so far.
+ *
+ * If the distribution is `NULL`, then `0` is returned.
+ *
+ * @param[in] dist the distribution
+ * @return the total weight of the observations
+ */
+EXPORT double inform_decay_dist_weight(inform_decay_dist const *dist);
+/**
+ * Determine whether or not the distribution is valid.
+ *
+ * A decaying distribution is valid if it is non-`NULL` and at least one
+ * observation has been made.
+ *
+ * @param[in] dist the distribution
+ * @return the validity of the distribution
+ */
+EXPORT bool inform_decay_dist_is_valid(inform_decay_dist const *dist);
+
+/**
+ * Get the weight of a given event.
+ *
+ * If the distribution is `NULL` or the `event` is not in the support,
+ * `0` is returned.
+ *
+ * @param[in] dist  the distribution
+ * @param[in] event the event in question
+ * @return the weight of the event
+ */
+EXPORT double inform_decay_dist_get(inform_decay_dist const *dist, size_t event);
+/**
+ * Observe an event, decaying the weight of every earlier observation.
+ *
+ * If the distribution is `NULL` or the `event` is not in the support,
+ * nothing happens and `0` is returned.
+ *
+ * @param[in,out] dist the distribution
+ * @param[in] event    the event observed
+ * @return the new weight of the event
+ */
+EXPORT double inform_decay_dist_tick(inform_decay_dist *dist, size_t event);
+/**
+ * Forget every observation.
+ *
+ * @param[in,out] dist the distribution
+ */
+EXPORT void inform_decay_dist_clear(inform_decay_dist *dist);
+
+/**
+ * Extract the probability of an event, i.e. its share of the total weight.
+ *
+ * If the distribution is `NULL`, no observations have yet been made, or the
+ * event is not in the support, then a zero probability is returned.
+ *
+ * @param[in] dist  the distribution
+ * @param[in] event the event in question
+ * @return the probability of the event
+ */
+EXPORT double inform_decay_dist_prob(inform_decay_dist const *dist, size_t event);
+/**
+ * Dump the probabilities of all events to an array.
+ *
+ * If the distribution is `NULL`, the array is `NULL` or `n` is not equal to
+ * the size of the support, `0` is returned.
+ *
+ * @param[in] dist   the distribution
+ * @param[out] probs the preallocated array of probabilities
+ * @param[in] n      the size of the preallocated array
+ * @return the number of probabilities written to the array
+ */
+EXPORT size_t inform_decay_dist_dump(inform_decay_dist const *dist,
+    double *probs, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
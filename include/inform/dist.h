@@ -13,6 +13,21 @@ extern "C"
 {
 #endif
 
+/**
+ * The width of the counters of a distribution
+ */
+typedef enum inform_counter_width
+{
+    /// 32-bit counters, which wrap on overflow
+    INFORM_COUNTER_32 = 0,
+    /// 8-bit counters, promoted to a wider type as needed
+    INFORM_COUNTER_8,
+    /// 16-bit counters, promoted to a wider type as needed
+    INFORM_COUNTER_16,
+    /// 64-bit counters
+    INFORM_COUNTER_64,
+} inform_counter_width;
+
 /**
  * A distribution of observed event frequencies
  *
@@ -23,22 +38,49 @@ extern "C"
  * A distribution can be allocated with a set number of observable events
  * (inform_dist_alloc), resized (inform_dist_realloc), copied
  * (inform_dist_copy) or duplicated (inform_dist_dup). Once the distribution
- * has served its purpose, it can be freed (inform_dist_free).
+ * has served its purpose, it can be freed (inform_dist_free). Distributions
+ * over the same support can be combined (inform_dist_merge and
+ * inform_dist_subtract) and shipped between processes
+ * (inform_dist_serialize and inform_dist_deserialize). A joint distribution
+ * can be reduced to its marginals (inform_dist_marginal), and states can be
+ * merged into coarser ones (inform_dist_coarse_grain), without revisiting
+ * the data it was built from.
  *
  * The distribution is, roughly, a histogram with finite support. The events
  * are assumed to be mapped to the dense set of integers @f {0, 1, ..., N-1} @f
  * where @f N @f is the number of observable events. The number of observable
  * events can be extracted with inform_dist_size.
  *
- * Events can be observed one at a time (inform_dist_tick) or in batches
- * (inform_dist_set). The occurance frequency of a given event can be
- * obtained (inform_dist_get) as can the total number of observations
- * (inform_dist_counts).
+ * Events can be observed one at a time (inform_dist_tick), many at a time
+ * (inform_dist_tick_many) or in batches (inform_dist_set). The occurance
+ * frequency of a given event can be obtained (inform_dist_get) as can the
+ * total number of observations (inform_dist_counts).
  *
  * Once the distribution populated, the probabilities can be extracted in either
  * element-by-element (inform_dist_prob) or dumped to a dynamically allocated
  * array (inform_dist_dump).
  *
+ * Each event's number of occurances is held in a counter of a selectable
+ * width (inform_dist_alloc_width). By default the counters are 32 bits wide,
+ * so that `histogram` can be accessed directly, and wrap on overflow. The
+ * counters can instead be 64 bits wide, or start out 8 or 16 bits wide and
+ * be promoted to a wider type whenever a count would overflow, so that a
+ * histogram whose counts are mostly small occupies less memory.
+ *
+ * A distribution can also keep a list of the events it has observed
+ * (inform_dist_track_nonzero), so that the entropy of a distribution which
+ * has only visited a small fraction of a large support, and clearing it for
+ * reuse (inform_dist_clear), costs time proportional to the number of
+ * events visited rather than to the size of the support.
+ *
+ * Code which allocates and frees many short-lived distributions can take
+ * them from a pool (inform_dist_pool_get) instead, which recycles their
+ * memory rather than returning it to the heap.
+ *
+ * For streaming use, a distribution can keep a running sum of `c log2(c)`
+ * over its counts (inform_dist_track_entropy), so that inform_shannon
+ * computes its entropy in constant time no matter the size of the support.
+ *
  * Whenever the size of the support or the number of observed events is zero,
  * the distrubution is considered invalid meaning that you can't trust any
  * probabilities extracted from it. One can use inform_dist_is_valid to assess
@@ -46,12 +88,38 @@ extern "C"
  */
 typedef struct inform_distribution
 {
-    /// the histogram or array of observation frequencies
-    uint32_t *histogram;
+    union
+    {
+        /// the histogram or array of observation frequencies, valid only when
+        /// the counters are 32 bits wide
+        uint32_t *histogram;
+        /// the counters, of whatever width
+        void *counters;
+    };
     /// the size of the support
     size_t size;
     /// the number of observations made so far
     uint64_t counts;
+    /// the current width of the counters
+    inform_counter_width width;
+    /// whether the counters are promoted when they would overflow
+    bool adaptive;
+    /// the events with nonzero counts, in no particular order, or `NULL` if
+    /// they are not being tracked
+    size_t *nonzero;
+    /// the number of events with nonzero counts, if they are being tracked
+    size_t nonzero_size;
+    /// the number of events the `nonzero` array can hold
+    size_t nonzero_capacity;
+    /// whether a running sum of `c log2(c)` over the counts is kept
+    bool track_entropy;
+    /// the running sum of `c log2(c)` over the counts
+    double clogc;
+    /// the accumulated rounding error of the running sum
+    double clogc_error;
+    /// whether the distribution shares a block with its counters, having been
+    /// taken from a pool (inform_dist_pool_get)
+    bool pooled;
 } inform_dist;
 
 /**
@@ -60,12 +128,30 @@ typedef struct inform_distribution
  * The allocation will fail and return `NULL` if either `n == 0` or
  * the memory allocation fails for whatever reason.
  *
- * Immediately following allocation, the distribution is invalid.
+ * Immediately following allocation, the distribution is invalid. The
+ * histogram is aligned to a 64-byte boundary, and must only ever be released
+ * via inform_dist_free.
  *
  * @param[in] n the number of distinct events that could be observed
  * @return the distribution
  */
 EXPORT inform_dist* inform_dist_alloc(size_t n);
+/**
+ * Allocate a distribution with a specified support size and counter width.
+ *
+ * Distributions allocated with INFORM_COUNTER_8 or INFORM_COUNTER_16
+ * counters promote all of their counters to the next wider type, up to
+ * 64 bits, whenever a count would overflow. Allocating with
+ * INFORM_COUNTER_32 is equivalent to inform_dist_alloc.
+ *
+ * The allocation will fail and return `NULL` if `n == 0`, the width is
+ * unknown, or the memory allocation fails for whatever reason.
+ *
+ * @param[in] n     the number of distinct events that could be observed
+ * @param[in] width the initial width of the counters
+ * @return the distribution
+ */
+EXPORT inform_dist* inform_dist_alloc_width(size_t n, inform_counter_width width);
 /**
  * Resize the distribution to have new support.
  *
@@ -133,6 +219,72 @@ EXPORT inform_dist* inform_dist_create(uint32_t const *data, size_t n);
  * @param[in] dist the distribution to free
  */
 EXPORT void inform_dist_free(inform_dist *dist);
+/**
+ * Start or stop tracking which events have nonzero counts.
+ *
+ * While tracking, the distribution keeps a list of the events with nonzero
+ * counts, which is updated as events are observed. The entropy of the
+ * distribution (inform_shannon and inform_shannon_re), inform_dist_dump and
+ * inform_dist_clear then only visit those events rather than the entire
+ * support. Observing a new event costs an amortized constant time, but
+ * setting an event's count to zero costs time proportional to the number of
+ * nonzero events.
+ *
+ * The entropy of a tracked distribution is summed in a different order than
+ * that of an untracked one, so the two may differ in the last few bits.
+ *
+ * If the distribution is `NULL`, or the list can't be allocated, `NULL` is
+ * returned and the distribution is left as it was.
+ *
+ * @param[in,out] dist the distribution
+ * @param[in] enable   whether to track the nonzero events
+ * @return the distribution
+ */
+EXPORT inform_dist* inform_dist_track_nonzero(inform_dist *dist, bool enable);
+/**
+ * Get the events with nonzero counts of a distribution which is tracking
+ * them, in no particular order.
+ *
+ * If the distribution is `NULL` or isn't tracking its nonzero events, `NULL`
+ * is returned.
+ *
+ * @param[in] dist the distribution
+ * @param[out] n   the number of events with nonzero counts
+ * @return the events with nonzero counts
+ *
+ * @see inform_dist_track_nonzero
+ */
+EXPORT size_t const *inform_dist_nonzero(inform_dist const *dist, size_t *n);
+/**
+ * Start or stop keeping the entropy of a distribution current.
+ *
+ * Since the entropy of a distribution with counts `c` and `N` observations
+ * is `H = log2(N) - sum(c log2(c))/N`, a distribution can keep the sum up to
+ * date in constant time whenever an event's count changes. While it does,
+ * inform_shannon takes constant time. Each observation costs a little more
+ * than it otherwise would, and merging, subtracting or shrinking the
+ * distribution recomputes the sum from scratch.
+ *
+ * The sum is compensated for rounding error, so it stays within a few units
+ * in the last place of the sum computed from scratch by inform_shannon, even
+ * over very long streams.
+ *
+ * If the distribution is `NULL`, `NULL` is returned.
+ *
+ * @param[in,out] dist the distribution
+ * @param[in] enable   whether to keep the entropy current
+ * @return the distribution
+ */
+EXPORT inform_dist* inform_dist_track_entropy(inform_dist *dist, bool enable);
+/**
+ * Reset the counts of every event to zero, keeping the support, the width
+ * of the counters and whether the nonzero events are tracked.
+ *
+ * If the distribution tracks its nonzero events, only those are visited.
+ *
+ * @param[in,out] dist the distribution
+ */
+EXPORT void inform_dist_clear(inform_dist *dist);
 
 /**
  * Get the size of the distribution's support.
@@ -169,7 +321,8 @@ EXPORT bool inform_dist_is_valid(inform_dist const *dist);
  * Get the number of occurances of a given event.
  *
  * If the distribution is `NULL` or the `event` is not in the support,
- * `0` is returned.
+ * `0` is returned. Counts too large for 32 bits saturate at `UINT32_MAX`;
+ * use inform_dist_get64 to get them in full.
  *
  * @param[in] dist  the distribution
  * @param[in] event the event in question
@@ -178,6 +331,29 @@ EXPORT bool inform_dist_is_valid(inform_dist const *dist);
  * @see inform_dist_set
  */
 EXPORT uint32_t inform_dist_get(inform_dist const *dist, size_t event);
+/**
+ * Get the number of occurances of a given event as a 64-bit integer.
+ *
+ * Unlike inform_dist_get, which saturates at `UINT32_MAX`, this returns
+ * the full count held by counters of any width.
+ *
+ * If the distribution is `NULL` or the `event` is not in the support,
+ * `0` is returned.
+ *
+ * @param[in] dist  the distribution
+ * @param[in] event the event in question
+ * @return the number of observed occurances of the event
+ */
+EXPORT uint64_t inform_dist_get64(inform_dist const *dist, size_t event);
+/**
+ * Get the current width of a distribution's counters.
+ *
+ * If the distribution is `NULL`, INFORM_COUNTER_32 is returned.
+ *
+ * @param[in] dist the distribution
+ * @return the width of the counters
+ */
+EXPORT inform_counter_width inform_dist_width(inform_dist const *dist);
 /**
  * Set the number of occurances of a given event.
  *
@@ -186,8 +362,9 @@ EXPORT uint32_t inform_dist_get(inform_dist const *dist, size_t event);
  * that this function can be used to invalidate the distribution by changing
  * all of the event frequencies to zero.
  *
- * If the event is not in the support or the distribution is `NULL`, then
- * nothing happens and zero is returned.
+ * If the event is not in the support, the distribution is `NULL`, or the
+ * counters would have to be promoted and the allocation fails, then nothing
+ * happens and zero is returned.
  *
  * @param[in,out] dist  the distribution
  * @param[in] event     the event in question
@@ -205,8 +382,10 @@ EXPORT uint32_t inform_dist_set(inform_dist *dist, size_t event, uint32_t x);
  * the number of occurances of a given event. This is useful for when
  * iteratively observing events.
  *
- * If the event is not in the support or the distribution is `NULL`, then
- * nothing happens and zero is returned.
+ * If the event is not in the support, the distribution is `NULL`, or the
+ * counters would have to be promoted and the allocation fails, then nothing
+ * happens and zero is returned. A count too large for 32 bits is returned
+ * as `UINT32_MAX`.
  *
  * @param[in,out] dist the distribution
  * @param[in] event    the event in question
@@ -215,6 +394,46 @@ EXPORT uint32_t inform_dist_set(inform_dist *dist, size_t event, uint32_t x);
  * @see inform_dist_set
  */
 EXPORT uint32_t inform_dist_tick(inform_dist *dist, size_t event);
+/**
+ * Remove an observation of a given event.
+ *
+ * This undoes an earlier inform_dist_tick, decrementing the number of
+ * occurances of the event and the total number of observations, so that a
+ * distribution can follow a window of observations in constant time per
+ * observation (see inform_window_dist).
+ *
+ * If the event is not in the support, the distribution is `NULL`, or the
+ * event has not been observed, then nothing happens and zero is returned.
+ *
+ * @param[in,out] dist the distribution
+ * @param[in] event    the event in question
+ * @return the new number of occurances of the event
+ *
+ * @see inform_dist_tick
+ */
+EXPORT uint32_t inform_dist_untick(inform_dist *dist, size_t event);
+
+/**
+ * Increment the number of observations of each of an array of events.
+ *
+ * This is equivalent to calling inform_dist_tick on each event in turn, but
+ * the events are validated once and counted without the overhead of a call
+ * per event. Streams in which a few events repeat often are counted into
+ * several interleaved histograms which are summed at the end, so that the
+ * increments of a repeated event don't wait on one another.
+ *
+ * If the distribution or the events are `NULL`, or any of the events is
+ * not in the support, then nothing happens and zero is returned.
+ *
+ * @param[in,out] dist the distribution
+ * @param[in] events   the events to observe
+ * @param[in] n        the number of events
+ * @return the number of events observed
+ *
+ * @see inform_dist_tick
+ */
+EXPORT size_t inform_dist_tick_many(inform_dist *dist, size_t const *events,
+    size_t n);
 
 /**
  * Extact the probability of an event.
@@ -251,6 +470,158 @@ EXPORT double inform_dist_prob(inform_dist const *dist, size_t event);
  */
 EXPORT size_t inform_dist_dump(inform_dist const *dist, double *probs, size_t n);
 
+/**
+ * Add the observations of one distribution to another.
+ *
+ * This combines partial histograms, e.g. those accumulated by separate
+ * workers over shards of an ensemble, at a cost proportional to the size of
+ * the support rather than to the number of observations.
+ *
+ * If either distribution is `NULL`, their supports differ in size, or any
+ * event's number of occurances would overflow, then the destination is left
+ * untouched and `NULL` is returned.
+ *
+ * @param[in] src      the distribution to add
+ * @param[in,out] dest the distribution to add it to
+ * @return a pointer to the destination
+ *
+ * @see inform_dist_subtract
+ */
+EXPORT inform_dist* inform_dist_merge(inform_dist const *src, inform_dist *dest);
+/**
+ * Remove the observations of one distribution from another.
+ *
+ * This undoes inform_dist_merge. If either distribution is `NULL`, their
+ * supports differ in size, or any event has been observed more often in the
+ * source than in the destination, then the destination is left untouched
+ * and `NULL` is returned.
+ *
+ * @param[in] src      the distribution to remove
+ * @param[in,out] dest the distribution to remove it from
+ * @return a pointer to the destination
+ *
+ * @see inform_dist_merge
+ */
+EXPORT inform_dist* inform_dist_subtract(inform_dist const *src, inform_dist *dest);
+
+/**
+ * Compute a marginal of a joint distribution.
+ *
+ * The events of the joint distribution are taken to be mixed-radix encoded
+ * states of `rank` variables, the first being the most significant, where
+ * the `i`-th variable takes `shape[i]` values. For example, the joint event
+ * `x * shape[1] + y` of two variables x and y has `shape = {bx, by}`. The
+ * marginal over the variables listed in `axes`, in that order, is the
+ * distribution of the events encoded in the same way from only those
+ * variables, e.g. `axes = {0}` gives the row sums and `axes = {1}` the
+ * column sums of a two-variable joint distribution.
+ *
+ * The marginal is computed in a single pass over the support of the joint
+ * distribution, or over only its nonzero events if they are tracked.
+ *
+ * If `marginal` is `NULL`, a new distribution with 32-bit counters (64-bit
+ * if the joint distribution has made more than `UINT32_MAX` observations)
+ * is allocated. Otherwise its support must be the product of the sizes of
+ * the variables kept, and its contents are replaced.
+ *
+ * If the joint distribution is `NULL`, the product of the shape is not the
+ * size of its support, an axis is repeated or out of range, the marginal's
+ * support is the wrong size or can't hold the counts, or an allocation
+ * fails, then `NULL` is returned and `marginal` is left untouched.
+ *
+ * @param[in] joint        the joint distribution
+ * @param[in] shape        the number of values each variable takes
+ * @param[in] rank         the number of variables
+ * @param[in] axes         the variables to keep
+ * @param[in] naxes        the number of variables to keep
+ * @param[in,out] marginal the distribution to store the marginal in, or `NULL`
+ * @return the marginal distribution
+ */
+EXPORT inform_dist* inform_dist_marginal(inform_dist const *joint,
+    size_t const *shape, size_t rank, size_t const *axes, size_t naxes,
+    inform_dist *marginal);
+/**
+ * Coarse-grain a distribution by merging its events through a mapping.
+ *
+ * Each event `i` of the distribution is mapped to the event `map[i]` of a
+ * distribution over `n` events, whose counts are then the sums of the counts
+ * of the events mapped to them. This is done in a single pass over the
+ * support of the distribution, or over only its nonzero events if they are
+ * tracked.
+ *
+ * If `dest` is `NULL`, a new distribution is allocated just as
+ * inform_dist_marginal does. Otherwise its support must have size `n`, and
+ * its contents are replaced.
+ *
+ * If the distribution or map is `NULL`, `n` is zero, an event is mapped
+ * outside of `[0, n)`, the destination's support is the wrong size or
+ * can't hold the counts, or an allocation fails, then `NULL` is returned and
+ * `dest` is left untouched.
+ *
+ * @param[in] dist     the distribution to coarse-grain
+ * @param[in] map      the coarse event of each event of the distribution
+ * @param[in] n        the number of coarse events
+ * @param[in,out] dest the distribution to store the result in, or `NULL`
+ * @return the coarse-grained distribution
+ */
+EXPORT inform_dist* inform_dist_coarse_grain(inform_dist const *dist,
+    size_t const *map, size_t n, inform_dist *dest);
+
+/**
+ * Get the number of bytes needed to serialize a distribution.
+ *
+ * If the distribution is `NULL`, then `0` is returned.
+ *
+ * @param[in] dist the distribution
+ * @return the size of the serialized distribution
+ *
+ * @see inform_dist_serialize
+ */
+EXPORT size_t inform_dist_serialized_size(inform_dist const *dist);
+/**
+ * Serialize a distribution to a compact, portable byte string.
+ *
+ * The serialized form begins with the magic bytes `IFDS` and a format
+ * version, followed by the width and adaptivity of the counters, whether
+ * the nonzero events and entropy are tracked, the size of the support, the
+ * number of observations and the histogram. Integers are stored as
+ * little-endian base-128 varints, and a histogram with mostly empty bins is
+ * stored as the gaps between, and counts of, its nonzero bins.
+ *
+ * If the distribution or the buffer are `NULL`, or the buffer is smaller
+ * than inform_dist_serialized_size, then nothing is written and `0` is
+ * returned.
+ *
+ * @param[in] dist    the distribution
+ * @param[out] buffer the buffer to write to
+ * @param[in] n       the size of the buffer in bytes
+ * @return the number of bytes written
+ *
+ * @see inform_dist_deserialize
+ */
+EXPORT size_t inform_dist_serialize(inform_dist const *dist, uint8_t *buffer,
+    size_t n);
+/**
+ * Reconstruct a distribution from the output of inform_dist_serialize.
+ *
+ * The buffer may hold more than one serialized distribution; if `read` is
+ * not `NULL`, the number of bytes consumed is stored in it. If the buffer
+ * is `NULL`, is truncated, is of an unknown version, or is otherwise
+ * malformed, or if the allocation fails, `NULL` is returned.
+ *
+ * A sparsely encoded distribution can claim an arbitrarily large support in
+ * a handful of bytes, so any support larger than `max_size` is rejected
+ * rather than allocated.
+ *
+ * @param[in] buffer   the serialized distribution
+ * @param[in] n        the size of the buffer in bytes
+ * @param[in] max_size the largest support to accept
+ * @param[out] read    the number of bytes read
+ * @return the new distribution
+ */
+EXPORT inform_dist* inform_dist_deserialize(uint8_t const *buffer, size_t n,
+    size_t max_size, size_t *read);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,112 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/dist.h>
+#include <inform/export.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * A pool of memory for short-lived distributions
+ *
+ * A distribution allocated with inform_dist_alloc takes two allocations, one
+ * for the structure and one for its counters, and freeing it takes two more.
+ * A distribution taken from a pool (inform_dist_pool_get) instead lives in a
+ * single aligned block along with its counters, and when it is put back
+ * (inform_dist_pool_put) its block is kept for the next distribution of a
+ * similar size. Code which builds and discards a distribution for each of
+ * millions of pairs of variables then only touches the heap while the pool
+ * is warming up.
+ *
+ * Blocks are grouped into size classes, each a power of two bytes, so a
+ * block may be up to twice as large as the distribution it holds. A pooled
+ * distribution is an ordinary distribution in every other respect; it can be
+ * resized, widened, or freed with inform_dist_free, in which case its block
+ * is returned to the heap rather than to the pool.
+ *
+ * A pool must not be used by two threads at the same time.
+ */
+typedef struct inform_dist_pool
+{
+    /// the free blocks of each size class, the blocks of class `k` being
+    /// `2^k` bytes
+    void *blocks[8 * sizeof(size_t)];
+    /// the number of bytes held by the free blocks
+    size_t cached;
+} inform_dist_pool;
+
+/**
+ * Allocate an empty pool.
+ *
+ * The allocation returns `NULL` if the memory allocation fails for whatever
+ * reason.
+ *
+ * @return the pool
+ */
+EXPORT inform_dist_pool *inform_dist_pool_alloc(void);
+/**
+ * Free a pool along with every block it holds.
+ *
+ * Distributions taken from the pool which have not been put back remain
+ * valid and must be freed with inform_dist_free.
+ *
+ * @param[in] pool the pool to free
+ */
+EXPORT void inform_dist_pool_free(inform_dist_pool *pool);
+
+/**
+ * Take a distribution with a specified support size and counter width from
+ * a pool.
+ *
+ * The distribution is exactly as inform_dist_alloc_width would have
+ * allocated it: its counters are zeroed and aligned to a 64-byte boundary.
+ * If the pool is `NULL`, the distribution is simply allocated with
+ * inform_dist_alloc_width.
+ *
+ * This function will return `NULL` if `n == 0`, the width is unknown, or
+ * the memory allocation fails for whatever reason.
+ *
+ * @param[in,out] pool the pool
+ * @param[in] n        the number of distinct events that could be observed
+ * @param[in] width    the initial width of the counters
+ * @return the distribution
+ */
+EXPORT inform_dist *inform_dist_pool_get(inform_dist_pool *pool, size_t n,
+    inform_counter_width width);
+/**
+ * Return a distribution to a pool.
+ *
+ * The distribution must not be used afterwards. A distribution which was not
+ * taken from a pool, or a `NULL` pool, is handled by inform_dist_free.
+ *
+ * @param[in,out] pool the pool
+ * @param[in] dist     the distribution
+ */
+EXPORT void inform_dist_pool_put(inform_dist_pool *pool, inform_dist *dist);
+
+/**
+ * Get the number of bytes held by the free blocks of a pool.
+ *
+ * If the pool is `NULL`, then `0` is returned.
+ *
+ * @param[in] pool the pool
+ * @return the number of bytes
+ */
+EXPORT size_t inform_dist_pool_cached(inform_dist_pool const *pool);
+/**
+ * Return every free block of a pool to the heap.
+ *
+ * @param[in,out] pool the pool
+ */
+EXPORT void inform_dist_pool_trim(inform_dist_pool *pool);
+
+#ifdef __cplusplus
+}
+#endif
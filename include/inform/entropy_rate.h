@@ -3,7 +3,9 @@
 // license that can be found in the LICENSE file.
 #pragma once
 
+#include <inform/dist.h>
 #include <inform/error.h>
+#include <inform/workspace.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -24,6 +26,24 @@ extern "C"
 EXPORT double inform_entropy_rate(int const *series, size_t n, size_t m, int b,
     size_t k, inform_error *err);
 
+/**
+ * Compute the entropy rate of an ensemble of time series
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_entropy_rate.
+ *
+ * @param[in] series the ensemble of time series
+ * @param[in] n      the number of initial conditions
+ * @param[in] m      the number of time steps in each time series
+ * @param[in] b      the base or number of distinct states at each time step
+ * @param[in] k      the history length used to calculate the entropy rate
+ * @param[in,out] ws the workspace
+ * @param[out] err   an error structure
+ * @return the entropy rate for the ensemble
+ */
+EXPORT double inform_entropy_rate_ws(int const *series, size_t n, size_t m,
+    int b, size_t k, inform_workspace *ws, inform_error *err);
+
 /**
  * Compute the local entropy rate of an ensemble of time series
  *
@@ -39,6 +59,164 @@ EXPORT double inform_entropy_rate(int const *series, size_t n, size_t m, int b,
 EXPORT double *inform_local_entropy_rate(int const *series, size_t n, size_t m, int b,
     size_t k, double *er, inform_error *err);
 
+/**
+ * Compute the local entropy rate of an ensemble of time series
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_local_entropy_rate.
+ *
+ * @param[in] series the ensemble of time series
+ * @param[in] n      the number of initial conditions
+ * @param[in] m      the number of time steps in each time series
+ * @param[in] b      the base or number of distinct states at each time step
+ * @param[in] k      the history length used to calculate the entropy rate
+ * @param[out] er    the local entropy rate of the ensemble
+ * @param[in,out] ws the workspace
+ * @param[out] err   an error structures
+ * @return a pointer to the local entropy rate array
+ */
+EXPORT double *inform_local_entropy_rate_ws(int const *series, size_t n,
+    size_t m, int b, size_t k, double *er, inform_workspace *ws,
+    inform_error *err);
+
+/**
+ * Plan the workspace needed for the entropy rate of an ensemble
+ * of `n` time series of length `m`, without allocating anything.
+ *
+ * @param[in] n    the number of initial conditions
+ * @param[in] m    the number of time steps in each time series
+ * @param[in] b    the base or number of distinct states at each time step
+ * @param[in] k    the history length used to calculate the entropy rate
+ * @param[out] err an error structure
+ * @return the workspace plan
+ */
+EXPORT inform_workspace_plan inform_entropy_rate_plan(size_t n, size_t m, int b,
+    size_t k, inform_error *err);
+
+/**
+ * Plan the workspace needed for the local entropy rate of an ensemble
+ * of `n` time series of length `m`, without allocating anything.
+ *
+ * @param[in] n    the number of initial conditions
+ * @param[in] m    the number of time steps in each time series
+ * @param[in] b    the base or number of distinct states at each time step
+ * @param[in] k    the history length used to calculate the entropy rate
+ * @param[out] err an error structure
+ * @return the workspace plan
+ */
+EXPORT inform_workspace_plan inform_local_entropy_rate_plan(size_t n,
+    size_t m, int b, size_t k, inform_error *err);
+
+/**
+ * An incremental accumulator for the entropy rate of an ensemble
+ *
+ * The accumulator keeps the histograms of the histories and of the
+ * history-future pairs observed so far, along with the history of the time
+ * series currently being pushed. New time steps
+ * (inform_entropy_rate_acc_push) and new initial conditions
+ * (inform_entropy_rate_acc_restart) cost time in proportion to the number
+ * of states pushed, and the current entropy rate
+ * (inform_entropy_rate_acc_value) is available in constant time. Pushing
+ * each time series of an ensemble in turn, restarting between them, gives
+ * the same value as inform_entropy_rate.
+ *
+ * The histograms are dense, with 64-bit counters which can't overflow.
+ */
+typedef struct inform_entropy_rate_acc
+{
+    /// the base of the time series
+    int b;
+    /// the history length
+    size_t k;
+    /// the joint distribution of histories and futures
+    inform_dist *states;
+    /// the distribution of histories
+    inform_dist *histories;
+    /// the last (up to) `k` states of the current time series, encoded
+    uint64_t history;
+    /// the number of states of the current time series seen, up to `k`
+    size_t seen;
+} inform_entropy_rate_acc;
+
+/**
+ * Allocate an empty entropy rate accumulator.
+ *
+ * @param[in] b    the base or number of distinct states at each time step
+ * @param[in] k    the history length used to calculate the entropy rate
+ * @param[out] err an error structure
+ * @return the accumulator, or `NULL` if the arguments are invalid or the
+ *         allocation fails
+ */
+EXPORT inform_entropy_rate_acc *inform_entropy_rate_acc_alloc(int b, size_t k,
+    inform_error *err);
+/**
+ * Free an entropy rate accumulator.
+ *
+ * @param[in] acc the accumulator
+ */
+EXPORT void inform_entropy_rate_acc_free(inform_entropy_rate_acc *acc);
+
+/**
+ * Append `m` time steps to the time series currently being accumulated.
+ *
+ * If any of the states are invalid, none of them are accumulated.
+ *
+ * @param[in,out] acc the accumulator
+ * @param[in] series  the new time steps
+ * @param[in] m       the number of new time steps
+ * @param[out] err    an error structure
+ */
+EXPORT void inform_entropy_rate_acc_push(inform_entropy_rate_acc *acc,
+    int const *series, size_t m, inform_error *err);
+/**
+ * Begin a new time series, i.e. a new initial condition, so that the states
+ * pushed next are not taken to follow those pushed before.
+ *
+ * @param[in,out] acc the accumulator
+ */
+EXPORT void inform_entropy_rate_acc_restart(inform_entropy_rate_acc *acc);
+/**
+ * Forget every observation, leaving the accumulator as it was allocated.
+ *
+ * @param[in,out] acc the accumulator
+ */
+EXPORT void inform_entropy_rate_acc_clear(inform_entropy_rate_acc *acc);
+/**
+ * Get the entropy rate of everything accumulated so far.
+ *
+ * This function will return `NaN` if the accumulator is `NULL` or has yet
+ * to see a history followed by a future.
+ *
+ * @param[in] acc  the accumulator
+ * @param[out] err an error structure
+ * @return the entropy rate
+ */
+EXPORT double inform_entropy_rate_acc_value(inform_entropy_rate_acc const *acc,
+    inform_error *err);
+
+/**
+ * Compute the entropy rate of an ensemble of time series for every history
+ * length from 1 to `K`
+ *
+ * The `k`-th value, `er[k - 1]`, is what inform_entropy_rate would compute with a
+ * history length of `k`. The data are scanned only once, for the longest
+ * history, and the histograms of the shorter histories are folded out of
+ * it, so the whole curve costs little more than its last point. When the
+ * support of the longest history is too large for a dense histogram, each
+ * history length is computed on its own.
+ *
+ * @param[in] series the ensemble of time series
+ * @param[in] n      the number of initial conditions
+ * @param[in] m      the number of time steps in each time series
+ * @param[in] b      the base or number of distinct states at each time step
+ * @param[in] K      the longest history length
+ * @param[out] er    the entropy rate for each history length
+ * @param[out] err   an error structure
+ * @return a pointer to the array of entropy rates
+ */
+EXPORT double *inform_entropy_rate_sweep(int const *series, size_t n, size_t m,
+    int b, size_t K, double *er, inform_error *err);
+
 #ifdef __cplusplus
 }
 #endif
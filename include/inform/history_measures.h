@@ -0,0 +1,97 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/error.h>
+#include <inform/export.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * The measures which can be computed together by inform_history_measures
+ *
+ * The flags may be combined with bitwise or.
+ */
+typedef enum inform_history_measure
+{
+    /// the block entropy of blocks of `k` states
+    INFORM_BLOCK_ENTROPY       = 1 << 0,
+    /// the entropy rate with history length `k`
+    INFORM_ENTROPY_RATE        = 1 << 1,
+    /// the active information with history length `k`
+    INFORM_ACTIVE_INFO         = 1 << 2,
+    /// the local block entropy of blocks of `k` states
+    INFORM_LOCAL_BLOCK_ENTROPY = 1 << 3,
+    /// the local entropy rate with history length `k`
+    INFORM_LOCAL_ENTROPY_RATE  = 1 << 4,
+    /// the local active information with history length `k`
+    INFORM_LOCAL_ACTIVE_INFO   = 1 << 5,
+} inform_history_measure;
+
+/**
+ * The results of inform_history_measures
+ *
+ * Each global measure which was not requested is set to `NaN`. Each local
+ * measure which was requested is written to the array provided, or to a
+ * newly allocated one, which must be freed with inform_free, if the array
+ * is `NULL`.
+ */
+typedef struct inform_history_results
+{
+    /// the block entropy
+    double block_entropy;
+    /// the entropy rate
+    double entropy_rate;
+    /// the active information
+    double active_info;
+    /// the local block entropy, of `n * (m - k + 1)` values
+    double *local_block_entropy;
+    /// the local entropy rate, of `n * (m - k)` values
+    double *local_entropy_rate;
+    /// the local active information, of `n * (m - k)` values
+    double *local_active_info;
+} inform_history_results;
+
+/**
+ * Compute any of the block entropy, entropy rate and active information of
+ * an ensemble of time series, global or local, from a single scan
+ *
+ * All three measures are derived from the counts of the histories of `k`
+ * states and the states which follow them, so rather than calling
+ * inform_block_entropy, inform_entropy_rate and inform_active_info, each of
+ * which validates the ensemble and counts those histories anew, this
+ * validates and counts once and derives every requested measure from the
+ * same histograms. The histograms are only shared when each of the separate
+ * calls would count densely too, so the results are exactly those of the
+ * separate calls. A request for block entropies alone accepts any `k` that
+ * inform_block_entropy does.
+ *
+ * If `measures` holds any flag other than those of inform_history_measure,
+ * `err` is set to INFORM_EARG.
+ *
+ * If any local measure can't be computed, any arrays allocated for the
+ * other local measures are freed, and `results` is left as it was given.
+ *
+ * @param[in] series      the ensemble of time series
+ * @param[in] n           the number of initial conditions
+ * @param[in] m           the number of time steps in each time series
+ * @param[in] b           the base or number of distinct states at each time step
+ * @param[in] k           the history, and block, length
+ * @param[in] measures    the requested measures, a combination of
+ *                        inform_history_measure flags
+ * @param[in,out] results the results
+ * @param[out] err        an error structure
+ * @return `results`, or `NULL` if the measures can't be computed
+ */
+EXPORT inform_history_results *inform_history_measures(int const *series,
+    size_t n, size_t m, int b, size_t k, int measures,
+    inform_history_results *results, inform_error *err);
+
+#ifdef __cplusplus
+}
+#endif
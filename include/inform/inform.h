@@ -3,9 +3,16 @@
 // license that can be found in the LICENSE file.
 #pragma once
 
+#include <inform/allocator.h>
+#include <inform/decay_dist.h>
 #include <inform/dist.h>
+#include <inform/dist_pool.h>
+#include <inform/sparse_dist.h>
+#include <inform/window_dist.h>
 #include <inform/error.h>
+#include <inform/threads.h>
 #include <inform/utilities.h>
+#include <inform/workspace.h>
 
 #include <inform/shannon.h>
 
@@ -14,4 +21,5 @@
 #include <inform/block_entropy.h>
 #include <inform/active_info.h>
 #include <inform/entropy_rate.h>
-#include <inform/transfer_entropy.h>
\ No newline at end of file
+#include <inform/transfer_entropy.h>
+#include <inform/history_measures.h>
\ No newline at end of file
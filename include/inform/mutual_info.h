@@ -4,6 +4,7 @@
 #pragma once
 
 #include <inform/error.h>
+#include <inform/workspace.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -16,12 +17,45 @@ extern "C"
 EXPORT double inform_mutual_info(int const *xs, int const *ys, size_t n,
     int bx, int by, double b, inform_error *err);
 
+/**
+ * Compute the mutual information between two timeseries
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_mutual_info.
+ */
+EXPORT double inform_mutual_info_ws(int const *xs, int const *ys, size_t n,
+    int bx, int by, double b, inform_workspace *ws, inform_error *err);
+
 /**
  * Compute the local mutual information between two timeseries
  */
 EXPORT double *inform_local_mutual_info(int const *xs, int const *ys, size_t n,
     int bx, int by, double b, double *mi, inform_error *err);
 
+/**
+ * Compute the local mutual information between two timeseries
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_local_mutual_info.
+ */
+EXPORT double *inform_local_mutual_info_ws(int const *xs, int const *ys,
+    size_t n, int bx, int by, double b, double *mi, inform_workspace *ws,
+    inform_error *err);
+
+/**
+ * Plan the workspace needed to compute the mutual information between two
+ * timeseries of length `n`, without allocating anything.
+ */
+EXPORT inform_workspace_plan inform_mutual_info_plan(size_t n, int bx,
+    int by, inform_error *err);
+
+/**
+ * Plan the workspace needed to compute the local mutual information between two
+ * timeseries of length `n`, without allocating anything.
+ */
+EXPORT inform_workspace_plan inform_local_mutual_info_plan(size_t n, int bx,
+    int by, inform_error *err);
+
 #ifdef __cplusplus
 }
 #endif
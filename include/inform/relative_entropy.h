@@ -4,6 +4,7 @@
 #pragma once
 
 #include <inform/error.h>
+#include <inform/workspace.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -17,6 +18,16 @@ extern "C"
 EXPORT double inform_relative_entropy(int const *xs, int const *ys, size_t n,
     int b, double base, inform_error *err);
 
+/**
+ * Compute the relative entropy between two timeseries, each considered as
+ * a timeseries of samples from two distributions.
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_relative_entropy.
+ */
+EXPORT double inform_relative_entropy_ws(int const *xs, int const *ys, size_t n,
+    int b, double base, inform_workspace *ws, inform_error *err);
+
 /**
  * Compute the pointwise relative entropy between two timeseries, each
  * considered as a timeseries of samples from two distributions.
@@ -24,6 +35,31 @@ EXPORT double inform_relative_entropy(int const *xs, int const *ys, size_t n,
 EXPORT double *inform_local_relative_entropy(int const *xs, int const *ys,
     size_t n, int b, double base, double *re, inform_error *err);
 
+/**
+ * Compute the pointwise relative entropy between two timeseries, each
+ * considered as a timeseries of samples from two distributions.
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_local_relative_entropy.
+ */
+EXPORT double *inform_local_relative_entropy_ws(int const *xs, int const *ys,
+    size_t n, int b, double base, double *re, inform_workspace *ws,
+    inform_error *err);
+
+/**
+ * Plan the workspace needed to compute the relative entropy between two
+ * timeseries of length `n`, without allocating anything.
+ */
+EXPORT inform_workspace_plan inform_relative_entropy_plan(size_t n,
+    int b, inform_error *err);
+
+/**
+ * Plan the workspace needed to compute the pointwise relative entropy between two
+ * timeseries of length `n`, without allocating anything.
+ */
+EXPORT inform_workspace_plan inform_local_relative_entropy_plan(size_t n,
+    int b, inform_error *err);
+
 #ifdef __cplusplus
 }
 #endif
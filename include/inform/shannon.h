@@ -3,7 +3,9 @@
 // license that can be found in the LICENSE file.
 #pragma once
 
+#include <inform/decay_dist.h>
 #include <inform/dist.h>
+#include <inform/sparse_dist.h>
 #include <math.h>
 
 #ifdef __cplusplus
@@ -130,6 +132,68 @@ EXPORT double inform_shannon_cmi(inform_dist const *joint,
     inform_dist const *marginal_xz, inform_dist const *marginal_yz,
     inform_dist const *marginal_z, double base);
 
+/**
+ * Compute the mutual information between two variables directly from their
+ * joint distribution.
+ *
+ * The joint event of `x` in `[0, bx)` and `y` in `[0, by)` is taken to be
+ * `x * by + y`. Rather than requiring the marginals, as inform_shannon_mi
+ * does, they are summed on the fly in the same single pass over the joint
+ * histogram which computes its entropy, using a buffer of `by` counts.
+ *
+ * This function will return `NaN` if the joint distribution is not valid,
+ * its support is not of size `bx * by`, or the buffer can't be allocated.
+ *
+ * @param[in] joint the joint probability distribution
+ * @param[in] bx    the number of values x takes
+ * @param[in] by    the number of values y takes
+ * @param[in] base  the logarithmic base
+ * @return the mutual information
+ */
+EXPORT double inform_shannon_joint_mi(inform_dist const *joint, size_t bx,
+    size_t by, double base);
+
+/**
+ * Compute the conditional entropy of `y` given `x` directly from their joint
+ * distribution, laid out as for inform_shannon_joint_mi.
+ *
+ * This function will return `NaN` if the joint distribution is not valid,
+ * its support is not of size `bx * by`, or the buffer can't be allocated.
+ *
+ * @param[in] joint the joint probability distribution
+ * @param[in] bx    the number of values x takes
+ * @param[in] by    the number of values y takes
+ * @param[in] base  the logarithmic base
+ * @return the conditional entropy
+ */
+EXPORT double inform_shannon_joint_ce(inform_dist const *joint, size_t bx,
+    size_t by, double base);
+
+/**
+ * Compute the mutual information between `x` and `y` conditioned on `z`
+ * directly from their joint distribution.
+ *
+ * The joint event of `z` in `[0, bz)`, `x` in `[0, bx)` and `y` in
+ * `[0, by)` is taken to be `(z * bx + x) * by + y`, so that the events
+ * sharing a value of `z` are contiguous. The xz-, yz- and z-marginals are
+ * then summed on the fly, one value of `z` at a time, in the same single
+ * pass which computes the entropy of the joint histogram, using a buffer of
+ * `by` counts.
+ *
+ * This function will return `NaN` if the joint distribution is not valid,
+ * its support is not of size `bz * bx * by`, or the buffer can't be
+ * allocated.
+ *
+ * @param[in] joint the joint probability distribution
+ * @param[in] bz    the number of values z takes
+ * @param[in] bx    the number of values x takes
+ * @param[in] by    the number of values y takes
+ * @param[in] base  the logarithmic base
+ * @return the conditional mutual information
+ */
+EXPORT double inform_shannon_joint_cmi(inform_dist const *joint, size_t bz,
+    size_t bx, size_t by, double base);
+
 /**
  * Compute the pointwise relative entropy between two distributions with equal
  * support size at some event.
@@ -155,6 +219,76 @@ EXPORT double inform_shannon_pre(inform_dist const *p, inform_dist const *q,
 EXPORT double inform_shannon_re(inform_dist const *p, inform_dist const *q,
     double base);
 
+/**
+ * Compute the Shannon self-information of an event given some sparse
+ * distribution
+ *
+ * This function will return `NaN` if the distribution is not valid.
+ *
+ * @param[in] dist  the sparse probability distribution
+ * @param[in] event the event in question
+ * @param[in] base  the logarithmic base
+ * @return the self-information of the event
+ */
+EXPORT double inform_sparse_shannon_si(inform_sparse_dist const *dist,
+    uint64_t event, double base);
+
+/**
+ * Compute the Shannon information of a sparse distribution.
+ *
+ * Only the observed events are visited, so the cost scales with the number
+ * of distinct events rather than with the size of the support.
+ *
+ * This function will return `NaN` if the distribution is not valid,
+ * i.e. `!inform_sparse_dist_is_valid(dist)`.
+ *
+ * @param[in] dist the sparse probability distribution
+ * @param[in] base the logarithmic base
+ * @return the shannon information
+ */
+EXPORT double inform_sparse_shannon(inform_sparse_dist const *dist, double base);
+
+/**
+ * Compute the Shannon self-information of an event given some decaying
+ * distribution
+ *
+ * This function will return `NaN` if the distribution is not valid.
+ *
+ * @param[in] dist  the decaying probability distribution
+ * @param[in] event the event in question
+ * @param[in] base  the logarithmic base
+ * @return the self-information of the event
+ */
+EXPORT double inform_decay_shannon_si(inform_decay_dist const *dist,
+    size_t event, double base);
+
+/**
+ * Compute the Shannon information of a decaying distribution.
+ *
+ * This function will return `NaN` if the distribution is not valid,
+ * i.e. `!inform_decay_dist_is_valid(dist)`.
+ *
+ * @param[in] dist the decaying probability distribution
+ * @param[in] base the logarithmic base
+ * @return the shannon information
+ */
+EXPORT double inform_decay_shannon(inform_decay_dist const *dist, double base);
+
+/**
+ * Compute the relative entropy between two decaying distributions with the
+ * same support, e.g. a quickly and a slowly decaying view of the same stream.
+ *
+ * This function will return `NaN` if either distribution is not valid, the
+ * supports differ, or `p` weighs an event to which `q` gives no weight.
+ *
+ * @param[in] p    the posterior distribution
+ * @param[in] q    the prior distribution
+ * @param[in] base the logarithmic base
+ * @return the relative entropy
+ */
+EXPORT double inform_decay_shannon_re(inform_decay_dist const *p,
+    inform_decay_dist const *q, double base);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,193 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/error.h>
+#include <inform/export.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/// the key used to mark an unoccupied slot of a sparse distribution
+#define INFORM_SPARSE_EMPTY UINT64_MAX
+
+/**
+ * A sparse distribution of observed event frequencies
+ *
+ * Unlike inform_dist, which stores a counter for every event in its support,
+ * a sparse distribution only stores the events which have actually been
+ * observed. The events are 64-bit keys kept in an open-addressing hash table,
+ * so the memory required and the time needed to compute entropies scale
+ * with the number of distinct events observed rather than with the size of
+ * the support.
+ *
+ * Any event other than INFORM_SPARSE_EMPTY may be observed. The table grows
+ * automatically as new events are observed.
+ *
+ * The table can be traversed directly: every slot `i < capacity` for which
+ * `events[i] != INFORM_SPARSE_EMPTY` holds an event together with its number
+ * of occurances, `histogram[i]`.
+ */
+typedef struct inform_sparse_distribution
+{
+    /// the event stored in each slot of the table
+    uint64_t *events;
+    /// the number of occurances of the event in each slot
+    uint32_t *histogram;
+    /// the number of slots in the table (always a power of two)
+    size_t capacity;
+    /// the number of distinct events stored in the table
+    size_t size;
+    /// the number of observations made so far
+    uint64_t counts;
+} inform_sparse_dist;
+
+/**
+ * Allocate an empty sparse distribution.
+ *
+ * The argument is only a hint of how many distinct events are expected; the
+ * table grows as needed. The allocation returns `NULL` if the memory
+ * allocation fails for whatever reason.
+ *
+ * @param[in] n the expected number of distinct events
+ * @return the sparse distribution
+ */
+EXPORT inform_sparse_dist *inform_sparse_dist_alloc(size_t n);
+/**
+ * Free all dynamically allocated memory associated with a sparse distribution.
+ *
+ * @param[in] dist the distribution to free
+ */
+EXPORT void inform_sparse_dist_free(inform_sparse_dist *dist);
+
+/**
+ * Get the number of distinct events stored in the distribution.
+ *
+ * If the distribution is `NULL`, then `0` is returned.
+ *
+ * @param[in] dist the distribution
+ * @return the number of distinct events
+ */
+EXPORT size_t inform_sparse_dist_size(inform_sparse_dist const *dist);
+/**
+ * Get the total number of observations so far made.
+ *
+ * If the distribution is `NULL`, then return `0`.
+ *
+ * @param[in] dist the distribution
+ * @return the number of observations thus far made
+ */
+EXPORT uint64_t inform_sparse_dist_counts(inform_sparse_dist const *dist);
+/**
+ * Determine whether or not the distribution is valid.
+ *
+ * A sparse distribution is valid if it is non-`NULL` and at least one
+ * observation has been made.
+ *
+ * @param[in] dist the distribution
+ * @return the validity of the distribution
+ */
+EXPORT bool inform_sparse_dist_is_valid(inform_sparse_dist const *dist);
+
+/**
+ * Get the number of occurances of a given event.
+ *
+ * If the distribution is `NULL` or the event has never been observed,
+ * `0` is returned.
+ *
+ * @param[in] dist  the distribution
+ * @param[in] event the event in question
+ * @return the number of observed occurances of the event
+ */
+EXPORT uint32_t inform_sparse_dist_get(inform_sparse_dist const *dist, uint64_t event);
+/**
+ * Find the slot of the table which holds a given event.
+ *
+ * The slot of an event is stable until a new event is added to the table,
+ * so it can be used to index per-event data laid out parallel to the table.
+ * If the distribution is `NULL` or the event has never been observed,
+ * `SIZE_MAX` is returned.
+ *
+ * @param[in] dist  the distribution
+ * @param[in] event the event in question
+ * @return the slot holding the event
+ */
+EXPORT size_t inform_sparse_dist_slot(inform_sparse_dist const *dist, uint64_t event);
+/**
+ * Set the number of occurances of a given event.
+ *
+ * If the distribution is `NULL`, the event is INFORM_SPARSE_EMPTY or the
+ * table could not be grown, nothing happens, zero is returned and `err` is
+ * set to INFORM_EDIST, INFORM_EARG or INFORM_ENOMEM respectively. Since zero
+ * is also a valid count, check `err` rather than the result for failure.
+ *
+ * @param[in,out] dist the distribution
+ * @param[in] event    the event in question
+ * @param[in] x        the new number of occurances
+ * @param[out] err     an error code
+ * @return the new number of observed occurances of the event
+ */
+EXPORT uint32_t inform_sparse_dist_set(inform_sparse_dist *dist, uint64_t event,
+    uint32_t x, inform_error *err);
+/**
+ * Increment the number of observations of a given event.
+ *
+ * If the distribution is `NULL`, the event is INFORM_SPARSE_EMPTY or the
+ * table could not be grown, nothing happens, zero is returned and `err` is
+ * set as by inform_sparse_dist_set. Rather than wrapping around, a count
+ * which has reached `UINT32_MAX` is left as it is and `err` is set to
+ * INFORM_EOVERFLOW.
+ *
+ * @param[in,out] dist the distribution
+ * @param[in] event    the event in question
+ * @param[out] err     an error code
+ * @return the new number of occurances of the event
+ */
+EXPORT uint32_t inform_sparse_dist_tick(inform_sparse_dist *dist, uint64_t event,
+    inform_error *err);
+
+/**
+ * Extact the probability of an event.
+ *
+ * If the distribution is `NULL` or no observations have yet been made, then
+ * a zero probability is returned.
+ *
+ * @param[in] dist  the distribution
+ * @param[in] event the event in question
+ * @return the heuristic probability of the event
+ */
+EXPORT double inform_sparse_dist_prob(inform_sparse_dist const *dist, uint64_t event);
+
+/**
+ * Determine whether a sparse distribution should be preferred over a dense
+ * one for a support of a given size that will receive `n` observations.
+ *
+ * A dense histogram is faster to fill, but its memory and the time needed
+ * to compute its entropy scale with the size of the support. Once the
+ * support is large and dwarfs the number of observations, the sparse
+ * distribution wins.
+ *
+ * @param[in] support the size of the dense support
+ * @param[in] n       the number of observations to be made
+ * @return whether to use a sparse distribution
+ */
+EXPORT bool inform_sparse_dist_preferred(size_t support, size_t n);
+
+/**
+ * Compute the largest number of bytes a sparse distribution occupies while
+ * `n` distinct events are observed, including the table it last grew from.
+ *
+ * @param[in] n the number of distinct events
+ * @return an upper bound on the memory used by the distribution
+ */
+EXPORT size_t inform_sparse_dist_bytes(size_t n);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,43 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/export.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * Set the number of threads used to accumulate observations of an ensemble
+ * of time series.
+ *
+ * Each thread counts a contiguous block of the initial conditions into its
+ * own private histogram and the histograms are summed once all of the
+ * threads are done. Since the counts are integers, the results are identical
+ * to those of a serial run. Fewer threads are used whenever the ensemble is
+ * too small to amortize the private histograms.
+ *
+ * Passing a value less than one selects the number of processors available.
+ * If the library was built without OpenMP support, the ensemble is always
+ * processed serially and this function has no effect.
+ *
+ * By default, a single thread is used.
+ *
+ * @param[in] n the number of threads
+ */
+EXPORT void inform_set_num_threads(int n);
+
+/**
+ * Get the number of threads used to accumulate observations of an ensemble
+ * of time series.
+ *
+ * @return the number of threads
+ */
+EXPORT int inform_get_num_threads(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,7 +3,9 @@
 // license that can be found in the LICENSE file.
 #pragma once
 
+#include <inform/dist.h>
 #include <inform/error.h>
+#include <inform/workspace.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -25,6 +27,26 @@ extern "C"
 EXPORT double inform_transfer_entropy(int const *series_y, int const *series_x,
     size_t n, size_t m, int b, size_t k, inform_error *err);
 
+/**
+ * Compute the transfer entropy from one time series to another
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_transfer_entropy.
+ *
+ * @param[in] series_y the ensemble of the source node
+ * @param[in] series_x the ensemble of the target node
+ * @param[in] n        the number initial conditions
+ * @param[in] m        the number of time steps in each time series
+ * @param[in] b        the base or number of distinct states at each time step
+ * @param[in] k        the history length used to calculate the transfer entropy
+ * @param[in,out] ws   the workspace
+ * @param[out] err     an error structure
+ * @return the transfer entropy of the ensemble
+ */
+EXPORT double inform_transfer_entropy_ws(int const *series_y,
+    int const *series_x, size_t n, size_t m, int b, size_t k,
+    inform_workspace *ws, inform_error *err);
+
 /**
  * Compute the local transfer entropy from one time series to another
  *
@@ -41,6 +63,178 @@ EXPORT double inform_transfer_entropy(int const *series_y, int const *series_x,
 EXPORT double *inform_local_transfer_entropy(int const *series_y, int const *series_x,
     size_t n, size_t m, int b, size_t k, double *te, inform_error *err);
 
+/**
+ * Compute the local transfer entropy from one time series to another
+ *
+ * Scratch space is taken from the workspace `ws`, which is grown as needed.
+ * If `ws` is `NULL`, this is equivalent to inform_local_transfer_entropy.
+ *
+ * @param[in] series_y the ensemble of the source node
+ * @param[in] series_x the ensemble of the target node
+ * @param[in] n        the number initial conditions
+ * @param[in] m        the number of time steps in each time series
+ * @param[in] b        the base or number of distinct states at each time step
+ * @param[in] k        the history length used to calculate the transfer entropy
+ * @param[out] te      the transfer entropy
+ * @param[in,out] ws   the workspace
+ * @param[out] err     an error structure
+ * @return a pointer to the transfer entropy array
+ */
+EXPORT double *inform_local_transfer_entropy_ws(int const *series_y,
+    int const *series_x, size_t n, size_t m, int b, size_t k, double *te,
+    inform_workspace *ws, inform_error *err);
+
+/**
+ * Plan the workspace needed for the transfer entropy of an ensemble
+ * of `n` time series of length `m`, without allocating anything.
+ *
+ * @param[in] n    the number of initial conditions
+ * @param[in] m    the number of time steps in each time series
+ * @param[in] b    the base or number of distinct states at each time step
+ * @param[in] k    the history length used to calculate the transfer entropy
+ * @param[out] err an error structure
+ * @return the workspace plan
+ */
+EXPORT inform_workspace_plan inform_transfer_entropy_plan(size_t n,
+    size_t m, int b, size_t k, inform_error *err);
+
+/**
+ * Plan the workspace needed for the local transfer entropy of an ensemble
+ * of `n` time series of length `m`, without allocating anything.
+ *
+ * @param[in] n    the number of initial conditions
+ * @param[in] m    the number of time steps in each time series
+ * @param[in] b    the base or number of distinct states at each time step
+ * @param[in] k    the history length used to calculate the transfer entropy
+ * @param[out] err an error structure
+ * @return the workspace plan
+ */
+EXPORT inform_workspace_plan inform_local_transfer_entropy_plan(size_t n,
+    size_t m, int b, size_t k, inform_error *err);
+
+/**
+ * An incremental accumulator for the transfer entropy from one ensemble to
+ * another
+ *
+ * The accumulator keeps the joint and marginal histograms of the target's
+ * histories and futures and the source's states observed so far, along
+ * with the target's history and the source's last state in the time series
+ * currently being pushed. New time steps (inform_transfer_entropy_acc_push)
+ * and new initial conditions (inform_transfer_entropy_acc_restart) cost time
+ * in proportion to the number of states pushed, and the current transfer
+ * entropy (inform_transfer_entropy_acc_value) is available in constant
+ * time. Pushing each pair of time series in turn, restarting between them,
+ * gives the same value as inform_transfer_entropy.
+ *
+ * The histograms are dense, with 64-bit counters which can't overflow.
+ */
+typedef struct inform_transfer_entropy_acc
+{
+    /// the base of the time series
+    int b;
+    /// the history length
+    size_t k;
+    /// the joint distribution of histories, futures and source states
+    inform_dist *states;
+    /// the distribution of histories
+    inform_dist *histories;
+    /// the joint distribution of histories and source states
+    inform_dist *sources;
+    /// the joint distribution of histories and futures
+    inform_dist *predicates;
+    /// the last (up to) `k` states of the current target time series, encoded
+    uint64_t history;
+    /// the last state of the current source time series
+    int source;
+    /// the number of time steps of the current time series seen, up to `k`
+    size_t seen;
+} inform_transfer_entropy_acc;
+
+/**
+ * Allocate an empty transfer entropy accumulator.
+ *
+ * @param[in] b    the base or number of distinct states at each time step
+ * @param[in] k    the history length used to calculate the transfer entropy
+ * @param[out] err an error structure
+ * @return the accumulator, or `NULL` if the arguments are invalid or the
+ *         allocation fails
+ */
+EXPORT inform_transfer_entropy_acc *inform_transfer_entropy_acc_alloc(int b,
+    size_t k, inform_error *err);
+/**
+ * Free a transfer entropy accumulator.
+ *
+ * @param[in] acc the accumulator
+ */
+EXPORT void inform_transfer_entropy_acc_free(inform_transfer_entropy_acc *acc);
+
+/**
+ * Append `m` time steps to the pair of time series currently being
+ * accumulated.
+ *
+ * If any of the states are invalid, none of them are accumulated.
+ *
+ * @param[in,out] acc   the accumulator
+ * @param[in] series_y  the new time steps of the source
+ * @param[in] series_x  the new time steps of the target
+ * @param[in] m         the number of new time steps
+ * @param[out] err      an error structure
+ */
+EXPORT void inform_transfer_entropy_acc_push(inform_transfer_entropy_acc *acc,
+    int const *series_y, int const *series_x, size_t m, inform_error *err);
+/**
+ * Begin a new pair of time series, i.e. a new initial condition, so that the
+ * states pushed next are not taken to follow those pushed before.
+ *
+ * @param[in,out] acc the accumulator
+ */
+EXPORT void inform_transfer_entropy_acc_restart(inform_transfer_entropy_acc *acc);
+/**
+ * Forget every observation, leaving the accumulator as it was allocated.
+ *
+ * @param[in,out] acc the accumulator
+ */
+EXPORT void inform_transfer_entropy_acc_clear(inform_transfer_entropy_acc *acc);
+/**
+ * Get the transfer entropy of everything accumulated so far.
+ *
+ * This function will return `NaN` if the accumulator is `NULL` or has yet
+ * to see a history followed by a future.
+ *
+ * @param[in] acc  the accumulator
+ * @param[out] err an error structure
+ * @return the transfer entropy
+ */
+EXPORT double inform_transfer_entropy_acc_value(
+    inform_transfer_entropy_acc const *acc, inform_error *err);
+
+/**
+ * Compute the transfer entropy from one ensemble of time series to another
+ * over a sliding window of `w` time steps
+ *
+ * The `j`-th value is the transfer entropy restricted to the time steps
+ * `[j, j + w)`, as inform_transfer_entropy would compute it, for each of the
+ * `m - w + 1` positions of the window. As the window slides, the
+ * observations which enter it are added to the histograms and those which
+ * leave it are removed, keeping their entropies current, so the whole trace
+ * costs time in proportion to `n * m` rather than `n * m * w`.
+ *
+ * @param[in] series_y the source time series
+ * @param[in] series_x the target time series
+ * @param[in] n        the number of initial conditions
+ * @param[in] m        the number of time steps in each time series
+ * @param[in] b        the base or number of distinct states at each time step
+ * @param[in] k        the history length used to calculate the transfer entropy
+ * @param[in] w        the number of time steps in the window, greater than `k`
+ *                     and no greater than `m`
+ * @param[out] te      the transfer entropy at each position of the window
+ * @param[out] err     an error structure
+ * @return a pointer to the array of transfer entropies
+ */
+EXPORT double *inform_windowed_transfer_entropy(int const *series_y,
+    int const *series_x, size_t n, size_t m, int b, size_t k, size_t w,
+    double *te, inform_error *err);
+
 #ifdef __cplusplus
 }
 #endif
@@ -35,6 +35,33 @@ EXPORT int32_t inform_encode(int const *state, size_t n, int b,
 EXPORT void inform_decode(int32_t encoding, int b, int *state, size_t n,
     inform_error *err);
 
+/**
+ * Encode a base-`b` array of integers into a single 64-bit integer.
+ *
+ * This is the counterpart of inform_encode for states which need more than
+ * 31 bits, e.g. long histories. Up to 63 bits of state can be encoded.
+ *
+ * @param[in] state the state to encode
+ * @param[in] n     the number of base-`b` terms in `states`
+ * @param[in] b     the base of each terms
+ * @param[out] err  the error code
+ * @return the encoded state
+ */
+EXPORT int64_t inform_encode64(int const *state, size_t n, int b,
+    inform_error *err);
+
+/**
+ * Decode a 64-bit integer into a base-`b` array of integers.
+ *
+ * @param[in] encoding the encoded state
+ * @param[in] b        the base of the encoding
+ * @param[out] state   the decoded state
+ * @param[in] n        the maximum number of decoded base-`b` terms
+ * @param[out]         the error code
+ */
+EXPORT void inform_decode64(int64_t encoding, int b, int *state, size_t n,
+    inform_error *err);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,7 +29,7 @@ EXPORT int inform_random_int(int a, int b);
 
 /**
  * Generate an array of `n` pseudo-random integers uniformly sampled between
- * `a` and `b`.
+ * `a` and `b`. The array should be released with inform_free.
  *
  * @param[in] a the lower bound
  * @param[in] b the upper bound
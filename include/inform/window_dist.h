@@ -0,0 +1,103 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/dist.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * A distribution of the most recent observations of a stream of events
+ *
+ * A window distribution holds the last `window` events it has observed in a
+ * ring buffer, together with an inform_dist of their frequencies. Observing
+ * a new event once the window is full removes the oldest event from the
+ * distribution, so each observation costs constant time regardless of the
+ * size of the window.
+ *
+ * The underlying distribution keeps its entropy current (see
+ * inform_dist_track_entropy), so that the entropy of the window can be read
+ * in constant time after every observation, e.g. with
+ * `inform_shannon(inform_window_dist_dist(w), 2.0)`. A time-resolved entropy
+ * trace of a stream then takes time linear in the length of the stream.
+ */
+typedef struct inform_window_distribution
+{
+    /// the distribution of the events in the window
+    inform_dist *dist;
+    /// a ring buffer of the events in the window
+    size_t *events;
+    /// the largest number of events the window holds
+    size_t window;
+    /// the position of the oldest event in the ring buffer
+    size_t head;
+} inform_window_dist;
+
+/**
+ * Allocate an empty window distribution over a support of size `n` which
+ * holds at most `window` events.
+ *
+ * The allocation returns `NULL` if either `n` or `window` is zero, or the
+ * memory allocation fails for whatever reason.
+ *
+ * @param[in] n      the number of distinct events that could be observed
+ * @param[in] window the largest number of events the window holds
+ * @return the window distribution
+ */
+EXPORT inform_window_dist *inform_window_dist_alloc(size_t n, size_t window);
+/**
+ * Free all dynamically allocated memory associated with a window
+ * distribution.
+ *
+ * @param[in] dist the distribution to free
+ */
+EXPORT void inform_window_dist_free(inform_window_dist *dist);
+
+/**
+ * Get the distribution of the events in the window.
+ *
+ * The distribution belongs to the window distribution, and must not be
+ * modified or freed. If the window distribution is `NULL`, `NULL` is
+ * returned.
+ *
+ * @param[in] dist the window distribution
+ * @return the distribution of the events in the window
+ */
+EXPORT inform_dist const *inform_window_dist_dist(inform_window_dist const *dist);
+/**
+ * Get the number of events in the window, which is at most the size of the
+ * window.
+ *
+ * If the distribution is `NULL`, `0` is returned.
+ *
+ * @param[in] dist the window distribution
+ * @return the number of events in the window
+ */
+EXPORT size_t inform_window_dist_counts(inform_window_dist const *dist);
+
+/**
+ * Observe an event, removing the oldest event from the window if it is full.
+ *
+ * If the distribution is `NULL`, the event is not in the support or the
+ * underlying distribution can't be grown, nothing happens and zero is
+ * returned.
+ *
+ * @param[in,out] dist the window distribution
+ * @param[in] event    the event observed
+ * @return the new number of occurances of the event in the window
+ */
+EXPORT uint32_t inform_window_dist_tick(inform_window_dist *dist, size_t event);
+/**
+ * Remove every event from the window.
+ *
+ * @param[in,out] dist the window distribution
+ */
+EXPORT void inform_window_dist_clear(inform_window_dist *dist);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,124 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/export.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * A reusable block of scratch memory
+ *
+ * Every measure needs scratch space for its histograms and, in the case of
+ * the local measures, for the states observed at each time step. By default
+ * that space is allocated and freed on every call. The `_ws` variants of the
+ * measures instead take their scratch space from a workspace, which only
+ * ever grows, so that repeated calls of similar size make no allocations.
+ *
+ * A workspace must not be used by two calls at the same time.
+ */
+typedef struct inform_workspace
+{
+    /// the scratch buffer
+    void *buffer;
+    /// the size of the scratch buffer in bytes
+    size_t size;
+    /// whether the buffer may hold data left over from an earlier call
+    bool dirty;
+    /// whether the workspace owns, and so may grow and free, the buffer
+    bool owned;
+} inform_workspace;
+
+/**
+ * The memory a measure needs for a given problem size
+ *
+ * Each measure has a planning function, e.g. inform_active_info_plan, which
+ * computes this without allocating anything.
+ *
+ * When the histograms are dense, every byte but the output array is taken
+ * from the workspace and `workspace` is the exact size that a workspace must
+ * have for the call to make no allocations. When the support is so large
+ * that the histograms are stored sparsely, the sparse tables are allocated
+ * by the call, `histogram` and `scratch` are upper bounds and `workspace`
+ * is zero.
+ */
+typedef struct inform_workspace_plan
+{
+    /// the number of bytes of histograms
+    size_t histogram;
+    /// the number of bytes of other scratch space, e.g. the observed states
+    size_t scratch;
+    /// the number of bytes of the output array, if the call must allocate it
+    size_t output;
+    /// the number of bytes of workspace that the call will use
+    size_t workspace;
+    /// whether the histograms will be stored sparsely
+    bool sparse;
+} inform_workspace_plan;
+
+/**
+ * Allocate a workspace with an initial buffer of `size` bytes.
+ *
+ * The size is only a hint; the buffer grows as needed. The allocation returns
+ * `NULL` if the memory allocation fails for whatever reason.
+ *
+ * @param[in] size the initial size of the buffer in bytes
+ * @return the workspace
+ */
+EXPORT inform_workspace *inform_workspace_alloc(size_t size);
+/**
+ * Free a workspace and, if the workspace owns it, its buffer.
+ *
+ * @param[in] ws the workspace to free
+ */
+EXPORT void inform_workspace_free(inform_workspace *ws);
+
+/**
+ * Wrap a caller-provided buffer of `size` bytes in a workspace.
+ *
+ * The workspace neither grows nor frees the buffer, so a measure given a
+ * wrapped workspace that is too small for it fails with INFORM_ENOMEM rather
+ * than allocating. The size a measure needs can be computed with its
+ * planning function. Nothing is allocated; the buffer must be aligned at
+ * least as well as one returned by `malloc` and must outlive every use of
+ * the workspace.
+ *
+ * @param[in] buffer the buffer
+ * @param[in] size   the size of the buffer in bytes
+ * @return the workspace
+ */
+EXPORT inform_workspace inform_workspace_wrap(void *buffer, size_t size);
+
+/**
+ * Get the size, in bytes, of the workspace's buffer.
+ *
+ * If the workspace is `NULL`, then `0` is returned.
+ *
+ * @param[in] ws the workspace
+ * @return the size of the buffer
+ */
+EXPORT size_t inform_workspace_size(inform_workspace const *ws);
+
+/**
+ * Ensure that the workspace's buffer holds at least `size` bytes.
+ *
+ * The buffer is replaced by a larger, zeroed one if it is too small, in which
+ * case its contents are lost. If the workspace is `NULL`, doesn't own its
+ * buffer, or the buffer can't be grown, `NULL` is returned and the workspace
+ * is left unscathed.
+ *
+ * @param[in,out] ws the workspace
+ * @param[in] size   the required size in bytes
+ * @return the buffer
+ */
+EXPORT void *inform_workspace_reserve(inform_workspace *ws, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,11 +3,15 @@
 // license that can be found in the LICENSE file.
 #include <inform/active_info.h>
 #include <inform/shannon.h>
+#include "ensemble.h"
+#include "counters.h"
+#include "memory.h"
+#include "scratch.h"
 
 static void accumulate_observations(int const* series, size_t n, int b,
-    size_t k, inform_dist *states, inform_dist *histories, inform_dist *futures)
+    size_t k, inform_dist *states, uint64_t *state)
 {
-    int history = 0, q = 1, state, future;
+    uint64_t history = 0, q = 1;
     for (size_t i = 0; i < k; ++i)
     {
         q *= b;
@@ -16,186 +20,610 @@ static void accumulate_observations(int const* series, size_t n, int b,
     }
     for (size_t i = k; i < n; ++i)
     {
-        future = series[i];
-        state  = history * b + future;
+        uint64_t const s = history * b + series[i];
+        states->histogram[s]++;
+        if (state != NULL)
+        {
+            state[i - k] = s;
+        }
+        history = s - series[i - k]*q;
+    }
+}
 
-        states->histogram[state]++;
-        histories->histogram[history]++;
-        futures->histogram[future]++;
+static void accumulate_marginals(inform_dist const *states, int b,
+    inform_dist *histories, inform_dist *futures)
+{
+    uint32_t const *joint = states->histogram;
+    for (size_t history = 0; history < histories->size; ++history)
+    {
+        for (int future = 0; future < b; ++future, ++joint)
+        {
+            histories->histogram[history] += *joint;
+            futures->histogram[future] += *joint;
+        }
+    }
+}
 
-        history = state - series[i - k]*q;
+struct ensemble
+{
+    int const *series;
+    size_t m;
+    int b;
+    size_t k;
+    size_t states_size;
+    uint64_t *state;
+};
+
+static void accumulate_ensemble(void const *ctx, size_t begin, size_t end,
+    uint32_t *data)
+{
+    struct ensemble const *e = ctx;
+    inform_dist states = inform_dist_view(data, e->states_size, 0);
+    for (size_t i = begin; i < end; ++i)
+    {
+        uint64_t *state = (e->state == NULL) ? NULL : e->state + i * (e->m - e->k);
+        accumulate_observations(e->series + i * e->m, e->m, e->b, e->k,
+            &states, state);
     }
 }
 
-static void accumulate_local_observations(int const* series, size_t n, int b,
-    size_t k, inform_dist *states, inform_dist *histories, inform_dist *futures,
-    int *state, int *history, int *future)
+static bool accumulate_sparse_observations(int const* series, size_t n, int b,
+    size_t k, inform_sparse_dist *states, uint64_t *state, inform_error *err)
 {
-    history[0] = 0;
-    int q = 1;
+    uint64_t history = 0, q = 1;
     for (size_t i = 0; i < k; ++i)
     {
         q *= b;
-        history[0] *= b;
-        history[0] += series[i];
+        history *= b;
+        history += series[i];
     }
     for (size_t i = k; i < n; ++i)
     {
-        size_t l = i - k;
-        future[l] = series[i];
-        state[l] = history[l] * b + future[l];
-
-        states->histogram[state[l]]++;
-        histories->histogram[history[l]]++;
-        futures->histogram[future[l]]++;
+        uint64_t const s = history * b + series[i];
+        if (inform_sparse_dist_tick(states, s, err) == 0)
+        {
+            return true;
+        }
+        if (state != NULL)
+        {
+            state[i - k] = s;
+        }
+        history = s - series[i - k]*q;
+    }
+    return false;
+}
 
-        if (i + 1 != n)
-            history[l + 1] = state[l] - series[l]*q;
+static bool accumulate_sparse_marginals(inform_sparse_dist const *states,
+    int b, inform_sparse_dist *histories, inform_dist *futures,
+    inform_error *err)
+{
+    for (size_t i = 0; i < states->capacity; ++i)
+    {
+        if (states->events[i] != INFORM_SPARSE_EMPTY)
+        {
+            uint64_t const history = states->events[i] / b;
+            uint32_t const count = states->histogram[i];
+            if (inform_sparse_add(histories, history, count, err))
+            {
+                return true;
+            }
+            futures->histogram[states->events[i] % b] += count;
+        }
     }
+    futures->counts = states->counts;
+    return false;
 }
 
-static bool check_arguments(int const *series, size_t n, size_t m, int b, size_t k, inform_error *err)
+static void free_sparse(inform_sparse_dist *states,
+    inform_sparse_dist *histories, inform_dist *futures)
 {
-    if (series == NULL)
+    inform_dist_free(futures);
+    inform_sparse_dist_free(histories);
+    inform_sparse_dist_free(states);
+}
+
+static bool sparse_accumulate(int const *series, size_t n, size_t m, int b,
+    size_t k, inform_sparse_dist **states, inform_sparse_dist **histories,
+    inform_dist **futures, uint64_t *state, inform_error *err)
+{
+    *states = inform_sparse_dist_alloc(0);
+    *histories = inform_sparse_dist_alloc(0);
+    *futures = inform_dist_alloc(b);
+    if (*states == NULL || *histories == NULL || *futures == NULL)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ETIMESERIES, true);
+        free_sparse(*states, *histories, *futures);
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, true);
     }
-    else if (n < 1)
+    for (size_t i = 0; i < n; ++i, series += m)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ENOINITS, true);
+        if (accumulate_sparse_observations(series, m, b, k, *states, state,
+            err))
+        {
+            free_sparse(*states, *histories, *futures);
+            return true;
+        }
+        if (state != NULL)
+        {
+            state += (m - k);
+        }
     }
-    else if (m < 2)
+    if (accumulate_sparse_marginals(*states, b, *histories, *futures, err))
     {
-        INFORM_ERROR_RETURN(err, INFORM_ESHORTSERIES, true);
+        free_sparse(*states, *histories, *futures);
+        return true;
     }
-    else if (b < 2)
+    return false;
+}
+
+static double sparse_active_info(int const *series, size_t n, size_t m, int b,
+    size_t k, inform_error *err)
+{
+    inform_sparse_dist *states = NULL, *histories = NULL;
+    inform_dist *futures = NULL;
+    if (sparse_accumulate(series, n, m, b, k, &states, &histories, &futures,
+        NULL, err))
     {
-        INFORM_ERROR_RETURN(err, INFORM_EBASE, true);
+        return NAN;
     }
-    else if (k == 0)
+
+    double ai = inform_sparse_shannon(histories, (double) b) +
+        inform_shannon(futures, (double) b) -
+        inform_sparse_shannon(states, (double) b);
+
+    free_sparse(states, histories, futures);
+
+    return ai;
+}
+
+static double *sparse_local_active_info(int const *series, size_t n, size_t m,
+    int b, size_t k, double *ai, inform_error *err)
+{
+    size_t const N = n * (m - k);
+
+    uint64_t *state = inform_malloc(N * sizeof(uint64_t));
+    if (state == NULL)
     {
-        INFORM_ERROR_RETURN(err, INFORM_EKZERO, true);
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
     }
-    else if (m <= k)
+
+    inform_sparse_dist *states = NULL, *histories = NULL;
+    inform_dist *futures = NULL;
+    if (sparse_accumulate(series, n, m, b, k, &states, &histories, &futures,
+        state, err))
     {
-        INFORM_ERROR_RETURN(err, INFORM_EKLONG, true);
+        inform_sized_free(state, N * sizeof(uint64_t));
+        return NULL;
     }
-    for (size_t i = 0; i < n * m; ++i)
+
+    double *local = inform_malloc(states->capacity * sizeof(double));
+    if (local == NULL)
     {
-        if (series[i] < 0)
-        {
-            INFORM_ERROR_RETURN(err, INFORM_ENEGSTATE, true);
-        }
-        else if (b <= series[i])
+        free_sparse(states, histories, futures);
+        inform_sized_free(state, N * sizeof(uint64_t));
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
+    // compute the local active information once for each observed state
+    for (size_t j = 0; j < states->capacity; ++j)
+    {
+        uint64_t const s = states->events[j];
+        if (s != INFORM_SPARSE_EMPTY)
         {
-            INFORM_ERROR_RETURN(err, INFORM_EBADSTATE, true);
+            local[j] = inform_sparse_shannon_si(histories, s / b, (double) b) +
+                inform_shannon_si(futures, s % b, (double) b) -
+                inform_sparse_shannon_si(states, s, (double) b);
         }
     }
-    return false;
+    for (size_t i = 0; i < N; ++i)
+    {
+        ai[i] = local[inform_sparse_dist_slot(states, state[i])];
+    }
+
+    inform_sized_free(local, states->capacity * sizeof(double));
+    free_sparse(states, histories, futures);
+    inform_sized_free(state, N * sizeof(uint64_t));
+
+    return ai;
+}
+
+static inform_workspace_plan plan(size_t n, size_t m, int b, size_t k,
+    bool local)
+{
+    size_t const N = n * (m - k);
+    uint64_t support;
+    inform_block_support(b, k + 1, &support);
+    if (inform_use_sparse(support, N))
+    {
+        size_t const histogram = 2 * inform_sparse_dist_bytes(N) +
+            sizeof(inform_dist) + b * sizeof(uint32_t);
+        return inform_plan_sparse(histogram, local ? N : 0, local ? N : 0);
+    }
+    size_t const states_size = (size_t) support;
+    size_t const total_size = states_size + states_size / b + b;
+    if (local)
+    {
+        return inform_plan_dense(total_size, N, states_size, N);
+    }
+    return inform_plan_dense(total_size, 0, 0, 0);
+}
+
+inform_workspace_plan inform_active_info_plan(size_t n, size_t m, int b,
+    size_t k, inform_error *err)
+{
+    inform_workspace_plan p = { 0, 0, 0, 0, false };
+    if (inform_check_history_shape(n, m, b, k, k + 1, err)) return p;
+    return plan(n, m, b, k, false);
+}
+
+inform_workspace_plan inform_local_active_info_plan(size_t n, size_t m, int b,
+    size_t k, inform_error *err)
+{
+    inform_workspace_plan p = { 0, 0, 0, 0, false };
+    if (inform_check_history_shape(n, m, b, k, k + 1, err)) return p;
+    return plan(n, m, b, k, true);
 }
 
 double inform_active_info(int const *series, size_t n, size_t m, int b, size_t k, inform_error *err)
 {
-    if (check_arguments(series, n, m, b, k, err)) return NAN;
+    inform_workspace ws = { NULL, 0, false, true };
+    double const ai = inform_active_info_ws(series, n, m, b, k, &ws, err);
+    inform_aligned_free(ws.buffer, ws.size);
+    return ai;
+}
 
-    size_t const N = n * (m - k);
+double inform_active_info_ws(int const *series, size_t n, size_t m, int b,
+    size_t k, inform_workspace *ws, inform_error *err)
+{
+    if (ws == NULL) return inform_active_info(series, n, m, b, k, err);
 
-    size_t const states_size = (size_t) (b * pow((double) b,(double) k));
-    size_t const histories_size = states_size / b;
-    size_t const futures_size = b;
-    size_t const total_size = states_size + histories_size + futures_size;
+    if (inform_check_history_args(series, n, m, b, k, k + 1, err)) return NAN;
 
-    uint32_t *data = calloc(total_size, sizeof(uint32_t));
-    if (data == NULL)
+    inform_workspace_plan const p = plan(n, m, b, k, false);
+    if (p.sparse)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NAN);
+        return sparse_active_info(series, n, m, b, k, err);
     }
 
-    inform_dist states    = { data, states_size, N };
-    inform_dist histories = { data + states_size, histories_size, N };
-    inform_dist futures   = { data + states_size + histories_size, futures_size, N };
+    size_t const N = n * (m - k);
 
-    for (size_t i = 0; i < n; ++i, series += m)
+    uint64_t support;
+    inform_block_support(b, k + 1, &support);
+    size_t const states_size = (size_t) support;
+    size_t const histories_size = states_size / b;
+    size_t const futures_size = b;
+
+    uint32_t *data = inform_scratch(ws, p.workspace, p.histogram);
+    if (data == NULL)
     {
-        accumulate_observations(series, m, b, k, &states, &histories, &futures);
+        if (!ws->owned)
+        {
+            INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NAN);
+        }
+        // the dense histograms don't fit in memory, but the sparse ones might
+        return sparse_active_info(series, n, m, b, k, err);
     }
 
-    double ai = inform_shannon_mi(&states, &histories, &futures, (double) b);
+    inform_dist states    = inform_dist_view(data, states_size, N);
+    inform_dist histories = inform_dist_view(data + states_size,
+        histories_size, N);
+    inform_dist futures   = inform_dist_view(data + states_size + histories_size,
+        futures_size, N);
 
-    free(data);
+    struct ensemble const e = { series, m, b, k, states_size, NULL };
+    inform_accumulate_ensemble(accumulate_ensemble, &e, n, N, data, states_size);
+    accumulate_marginals(&states, b, &histories, &futures);
 
-    return ai;
+    return inform_shannon_mi(&states, &histories, &futures, (double) b);
 }
-
 double *inform_local_active_info(int const *series, size_t n, size_t m,
     int b, size_t k, double *ai, inform_error *err)
 {
-    if (check_arguments(series, n, m, b, k, err)) return NULL;
+    inform_workspace ws = { NULL, 0, false, true };
+    ai = inform_local_active_info_ws(series, n, m, b, k, ai, &ws, err);
+    inform_aligned_free(ws.buffer, ws.size);
+    return ai;
+}
+
+double *inform_local_active_info_ws(int const *series, size_t n, size_t m,
+    int b, size_t k, double *ai, inform_workspace *ws, inform_error *err)
+{
+    if (ws == NULL) return inform_local_active_info(series, n, m, b, k, ai, err);
+
+    if (inform_check_history_args(series, n, m, b, k, k + 1, err)) return NULL;
 
     size_t const N = n * (m - k);
 
-    if (ai == NULL)
+    // allocate the output only once the workspace is known to suffice, so
+    // that it isn't leaked if a borrowed workspace is too small
+    inform_workspace_plan const p = plan(n, m, b, k, true);
+    uint32_t *data = p.sparse ? NULL :
+        inform_scratch(ws, p.workspace, p.histogram);
+    if (data == NULL && !p.sparse && !ws->owned)
     {
-        ai = malloc(N * sizeof(double));
-        if (ai == NULL)
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
+    double *out = (ai == NULL) ? inform_malloc(N * sizeof(double)) : ai;
+    if (out == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
+    // fall back on sparse histograms if the support is too large for dense
+    // ones, or if they can't be allocated
+    if (data == NULL)
+    {
+        if (sparse_local_active_info(series, n, m, b, k, out, err) == NULL)
         {
-            INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+            if (out != ai) inform_sized_free(out, N * sizeof(double));
+            return NULL;
         }
+        return out;
     }
 
-    size_t const states_size = (size_t) (b*pow((double) b,(double) k));
+    uint64_t support;
+    inform_block_support(b, k + 1, &support);
+    size_t const states_size = (size_t) support;
     size_t const histories_size = states_size / b;
     size_t const futures_size = b;
-    size_t const total_size = states_size + histories_size + futures_size;
 
-    uint32_t *data = calloc(total_size, sizeof(uint32_t));
-    if (data == NULL)
+    uint64_t *state = inform_scratch_states(data, &p);
+    double *local = inform_scratch_table(data, &p, N);
+
+    inform_dist states    = inform_dist_view(data, states_size, N);
+    inform_dist histories = inform_dist_view(data + states_size,
+        histories_size, N);
+    inform_dist futures   = inform_dist_view(data + states_size + histories_size,
+        futures_size, N);
+
+    struct ensemble const e = { series, m, b, k, states_size, state };
+    inform_accumulate_ensemble(accumulate_ensemble, &e, n, N, data, states_size);
+    accumulate_marginals(&states, b, &histories, &futures);
+
+    // compute the local active information once for each observed state
+    for (size_t s = 0; s < states_size; ++s)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+        if (states.histogram[s] != 0)
+        {
+            local[s] = inform_shannon_pmi(&states, &histories, &futures, s,
+                s / b, s % b, (double) b);
+        }
+    }
+    for (size_t i = 0; i < N; ++i)
+    {
+        out[i] = local[state[i]];
     }
 
-    inform_dist states    = { data, states_size, N };
-    inform_dist histories = { data + states_size, histories_size, N };
-    inform_dist futures   = { data + states_size + histories_size, futures_size, N };
+    return out;
+}
 
-    int *state   = malloc(N * sizeof(int));
-    if (state == NULL)
+inform_active_info_acc *inform_active_info_acc_alloc(int b, size_t k,
+    inform_error *err)
+{
+    if (b < 2)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+        INFORM_ERROR_RETURN(err, INFORM_EBASE, NULL);
     }
-    int *history = malloc(N * sizeof(int));
-    if (history == NULL)
+    else if (k == 0)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EKZERO, NULL);
+    }
+    inform_active_info_acc *acc = inform_calloc(1, sizeof(inform_active_info_acc));
+    if (acc == NULL)
     {
         INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
     }
-    int *future  = malloc(N * sizeof(int));
-    if (future == NULL)
+    acc->b = b;
+    acc->k = k;
+    acc->states = inform_tracked_blocks_alloc(b, k + 1, err);
+    acc->histories = inform_tracked_blocks_alloc(b, k, err);
+    acc->futures = inform_tracked_blocks_alloc(b, 1, err);
+    if (acc->states == NULL || acc->histories == NULL || acc->futures == NULL)
+    {
+        inform_active_info_acc_free(acc);
+        return NULL;
+    }
+    return acc;
+}
+
+void inform_active_info_acc_free(inform_active_info_acc *acc)
+{
+    if (acc != NULL)
+    {
+        inform_dist_free(acc->futures);
+        inform_dist_free(acc->histories);
+        inform_dist_free(acc->states);
+        inform_sized_free(acc, sizeof(inform_active_info_acc));
+    }
+}
+
+void inform_active_info_acc_push(inform_active_info_acc *acc,
+    int const *series, size_t m, inform_error *err)
+{
+    if (acc == NULL)
+    {
+        INFORM_ERROR_RETURN_VOID(err, INFORM_EFAULT);
+    }
+    if (inform_check_pushed(series, m, acc->b, err))
+    {
+        return;
+    }
+    // the history wraps around modulo the number of histories, b^k
+    size_t const q = acc->histories->size;
+    for (size_t i = 0; i < m; ++i)
+    {
+        uint64_t const s = acc->history * acc->b + series[i];
+        if (acc->seen == acc->k)
+        {
+            inform_dist_tick(acc->states, s);
+            inform_dist_tick(acc->histories, acc->history);
+            inform_dist_tick(acc->futures, series[i]);
+        }
+        else
+        {
+            acc->seen += 1;
+        }
+        acc->history = s % q;
+    }
+}
+
+void inform_active_info_acc_restart(inform_active_info_acc *acc)
+{
+    if (acc != NULL)
+    {
+        acc->history = 0;
+        acc->seen = 0;
+    }
+}
+
+void inform_active_info_acc_clear(inform_active_info_acc *acc)
+{
+    if (acc != NULL)
+    {
+        inform_dist_clear(acc->states);
+        inform_dist_clear(acc->histories);
+        inform_dist_clear(acc->futures);
+        inform_active_info_acc_restart(acc);
+    }
+}
+
+double inform_active_info_acc_value(inform_active_info_acc const *acc,
+    inform_error *err)
+{
+    if (acc == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EFAULT, NAN);
+    }
+    else if (!inform_dist_is_valid(acc->states))
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EDIST, NAN);
+    }
+    return inform_shannon_mi(acc->states, acc->histories, acc->futures,
+        (double) acc->b);
+}
+
+static void free_windows(inform_window_dist *states,
+    inform_window_dist *histories, inform_window_dist *futures)
+{
+    inform_window_dist_free(futures);
+    inform_window_dist_free(histories);
+    inform_window_dist_free(states);
+}
+
+double *inform_windowed_active_info(int const *series, size_t n, size_t m,
+    int b, size_t k, size_t w, double *ai, inform_error *err)
+{
+    if (inform_check_history_args(series, n, m, b, k, k + 1, err)) return NULL;
+
+    if (w <= k)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EKLONG, NULL);
+    }
+    else if (w > m)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EARG, NULL);
+    }
+
+    // each position of the window holds w - k observations per series
+    size_t const window = n * (w - k);
+    inform_window_dist *states = inform_window_blocks_alloc(b, k + 1, window, err);
+    inform_window_dist *histories = inform_window_blocks_alloc(b, k, window, err);
+    inform_window_dist *futures = inform_window_blocks_alloc(b, 1, window, err);
+    uint64_t *history = inform_calloc(n, sizeof(uint64_t));
+    double *out = (ai == NULL) ? inform_malloc((m - w + 1) * sizeof(double)) : ai;
+    if (states == NULL || histories == NULL || futures == NULL ||
+        history == NULL || out == NULL)
     {
+        if (out != ai) inform_sized_free(out, (m - w + 1) * sizeof(double));
+        inform_sized_free(history, n * sizeof(uint64_t));
+        free_windows(states, histories, futures);
         INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
     }
 
-    int const *series_ptr = series;
-    int *state_ptr = state, *history_ptr = history, *future_ptr = future;
+    size_t const q = inform_window_dist_dist(histories)->size;
     for (size_t i = 0; i < n; ++i)
     {
-        accumulate_local_observations(series_ptr, m, b, k, &states, &histories,
-            &futures, state_ptr, history_ptr, future_ptr);
-        series_ptr += m;
-        state_ptr += (m - k);
-        history_ptr += (m - k);
-        future_ptr += (m - k);
+        for (size_t t = 0; t < k; ++t)
+        {
+            history[i] = history[i] * b + series[i * m + t];
+        }
+    }
+    // slide the window one time step at a time, the observations of each
+    // step displacing those of the step which leaves the window
+    for (size_t t = k; t < m; ++t)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            int const future = series[i * m + t];
+            uint64_t const s = history[i] * b + future;
+            if (inform_window_dist_tick(states, s) == 0 ||
+                inform_window_dist_tick(histories, history[i]) == 0 ||
+                inform_window_dist_tick(futures, future) == 0)
+            {
+                if (out != ai) inform_sized_free(out, (m - w + 1) * sizeof(double));
+                inform_sized_free(history, n * sizeof(uint64_t));
+                free_windows(states, histories, futures);
+                INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+            }
+            history[i] = s % q;
+        }
+        if (t + 1 >= w)
+        {
+            out[t + 1 - w] = inform_shannon_mi(inform_window_dist_dist(states),
+                inform_window_dist_dist(histories),
+                inform_window_dist_dist(futures), (double) b);
+        }
     }
 
-    for (size_t i = 0; i < N; ++i)
+    inform_sized_free(history, n * sizeof(uint64_t));
+    free_windows(states, histories, futures);
+
+    return out;
+}
+
+struct sweep
+{
+    int b;
+    double *ai;
+};
+
+static void sweep_visit(void *ctx, size_t k, inform_dist const *states,
+    inform_dist const *histories, inform_dist const *futures)
+{
+    struct sweep *sweep = ctx;
+    sweep->ai[k - 1] = inform_shannon_mi(states, histories, futures, (double) sweep->b);
+}
+
+double *inform_active_info_sweep(int const *series, size_t n, size_t m, int b,
+    size_t K, double *ai, inform_error *err)
+{
+    if (inform_check_history_args(series, n, m, b, K, K + 1, err)) return NULL;
+
+    double *out = (ai == NULL) ? inform_malloc(K * sizeof(double)) : ai;
+    if (out == NULL)
     {
-        ai[i] = inform_shannon_pmi(&states, &histories, &futures, state[i],
-            history[i], future[i], (double) b);
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
     }
 
-    free(future);
-    free(history);
-    free(state);
-    free(data);
+    uint64_t support;
+    inform_block_support(b, K + 1, &support);
+    struct sweep sweep = { b, out };
+    if (inform_use_sparse(support, n * (m - K)) ||
+        inform_sweep_histories(series, n, m, b, K, sweep_visit, &sweep))
+    {
+        // fall back on the sparse histograms, one history length at a time
+        for (size_t k = 1; k <= K; ++k)
+        {
+            inform_error e = INFORM_SUCCESS;
+            out[k - 1] = inform_active_info(series, n, m, b, k, &e);
+            if (inform_failed(&e))
+            {
+                INFORM_ERROR(err, e);
+                if (out != ai) inform_sized_free(out, K * sizeof(double));
+                return NULL;
+            }
+        }
+    }
 
-    return ai;
+    return out;
 }
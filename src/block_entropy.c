@@ -3,12 +3,19 @@
 // license that can be found in the LICENSE file.
 #include <inform/block_entropy.h>
 #include <inform/shannon.h>
+#include <math.h>
+#include <string.h>
+#include "ensemble.h"
+#include "counters.h"
+#include "kernels.h"
+#include "memory.h"
+#include "scratch.h"
 
 static void accumulate_observations(int const* series, size_t n, int b,
-    size_t k, inform_dist *states)
+    size_t k, inform_dist *states, uint64_t *state)
 {
     k -= 1;
-    int history = 0, q = 1, state;
+    uint64_t history = 0, q = 1;
     for (size_t i = 0; i < k; ++i)
     {
         q *= b;
@@ -17,18 +24,45 @@ static void accumulate_observations(int const* series, size_t n, int b,
     }
     for (size_t i = k; i < n; ++i)
     {
-        state  = history * b + series[i];
-        states->histogram[state]++;
-        history = state - series[i - k]*q;
+        uint64_t const s = history * b + series[i];
+        states->histogram[s]++;
+        if (state != NULL)
+        {
+            state[i - k] = s;
+        }
+        history = s - series[i - k]*q;
+    }
+}
+
+struct ensemble
+{
+    int const *series;
+    size_t m;
+    int b;
+    size_t k;
+    size_t states_size;
+    uint64_t *state;
+};
+
+static void accumulate_ensemble(void const *ctx, size_t begin, size_t end,
+    uint32_t *data)
+{
+    struct ensemble const *e = ctx;
+    inform_dist states = inform_dist_view(data, e->states_size, 0);
+    for (size_t i = begin; i < end; ++i)
+    {
+        uint64_t *state = (e->state == NULL) ? NULL : e->state + i * (e->m - e->k + 1);
+        accumulate_observations(e->series + i * e->m, e->m, e->b, e->k,
+            &states, state);
     }
 }
 
-static void accumulate_local_observations(int const* series, size_t n, int b,
-    size_t k, inform_dist *states, int *state)
+static bool accumulate_sparse_observations(int const* series, size_t n,
+    int b, size_t k, inform_sparse_dist *states, uint64_t *state,
+    inform_error *err)
 {
     k -= 1;
-    int history = 0;
-    int q = 1;
+    uint64_t history = 0, q = 1;
     for (size_t i = 0; i < k; ++i)
     {
         q *= b;
@@ -37,134 +71,429 @@ static void accumulate_local_observations(int const* series, size_t n, int b,
     }
     for (size_t i = k; i < n; ++i)
     {
-        size_t l = i - k;
-        state[l] = history * b + series[i];
-
-        states->histogram[state[l]]++;
-
-        if (i + 1 != n)
-            history = state[l] - series[l]*q;
+        uint64_t const s = history * b + series[i];
+        if (inform_sparse_dist_tick(states, s, err) == 0)
+        {
+            return true;
+        }
+        if (state != NULL)
+        {
+            state[i - k] = s;
+        }
+        history = s - series[i - k]*q;
     }
+    return false;
 }
 
-static bool check_arguments(int const *series, size_t n, size_t m, int b,
-    size_t k, inform_error *err)
+static bool sparse_accumulate(int const *series, size_t n, size_t m, int b,
+    size_t k, inform_sparse_dist **states, uint64_t *state, inform_error *err)
 {
-    if (series == NULL)
+    *states = inform_sparse_dist_alloc(0);
+    if (*states == NULL)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ETIMESERIES, true);
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, true);
     }
-    else if (n < 1)
+    for (size_t i = 0; i < n; ++i, series += m)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ENOINITS, true);
+        if (accumulate_sparse_observations(series, m, b, k, *states, state,
+            err))
+        {
+            inform_sparse_dist_free(*states);
+            return true;
+        }
+        if (state != NULL)
+        {
+            state += (m - k + 1);
+        }
     }
-    else if (m < 2)
+    return false;
+}
+
+static double sparse_block_entropy(int const *series, size_t n, size_t m,
+    int b, size_t k, inform_error *err)
+{
+    inform_sparse_dist *states = NULL;
+    if (sparse_accumulate(series, n, m, b, k, &states, NULL, err))
     {
-        INFORM_ERROR_RETURN(err, INFORM_ESHORTSERIES, true);
+        return NAN;
     }
-    else if (b < 2)
+
+    double be = inform_sparse_shannon(states, (double) b);
+
+    inform_sparse_dist_free(states);
+
+    return be;
+}
+
+static double *sparse_local_block_entropy(int const *series, size_t n,
+    size_t m, int b, size_t k, double *be, inform_error *err)
+{
+    size_t const N = n * (m - k + 1);
+
+    uint64_t *state = inform_malloc(N * sizeof(uint64_t));
+    if (state == NULL)
     {
-        INFORM_ERROR_RETURN(err, INFORM_EBASE, true);
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
     }
-    else if (k == 0)
+
+    inform_sparse_dist *states = NULL;
+    if (sparse_accumulate(series, n, m, b, k, &states, state, err))
     {
-        INFORM_ERROR_RETURN(err, INFORM_EKZERO, true);
+        inform_sized_free(state, N * sizeof(uint64_t));
+        return NULL;
     }
-    else if (m <= k)
+
+    for (size_t i = 0; i < N; ++i)
     {
-        INFORM_ERROR_RETURN(err, INFORM_EKLONG, true);
+        be[i] = inform_sparse_shannon_si(states, state[i], (double) b);
     }
-    for (size_t i = 0; i < n * m; ++i)
+
+    inform_sparse_dist_free(states);
+    inform_sized_free(state, N * sizeof(uint64_t));
+
+    return be;
+}
+
+static inform_workspace_plan plan(size_t n, size_t m, int b, size_t k,
+    bool local)
+{
+    size_t const N = n * (m - k + 1);
+    uint64_t support;
+    inform_block_support(b, k, &support);
+    if (inform_use_sparse(support, N))
     {
-        if (series[i] < 0)
-        {
-            INFORM_ERROR_RETURN(err, INFORM_ENEGSTATE, true);
-        }
-        else if (b <= series[i])
-        {
-            INFORM_ERROR_RETURN(err, INFORM_EBADSTATE, true);
-        }
+        return inform_plan_sparse(inform_sparse_dist_bytes(N),
+            local ? N : 0, local ? N : 0);
     }
-    return false;
+    size_t const states_size = (size_t) support;
+    if (local)
+    {
+        return inform_plan_dense(states_size, N, 0, N);
+    }
+    return inform_plan_dense(states_size, 0, 0, 0);
+}
+
+inform_workspace_plan inform_block_entropy_plan(size_t n, size_t m, int b,
+    size_t k, inform_error *err)
+{
+    inform_workspace_plan p = { 0, 0, 0, 0, false };
+    if (inform_check_history_shape(n, m, b, k, k, err)) return p;
+    return plan(n, m, b, k, false);
+}
+
+inform_workspace_plan inform_local_block_entropy_plan(size_t n, size_t m, int b,
+    size_t k, inform_error *err)
+{
+    inform_workspace_plan p = { 0, 0, 0, 0, false };
+    if (inform_check_history_shape(n, m, b, k, k, err)) return p;
+    return plan(n, m, b, k, true);
 }
 
 double inform_block_entropy(int const *series, size_t n, size_t m, int b,
     size_t k, inform_error *err)
 {
-    if (check_arguments(series, n, m, b, k, err)) return NAN;
+    inform_workspace ws = { NULL, 0, false, true };
+    double const be = inform_block_entropy_ws(series, n, m, b, k, &ws, err);
+    inform_aligned_free(ws.buffer, ws.size);
+    return be;
+}
 
-    size_t const states_size = (size_t) pow((double) b, (double) k);
+double inform_block_entropy_ws(int const *series, size_t n, size_t m, int b,
+    size_t k, inform_workspace *ws, inform_error *err)
+{
+    if (ws == NULL) return inform_block_entropy(series, n, m, b, k, err);
 
-    uint32_t *data = calloc(states_size, sizeof(uint32_t));
-    if (data == NULL)
+    if (inform_check_history_args(series, n, m, b, k, k, err)) return NAN;
+
+    inform_workspace_plan const p = plan(n, m, b, k, false);
+    if (p.sparse)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NAN);
+        return sparse_block_entropy(series, n, m, b, k, err);
     }
 
     size_t const N = n * (m - k + 1);
 
-    inform_dist states = { data, states_size, N };
+    uint64_t support;
+    inform_block_support(b, k, &support);
+    size_t const states_size = (size_t) support;
 
-    for (size_t i = 0; i < n; ++i, series += m)
+    uint32_t *data = inform_scratch(ws, p.workspace, p.histogram);
+    if (data == NULL)
     {
-        accumulate_observations(series, m, b, k, &states);
+        if (!ws->owned)
+        {
+            INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NAN);
+        }
+        // the dense histogram doesn't fit in memory, but the sparse one might
+        return sparse_block_entropy(series, n, m, b, k, err);
     }
 
-    double be = inform_shannon(&states, (double) b);
+    inform_dist states = inform_dist_view(data, states_size, N);
 
-    free(data);
+    struct ensemble const e = { series, m, b, k, states_size, NULL };
+    inform_accumulate_ensemble(accumulate_ensemble, &e, n, N, data, states_size);
 
-    return be;
+    return inform_shannon(&states, (double) b);
 }
 
 double *inform_local_block_entropy(int const *series, size_t n, size_t m, int b,
     size_t k, double *be, inform_error *err)
 {
-    if (check_arguments(series, n, m, b, k, err)) return NULL;
+    inform_workspace ws = { NULL, 0, false, true };
+    be = inform_local_block_entropy_ws(series, n, m, b, k, be, &ws, err);
+    inform_aligned_free(ws.buffer, ws.size);
+    return be;
+}
+
+double *inform_local_block_entropy_ws(int const *series, size_t n, size_t m,
+    int b, size_t k, double *be, inform_workspace *ws, inform_error *err)
+{
+    if (ws == NULL) return inform_local_block_entropy(series, n, m, b, k, be, err);
+
+    if (inform_check_history_args(series, n, m, b, k, k, err)) return NULL;
 
     size_t const N = n * (m - k + 1);
 
-    if (be == NULL)
+    // allocate the output only once the workspace is known to suffice, so
+    // that it isn't leaked if a borrowed workspace is too small
+    inform_workspace_plan const p = plan(n, m, b, k, true);
+    uint32_t *data = p.sparse ? NULL :
+        inform_scratch(ws, p.workspace, p.histogram);
+    if (data == NULL && !p.sparse && !ws->owned)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
+    double *out = (be == NULL) ? inform_malloc(N * sizeof(double)) : be;
+    if (out == NULL)
     {
-        be = malloc(N * sizeof(double));
-        if (be == NULL)
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
+    // fall back on sparse histograms if the support is too large for dense
+    // ones, or if they can't be allocated
+    if (data == NULL)
+    {
+        if (sparse_local_block_entropy(series, n, m, b, k, out, err) == NULL)
         {
-            INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+            if (out != be) inform_sized_free(out, N * sizeof(double));
+            return NULL;
         }
+        return out;
     }
 
-    size_t const states_size = (size_t) pow((double) b, (double) k);
+    uint64_t support;
+    inform_block_support(b, k, &support);
+    size_t const states_size = (size_t) support;
 
-    uint32_t *data = calloc(states_size, sizeof(uint32_t));
-    if (data == NULL)
+    uint64_t *state = inform_scratch_states(data, &p);
+
+    inform_dist states = inform_dist_view(data, states_size, N);
+
+    struct ensemble const e = { series, m, b, k, states_size, state };
+    inform_accumulate_ensemble(accumulate_ensemble, &e, n, N, data, states_size);
+
+    for (size_t i = 0; i < N; ++i)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+        out[i] = inform_shannon_si(&states, state[i], (double) b);
     }
 
-    inform_dist states = { data, states_size, N };
+    return out;
+}
 
-    int *state = malloc(N * sizeof(int));
-    if (state == NULL)
+/**
+ * Sort the cyclic rotations of `text`, a string of `T` symbols drawn from
+ * `[0, A)` whose last symbol is unique and the smallest, by prefix doubling
+ * with counting sorts. Since the last symbol is unique and the smallest,
+ * the rotations sort as the suffixes do.
+ *
+ * On return `sa` holds the suffix array and `rank` its inverse. The arrays
+ * `tmp` and `cls` must each hold `T` elements and `cnt` `max(A, T)`.
+ */
+static void suffix_array(size_t const *text, size_t T, size_t A, size_t *sa,
+    size_t *rank, size_t *tmp, size_t *cnt)
+{
+    size_t *cls = rank;
+    memset(cnt, 0, A * sizeof(size_t));
+    for (size_t i = 0; i < T; ++i)
+    {
+        cnt[text[i]]++;
+    }
+    for (size_t i = 1; i < A; ++i)
+    {
+        cnt[i] += cnt[i - 1];
+    }
+    for (size_t i = T; i-- > 0; )
+    {
+        sa[--cnt[text[i]]] = i;
+    }
+    size_t classes = 1;
+    cls[sa[0]] = 0;
+    for (size_t i = 1; i < T; ++i)
+    {
+        classes += (text[sa[i]] != text[sa[i - 1]]);
+        cls[sa[i]] = classes - 1;
+    }
+    for (size_t h = 1; h < T && classes < T; h *= 2)
+    {
+        // the rotations are already sorted by their second halves, so
+        // stably sorting by the first halves sorts them by both
+        for (size_t i = 0; i < T; ++i)
+        {
+            tmp[i] = (sa[i] >= h) ? sa[i] - h : sa[i] + T - h;
+        }
+        memset(cnt, 0, classes * sizeof(size_t));
+        for (size_t i = 0; i < T; ++i)
+        {
+            cnt[cls[tmp[i]]]++;
+        }
+        for (size_t i = 1; i < classes; ++i)
+        {
+            cnt[i] += cnt[i - 1];
+        }
+        for (size_t i = T; i-- > 0; )
+        {
+            sa[--cnt[cls[tmp[i]]]] = tmp[i];
+        }
+        // renumber the classes of the doubled prefixes, reusing tmp
+        tmp[sa[0]] = 0;
+        classes = 1;
+        for (size_t i = 1; i < T; ++i)
+        {
+            size_t const a = sa[i], b = sa[i - 1];
+            size_t const ah = (a + h < T) ? a + h : a + h - T;
+            size_t const bh = (b + h < T) ? b + h : b + h - T;
+            classes += (cls[a] != cls[b] || cls[ah] != cls[bh]);
+            tmp[a] = classes - 1;
+        }
+        memcpy(cls, tmp, T * sizeof(size_t));
+    }
+}
+
+/**
+ * Compute the longest common prefix of each pair of adjacent suffixes,
+ * `lcp[r]` being that of `sa[r]` and `sa[r + 1]`, by Kasai's algorithm.
+ */
+static void longest_common_prefixes(size_t const *text, size_t T,
+    size_t const *sa, size_t const *rank, size_t *lcp)
+{
+    size_t h = 0;
+    for (size_t i = 0; i < T; ++i)
+    {
+        if (rank[i] + 1 == T)
+        {
+            h = 0;
+            continue;
+        }
+        size_t const j = sa[rank[i] + 1];
+        while (i + h < T && j + h < T && text[i + h] == text[j + h])
+        {
+            ++h;
+        }
+        lcp[rank[i]] = h;
+        if (h > 0)
+        {
+            --h;
+        }
+    }
+    lcp[T - 1] = 0;
+}
+
+double *inform_block_entropy_sweep(int const *series, size_t n, size_t m,
+    int b, size_t K, double *be, inform_error *err)
+{
+    if (inform_check_history_args(series, n, m, b, 1, 1, err)) return NULL;
+
+    if (K == 0)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EKZERO, NULL);
+    }
+    else if (m <= K)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EKLONG, NULL);
+    }
+
+    // the text is the series, each followed by a terminator of its own so
+    // that no common prefix runs from one series into the next, and then a
+    // sentinel which is smaller than all of them
+    if (n > (SIZE_MAX / (6 * sizeof(size_t)) - 1) / (m + 1))
     {
         INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
     }
+    size_t const T = n * (m + 1) + 1;
+    size_t const A = n + 1 + (size_t) b;
+    size_t *text = inform_malloc(5 * T * sizeof(size_t));
+    size_t *cnt = inform_malloc(((A > T) ? A : T) * sizeof(size_t));
+    double *S = inform_calloc(K + 2, sizeof(double));
+    double *out = (be == NULL) ? inform_malloc(K * sizeof(double)) : be;
+    if (text == NULL || cnt == NULL || S == NULL || out == NULL)
+    {
+        if (out != be) inform_sized_free(out, K * sizeof(double));
+        inform_sized_free(S, (K + 2) * sizeof(double));
+        inform_sized_free(cnt, ((A > T) ? A : T) * sizeof(size_t));
+        inform_sized_free(text, 5 * T * sizeof(size_t));
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+    size_t *sa = text + T, *rank = sa + T, *tmp = rank + T, *lcp = tmp + T;
 
-    int const *series_ptr = series;
-    int *state_ptr = state;
+    size_t t = 0;
     for (size_t i = 0; i < n; ++i)
     {
-        accumulate_local_observations(series_ptr, m, b, k, &states, state_ptr);
-        series_ptr += m;
-        state_ptr += (m - k + 1);
+        for (size_t j = 0; j < m; ++j)
+        {
+            text[t++] = n + 1 + (size_t) series[i * m + j];
+        }
+        text[t++] = i + 1;
     }
+    text[t] = 0;
 
-    for (size_t i = 0; i < N; ++i)
+    suffix_array(text, T, A, sa, rank, tmp, cnt);
+    longest_common_prefixes(text, T, sa, rank, lcp);
+
+    // walk the tree of lcp-intervals bottom up: an interval of c suffixes
+    // which share exactly l states, inside one which shares p < l, is the
+    // run of occurrences of a single block of each length in (p, l], and so
+    // adds c log2(c) to the sum of c log2(c) for each of those lengths
+    size_t *depth = tmp, *left = cnt, top = 0;
+    depth[0] = 0;
+    left[0] = 0;
+    for (size_t r = 0; r < T; ++r)
     {
-        be[i] = inform_shannon_si(&states, state[i], (double) b);
+        size_t const l = lcp[r];
+        size_t lb = r;
+        while (l < depth[top])
+        {
+            size_t const c = r - left[top] + 1;
+            size_t const hi = (depth[top] < K) ? depth[top] : K;
+            lb = left[top--];
+            size_t const lo = (l > depth[top]) ? l : depth[top];
+            if (lo < hi)
+            {
+                double const clogc = inform_clogc(c);
+                S[lo + 1] += clogc;
+                S[hi + 1] -= clogc;
+            }
+        }
+        if (l > depth[top])
+        {
+            ++top;
+            depth[top] = l;
+            left[top] = lb;
+        }
     }
 
-    free(state);
-    free(data);
+    double const base = log2((double) b);
+    double sum = 0.0;
+    for (size_t k = 1; k <= K; ++k)
+    {
+        sum += S[k];
+        double const N = (double) (n * (m - k + 1));
+        out[k - 1] = (log2(N) - sum / N) / base;
+    }
 
-    return be;
+    inform_sized_free(S, (K + 2) * sizeof(double));
+    inform_sized_free(cnt, ((A > T) ? A : T) * sizeof(size_t));
+    inform_sized_free(text, 5 * T * sizeof(size_t));
+
+    return out;
 }
@@ -3,6 +3,26 @@
 // license that can be found in the LICENSE file.
 #include <inform/conditional_entropy.h>
 #include <inform/shannon.h>
+#include "counters.h"
+#include "memory.h"
+#include "scratch.h"
+
+static bool check_shape(size_t n, int bx, int by, inform_error *err)
+{
+    if (n < 1)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ESHORTSERIES, true);
+    }
+    else if (bx < 2)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EBASE, true);
+    }
+    else if (by < 2)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EBASE, true);
+    }
+    return false;
+}
 
 static bool check_arguments(int const *xs, int const *ys, size_t n, int bx,
     int by, inform_error *err)
@@ -15,17 +35,9 @@ static bool check_arguments(int const *xs, int const *ys, size_t n, int bx,
     {
         INFORM_ERROR_RETURN(err, INFORM_ETIMESERIES, true);
     }
-    else if (n < 1)
-    {
-        INFORM_ERROR_RETURN(err, INFORM_ESHORTSERIES, true);
-    }
-    else if (bx < 2)
+    else if (check_shape(n, bx, by, err))
     {
-        INFORM_ERROR_RETURN(err, INFORM_EBASE, true);
-    }
-    else if (by < 2)
-    {
-        INFORM_ERROR_RETURN(err, INFORM_EBASE, true);
+        return true;
     }
     for (size_t i = 0; i < n; ++i)
     {
@@ -41,21 +53,6 @@ static bool check_arguments(int const *xs, int const *ys, size_t n, int bx,
     return false;
 }
 
-inline static bool allocate(int bx, int by, inform_dist **x, inform_dist **xy,
-    inform_error *err)
-{
-    if ((*x = inform_dist_alloc(bx)) == NULL)
-    {
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, true);
-    }
-    if ((*xy = inform_dist_alloc(bx * by)) == NULL)
-    {
-        inform_dist_free(*x);
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, true);
-    }
-    return false;
-}
-
 inline static void accumulate(int const *xs, int const *ys, size_t n, int by,
     inform_dist *x, inform_dist *xy)
 {
@@ -69,53 +66,118 @@ inline static void accumulate(int const *xs, int const *ys, size_t n, int by,
     }
 }
 
-inline static void free_all(inform_dist **x, inform_dist **xy)
+static inform_workspace_plan plan(size_t n, int bx, int by, bool local)
 {
-    inform_dist_free(*x);
-    inform_dist_free(*xy);
+    size_t const total_size = bx + (size_t) bx * by;
+    if (local)
+    {
+        return inform_plan_dense(total_size, 0, (size_t) bx * by, n);
+    }
+    return inform_plan_dense(total_size, 0, 0, 0);
+}
+
+inform_workspace_plan inform_conditional_entropy_plan(size_t n, int bx, int by,
+    inform_error *err)
+{
+    inform_workspace_plan p = { 0, 0, 0, 0, false };
+    if (check_shape(n, bx, by, err)) return p;
+    return plan(n, bx, by, false);
+}
+
+inform_workspace_plan inform_local_conditional_entropy_plan(size_t n, int bx, int by,
+    inform_error *err)
+{
+    inform_workspace_plan p = { 0, 0, 0, 0, false };
+    if (check_shape(n, bx, by, err)) return p;
+    return plan(n, bx, by, true);
 }
 
 double inform_conditional_entropy(int const *xs, int const *ys, size_t n,
     int bx, int by, double b, inform_error *err)
 {
+    inform_workspace ws = { NULL, 0, false, true };
+    double const ce = inform_conditional_entropy_ws(xs, ys, n, bx, by, b, &ws, err);
+    inform_aligned_free(ws.buffer, ws.size);
+    return ce;
+}
+
+double inform_conditional_entropy_ws(int const *xs, int const *ys, size_t n,
+    int bx, int by, double b, inform_workspace *ws, inform_error *err)
+{
+    if (ws == NULL) return inform_conditional_entropy(xs, ys, n, bx, by, b, err);
+
     if (check_arguments(xs, ys, n, bx, by, err)) return NAN;
 
-    inform_dist *x = NULL, *xy = NULL;
-    if (allocate(bx, by, &x, &xy, err)) return NAN;
+    inform_workspace_plan const p = plan(n, bx, by, false);
 
-    accumulate(xs, ys, n, by, x, xy);
+    uint32_t *data = inform_scratch(ws, p.workspace, p.histogram);
+    if (data == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NAN);
+    }
 
-    double ce = inform_shannon_ce(xy, x, (double) b);
+    inform_dist x  = inform_dist_view(data, bx, 0);
+    inform_dist xy = inform_dist_view(data + bx, (size_t) bx * by, 0);
 
-    free_all(&x, &xy);
+    accumulate(xs, ys, n, by, &x, &xy);
 
-    return ce;
+    return inform_shannon_ce(&xy, &x, (double) b);
 }
 
 double *inform_local_conditional_entropy(int const *xs, int const *ys,
     size_t n, int bx, int by, double b, double *ce, inform_error *err)
 {
+    inform_workspace ws = { NULL, 0, false, true };
+    ce = inform_local_conditional_entropy_ws(xs, ys, n, bx, by, b, ce, &ws, err);
+    inform_aligned_free(ws.buffer, ws.size);
+    return ce;
+}
+
+double *inform_local_conditional_entropy_ws(int const *xs, int const *ys,
+    size_t n, int bx, int by, double b, double *ce, inform_workspace *ws,
+    inform_error *err)
+{
+    if (ws == NULL) return inform_local_conditional_entropy(xs, ys, n, bx, by, b, ce, err);
+
     if (check_arguments(xs, ys, n, bx, by, err)) return NULL;
 
+    inform_workspace_plan const p = plan(n, bx, by, true);
+
+    uint32_t *data = inform_scratch(ws, p.workspace, p.histogram);
+    if (data == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
     if (ce == NULL)
     {
-        ce = malloc(n * sizeof(double));
+        ce = inform_malloc(n * sizeof(double));
         if (ce == NULL)
             INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
     }
+    double *local = inform_scratch_table(data, &p, 0);
 
-    inform_dist *x = NULL, *xy = NULL;
-    if (allocate(bx, by, &x, &xy, err)) return NULL;
+    inform_dist x  = inform_dist_view(data, bx, 0);
+    inform_dist xy = inform_dist_view(data + bx, (size_t) bx * by, 0);
 
-    accumulate(xs, ys, n, by, x, xy);
+    accumulate(xs, ys, n, by, &x, &xy);
 
+    // compute the local conditional entropy once for each observed state
+    for (int i = 0; i < bx; ++i)
+    {
+        for (int j = 0; j < by; ++j)
+        {
+            int z = i*by + j;
+            if (xy.histogram[z] != 0)
+            {
+                local[z] = inform_shannon_pce(&xy, &x, z, i, (double) b);
+            }
+        }
+    }
     for (size_t i = 0; i < n; ++i)
     {
-        int z = xs[i]*by + ys[i];
-        ce[i] = inform_shannon_pce(xy, x, z, xs[i], (double) b);
+        ce[i] = local[xs[i]*by + ys[i]];
     }
 
-    free_all(&x, &xy);
-
     return ce;
-}
\ No newline at end of file
+}
@@ -0,0 +1,129 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/dist.h>
+#include "memory.h"
+
+/**
+ * Get the number of bytes in a counter of a given width.
+ */
+inline static size_t inform_counter_bytes(inform_counter_width width)
+{
+    switch (width)
+    {
+        case INFORM_COUNTER_8:  return sizeof(uint8_t);
+        case INFORM_COUNTER_16: return sizeof(uint16_t);
+        case INFORM_COUNTER_64: return sizeof(uint64_t);
+        default:                return sizeof(uint32_t);
+    }
+}
+
+/**
+ * Get the largest count a counter of a given width can hold.
+ */
+inline static uint64_t inform_counter_max(inform_counter_width width)
+{
+    switch (width)
+    {
+        case INFORM_COUNTER_8:  return UINT8_MAX;
+        case INFORM_COUNTER_16: return UINT16_MAX;
+        case INFORM_COUNTER_64: return UINT64_MAX;
+        default:                return UINT32_MAX;
+    }
+}
+
+/**
+ * Get the `i`-th of an array of counters of a given width.
+ */
+inline static uint64_t inform_counter_get(void const *counters,
+    inform_counter_width width, size_t i)
+{
+    switch (width)
+    {
+        case INFORM_COUNTER_8:  return ((uint8_t const *) counters)[i];
+        case INFORM_COUNTER_16: return ((uint16_t const *) counters)[i];
+        case INFORM_COUNTER_64: return ((uint64_t const *) counters)[i];
+        default:                return ((uint32_t const *) counters)[i];
+    }
+}
+
+/**
+ * Set the `i`-th of an array of counters of a given width, truncating the
+ * count to the width of the counter.
+ */
+inline static void inform_counter_set(void *counters,
+    inform_counter_width width, size_t i, uint64_t x)
+{
+    switch (width)
+    {
+        case INFORM_COUNTER_8:  ((uint8_t *) counters)[i] = (uint8_t) x; break;
+        case INFORM_COUNTER_16: ((uint16_t *) counters)[i] = (uint16_t) x; break;
+        case INFORM_COUNTER_64: ((uint64_t *) counters)[i] = x; break;
+        default:                ((uint32_t *) counters)[i] = (uint32_t) x; break;
+    }
+}
+
+/**
+ * Make a distribution of 32-bit counters over an existing histogram, e.g. a
+ * region of a workspace. The distribution must not be freed.
+ */
+inline static inform_dist inform_dist_view(uint32_t *histogram, size_t size,
+    uint64_t counts)
+{
+    inform_dist dist;
+    dist.histogram = histogram;
+    dist.size = size;
+    dist.counts = counts;
+    dist.width = INFORM_COUNTER_32;
+    dist.adaptive = false;
+    dist.nonzero = NULL;
+    dist.nonzero_size = 0;
+    dist.nonzero_capacity = 0;
+    dist.track_entropy = false;
+    dist.clogc = 0.;
+    dist.clogc_error = 0.;
+    dist.pooled = false;
+    return dist;
+}
+
+/**
+ * A distribution taken from a pool, which shares one aligned block with its
+ * counters. The counters begin INFORM_POOLED_HEADER bytes into the block.
+ */
+typedef struct inform_pooled_dist
+{
+    /// the distribution itself
+    inform_dist dist;
+    /// the size of the block in bytes
+    size_t bytes;
+    /// the next free block of the same size, while the block is in the pool
+    struct inform_pooled_dist *next;
+} inform_pooled_dist;
+
+/// the bytes of a pooled block which precede its counters
+#define INFORM_POOLED_HEADER ((sizeof(inform_pooled_dist) + \
+    INFORM_ALIGNMENT - 1) & ~(size_t)(INFORM_ALIGNMENT - 1))
+
+/**
+ * Whether the counters of a distribution were allocated on their own, rather
+ * than in the distribution's pooled block.
+ */
+inline static bool inform_dist_owns_counters(inform_dist const *dist)
+{
+    return !dist->pooled ||
+        dist->counters != (char const *) dist + INFORM_POOLED_HEADER;
+}
+
+/**
+ * Free the counters of a distribution, unless they live in its pooled block.
+ */
+inline static void inform_dist_release_counters(inform_dist *dist)
+{
+    if (inform_dist_owns_counters(dist))
+    {
+        inform_aligned_free(dist->counters,
+            dist->size * inform_counter_bytes(dist->width));
+    }
+}
@@ -0,0 +1,132 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <inform/decay_dist.h>
+#include <string.h>
+#include "memory.h"
+
+/// the scale beyond which every weight is rescaled
+#define RESCALE_LIMIT 0x1p256
+
+inform_decay_dist *inform_decay_dist_alloc(size_t n, double decay)
+{
+    // the negated comparison also rejects a NaN decay
+    if (n == 0 || !(decay > 0. && decay <= 1.))
+    {
+        return NULL;
+    }
+    inform_decay_dist *dist = inform_malloc(sizeof(inform_decay_dist));
+    if (dist != NULL)
+    {
+        dist->weights = inform_aligned_calloc(n, sizeof(double));
+        if (dist->weights == NULL)
+        {
+            inform_sized_free(dist, sizeof(inform_decay_dist));
+            return NULL;
+        }
+        dist->size = n;
+        dist->decay = decay;
+        dist->unit = 1.;
+        dist->total = 0.;
+    }
+    return dist;
+}
+
+void inform_decay_dist_free(inform_decay_dist *dist)
+{
+    if (dist != NULL)
+    {
+        inform_aligned_free(dist->weights, dist->size * sizeof(double));
+        inform_sized_free(dist, sizeof(inform_decay_dist));
+    }
+}
+
+size_t inform_decay_dist_size(inform_decay_dist const *dist)
+{
+    return (dist == NULL) ? 0 : dist->size;
+}
+
+double inform_decay_dist_weight(inform_decay_dist const *dist)
+{
+    return (dist == NULL) ? 0. : dist->total / dist->unit;
+}
+
+bool inform_decay_dist_is_valid(inform_decay_dist const *dist)
+{
+    return dist != NULL && dist->total > 0.;
+}
+
+double inform_decay_dist_get(inform_decay_dist const *dist, size_t event)
+{
+    if (dist == NULL || event >= dist->size)
+    {
+        return 0.;
+    }
+    return dist->weights[event] / dist->unit;
+}
+
+/**
+ * Bring the scale of the weights back down to one.
+ */
+static void rescale(inform_decay_dist *dist)
+{
+    double const factor = 1. / dist->unit;
+    for (size_t i = 0; i < dist->size; ++i)
+    {
+        dist->weights[i] *= factor;
+    }
+    dist->total *= factor;
+    dist->unit = 1.;
+}
+
+double inform_decay_dist_tick(inform_decay_dist *dist, size_t event)
+{
+    if (dist == NULL || event >= dist->size)
+    {
+        return 0.;
+    }
+    // decaying every earlier observation is the same as weighing this one,
+    // and every later one, more heavily than the last
+    dist->unit /= dist->decay;
+    if (dist->unit > RESCALE_LIMIT)
+    {
+        rescale(dist);
+    }
+    dist->weights[event] += dist->unit;
+    dist->total += dist->unit;
+    return dist->weights[event] / dist->unit;
+}
+
+void inform_decay_dist_clear(inform_decay_dist *dist)
+{
+    if (dist != NULL)
+    {
+        memset(dist->weights, 0, dist->size * sizeof(double));
+        dist->unit = 1.;
+        dist->total = 0.;
+    }
+}
+
+double inform_decay_dist_prob(inform_decay_dist const *dist, size_t event)
+{
+    if (!inform_decay_dist_is_valid(dist) || event >= dist->size)
+    {
+        return 0.;
+    }
+    // the scale cancels out of the ratio
+    return dist->weights[event] / dist->total;
+}
+
+size_t inform_decay_dist_dump(inform_decay_dist const *dist, double *probs,
+    size_t n)
+{
+    if (dist == NULL || probs == NULL || n != dist->size)
+    {
+        return 0;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        probs[i] = inform_decay_dist_prob(dist, i);
+    }
+    return n;
+}
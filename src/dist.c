@@ -2,33 +2,54 @@
 // Use of this source code is governed by a MIT
 // license that can be found in the LICENSE file.
 #include <inform/dist.h>
+#include <math.h>
 #include <string.h>
+#include "counters.h"
+#include "kernels.h"
+#include "memory.h"
 
 inform_dist* inform_dist_alloc(size_t n)
 {
-    // if the requested support size is zero, return NULL
-    if (n == 0)
+    return inform_dist_alloc_width(n, INFORM_COUNTER_32);
+}
+
+inform_dist* inform_dist_alloc_width(size_t n, inform_counter_width width)
+{
+    // if the requested support size is zero or the width is unknown,
+    // return NULL
+    if (n == 0 || width < INFORM_COUNTER_32 || width > INFORM_COUNTER_64)
     {
         return NULL;
     }
     // allocate the distribution
-    inform_dist *dist = malloc(sizeof(inform_dist));
+    inform_dist *dist = inform_malloc(sizeof(inform_dist));
     // if the allocation succeeded
     if (dist != NULL)
     {
         // allocate the underlying histogram
-        dist->histogram = calloc(n, sizeof(uint32_t));
+        dist->counters = inform_aligned_calloc(n, inform_counter_bytes(width));
         // if the allocation succeeded
-        if (dist->histogram != NULL)
+        if (dist->counters != NULL)
         {
-            // set the distribution size and counts
-            dist->size   = n;
-            dist->counts = 0;
+            // set the distribution size, counts and counter width
+            dist->size     = n;
+            dist->counts   = 0;
+            dist->width    = width;
+            dist->adaptive = (width == INFORM_COUNTER_8 ||
+                width == INFORM_COUNTER_16);
+            // don't track the nonzero events unless asked to
+            dist->nonzero          = NULL;
+            dist->nonzero_size     = 0;
+            dist->nonzero_capacity = 0;
+            dist->track_entropy    = false;
+            dist->clogc            = 0.;
+            dist->clogc_error      = 0.;
+            dist->pooled           = false;
         }
         // otherwise free the distribution
         else
         {
-            free(dist);
+            inform_sized_free(dist, sizeof(inform_dist));
             dist = NULL;
         }
     }
@@ -36,6 +57,43 @@ inform_dist* inform_dist_alloc(size_t n)
     return dist;
 }
 
+/**
+ * Add a change in the `c log2(c)` of a count to a distribution's running
+ * sum.
+ */
+inline static void add_clogc(inform_dist *dist, double x)
+{
+    // Neumaier's compensated summation keeps the rounding error from
+    // building up over a long stream of observations
+    double const t = dist->clogc + x;
+    if (fabs(dist->clogc) >= fabs(x))
+    {
+        dist->clogc_error += (dist->clogc - t) + x;
+    }
+    else
+    {
+        dist->clogc_error += (x - t) + dist->clogc;
+    }
+    dist->clogc = t;
+}
+
+/**
+ * Recompute a distribution's running sum of `c log2(c)` from scratch.
+ */
+static void sync_clogc(inform_dist *dist)
+{
+    dist->clogc = 0.;
+    dist->clogc_error = 0.;
+    for (size_t i = 0; i < dist->size; ++i)
+    {
+        uint64_t const x = inform_counter_get(dist->counters, dist->width, i);
+        if (x > 1)
+        {
+            add_clogc(dist, inform_clogc(x));
+        }
+    }
+}
+
 inform_dist* inform_dist_realloc(inform_dist *dist, size_t n)
 {
     // if the requested size is zero, return the original distribution
@@ -47,35 +105,54 @@ inform_dist* inform_dist_realloc(inform_dist *dist, size_t n)
     // from the current size
     if (dist != NULL && dist->size != n)
     {
-        // realloc the histogram
-        uint32_t *histogram = realloc(dist->histogram, n * sizeof(uint32_t));
-        // if the reallocation succeeded
-        if (histogram != NULL)
+        // resize the histogram, keeping it aligned, which also zeros out all
+        // of the newly observable events
+        size_t const bytes = inform_counter_bytes(dist->width);
+        size_t const old_size = dist->size;
+        void *counters = NULL;
+        if (inform_dist_owns_counters(dist))
+        {
+            counters = inform_aligned_realloc(dist->counters,
+                dist->size * bytes, n * bytes);
+        }
+        // counters in a pooled block can't be resized in place, so they move
+        // out into a histogram of their own
+        else if ((counters = inform_aligned_calloc(n, bytes)) != NULL)
+        {
+            memcpy(counters, dist->counters,
+                ((n < dist->size) ? n : dist->size) * bytes);
+        }
+        // if the allocation succeeded
+        if (counters != NULL)
         {
             // reset the distribution's histogram to the new histogram
-            dist->histogram = histogram;
+            dist->counters = counters;
             // if the histogram was shrunken
             if (n < dist->size)
             {
-                // set the new distribution size
-                dist->size = n;
                 // sum up the counts that are in the smaller support
                 dist->counts = 0;
-                for (size_t i = 0; i < dist->size; ++i)
+                for (size_t i = 0; i < n; ++i)
                 {
-                    dist->counts += dist->histogram[i];
+                    dist->counts += inform_counter_get(counters, dist->width, i);
                 }
-            }
-            // otherwise
-            else
-            {
-                // zero out all of the newly observable events
-                for (size_t i = dist->size; i < n; ++i)
+                // forget the nonzero events which are no longer observable
+                size_t m = 0;
+                for (size_t i = 0; i < dist->nonzero_size; ++i)
                 {
-                    dist->histogram[i] = 0;
+                    if (dist->nonzero[i] < n)
+                    {
+                        dist->nonzero[m++] = dist->nonzero[i];
+                    }
                 }
-                // set the size of the distribution
-                dist->size = n;
+                dist->nonzero_size = m;
+            }
+            // set the new distribution size
+            dist->size = n;
+            // the events which were cut off no longer contribute
+            if (dist->track_entropy && n < old_size)
+            {
+                sync_clogc(dist);
             }
         }
         // otherwise
@@ -102,29 +179,68 @@ inform_dist* inform_dist_copy(inform_dist const *src, inform_dist *dest)
     {
         return NULL;
     }
-    // if the destination is NULL or the destination size is not the same
-    // as the source
-    else if (dest == NULL || src->size != dest->size)
+    // don't copy the source to itself
+    else if (src == dest)
+    {
+        return dest;
+    }
+    // if the source tracks its nonzero events, so will the destination
+    size_t *nonzero = NULL;
+    if (src->nonzero != NULL)
     {
-        // reallocate the destination
-        inform_dist *redest = inform_dist_realloc(dest, src->size);
+        nonzero = inform_aligned_calloc(src->nonzero_capacity, sizeof(size_t));
+        if (nonzero == NULL)
+        {
+            return NULL;
+        }
+        memcpy(nonzero, src->nonzero, src->nonzero_size * sizeof(size_t));
+    }
+    // if the destination is NULL, allocate one like the source
+    if (dest == NULL)
+    {
+        dest = inform_dist_alloc_width(src->size, src->width);
         // return NULL if the allocation fails
-        if (redest == NULL)
+        if (dest == NULL)
         {
+            inform_aligned_free(nonzero,
+                src->nonzero_capacity * sizeof(size_t));
             return NULL;
         }
-        // point dest at the new distribution
-        dest = redest;
     }
-    // don't copy the source to itself
-    else if (src == dest)
+    // if the destination's size or counter width is not the same as the
+    // source's
+    else if (src->size != dest->size || src->width != dest->width)
     {
-        return dest;
+        // replace the destination's histogram
+        void *counters = inform_aligned_calloc(src->size,
+            inform_counter_bytes(src->width));
+        // return NULL, leaving the destination unscathed, if the allocation
+        // fails
+        if (counters == NULL)
+        {
+            inform_aligned_free(nonzero,
+                src->nonzero_capacity * sizeof(size_t));
+            return NULL;
+        }
+        inform_dist_release_counters(dest);
+        dest->counters = counters;
+        dest->size = src->size;
+        dest->width = src->width;
     }
     // copy the contents of the histogram from the source to the destination
-    memcpy(dest->histogram, src->histogram, src->size * sizeof(uint32_t));
-    // set the counts appropriately
+    memcpy(dest->counters, src->counters,
+        src->size * inform_counter_bytes(src->width));
+    // set the counts and the counter behavior appropriately
     dest->counts = src->counts;
+    dest->adaptive = src->adaptive;
+    inform_aligned_free(dest->nonzero,
+        dest->nonzero_capacity * sizeof(size_t));
+    dest->nonzero = nonzero;
+    dest->nonzero_size = src->nonzero_size;
+    dest->nonzero_capacity = (nonzero == NULL) ? 0 : src->nonzero_capacity;
+    dest->track_entropy = src->track_entropy;
+    dest->clogc = src->clogc;
+    dest->clogc_error = src->clogc_error;
     // return the modified destination
     return dest;
 }
@@ -137,7 +253,7 @@ inform_dist* inform_dist_dup(inform_dist const *dist)
         return NULL;
     }
     // allocate the new distribution
-    inform_dist *dup = inform_dist_alloc(dist->size);
+    inform_dist *dup = inform_dist_alloc_width(dist->size, dist->width);
     // if the allocation succeeded
     if (dup != NULL)
     {
@@ -156,19 +272,28 @@ inform_dist* inform_dist_create(uint32_t const *data, size_t n)
         return NULL;
     }
     // allocate the distribution
-    inform_dist *dist = malloc(sizeof(inform_dist));
+    inform_dist *dist = inform_malloc(sizeof(inform_dist));
     // if the allocation succeeded
     if (dist != NULL)
     {
         // allocate the underlying histogram
-        dist->histogram = calloc(n, sizeof(uint32_t));
+        dist->histogram = inform_aligned_calloc(n, sizeof(uint32_t));
         // if the allocation succeeded
         if (dist->histogram != NULL)
         {
             // set the distribution content, size and counts
             memcpy(dist->histogram, data, n*sizeof(uint32_t));
-            dist->size   = n;
-            dist->counts = 0;
+            dist->size     = n;
+            dist->counts   = 0;
+            dist->width    = INFORM_COUNTER_32;
+            dist->adaptive = false;
+            dist->nonzero          = NULL;
+            dist->nonzero_size     = 0;
+            dist->nonzero_capacity = 0;
+            dist->track_entropy    = false;
+            dist->clogc            = 0.;
+            dist->clogc_error      = 0.;
+            dist->pooled           = false;
             for (size_t i = 0; i < n; ++i)
             {
                 dist->counts += dist->histogram[i];
@@ -177,7 +302,7 @@ inform_dist* inform_dist_create(uint32_t const *data, size_t n)
         // otherwise free the distribution
         else
         {
-            free(dist);
+            inform_sized_free(dist, sizeof(inform_dist));
             dist = NULL;
         }
     }
@@ -191,10 +316,187 @@ void inform_dist_free(inform_dist *dist)
     {
         if (dist->histogram != NULL)
         {
-            free(dist->histogram);
+            inform_dist_release_counters(dist);
+        }
+        inform_aligned_free(dist->nonzero,
+            dist->nonzero_capacity * sizeof(size_t));
+        // a pooled distribution is freed along with the rest of its block
+        if (dist->pooled)
+        {
+            inform_aligned_free(dist, ((inform_pooled_dist *) dist)->bytes);
+        }
+        else
+        {
+            inform_sized_free(dist, sizeof(inform_dist));
+        }
+    }
+}
+
+/**
+ * Ensure that the list of nonzero events can hold at least `n` events.
+ *
+ * Returns `true`, leaving the list unscathed, if the allocation fails.
+ */
+static bool reserve_nonzero(inform_dist *dist, size_t n)
+{
+    if (n <= dist->nonzero_capacity)
+    {
+        return false;
+    }
+    // grow geometrically, but never beyond the size of the support
+    size_t capacity = (dist->nonzero_capacity < 8) ? 16 :
+        2 * dist->nonzero_capacity;
+    capacity = (capacity < n) ? n : capacity;
+    capacity = (capacity > dist->size) ? dist->size : capacity;
+    size_t *nonzero = inform_aligned_realloc(dist->nonzero,
+        dist->nonzero_capacity * sizeof(size_t), capacity * sizeof(size_t));
+    if (nonzero == NULL)
+    {
+        return true;
+    }
+    dist->nonzero = nonzero;
+    dist->nonzero_capacity = capacity;
+    return false;
+}
+
+/**
+ * Add an event which has just gained a nonzero count to the list of nonzero
+ * events.
+ *
+ * Returns `true`, leaving the list unscathed, if the allocation fails.
+ */
+static bool add_nonzero(inform_dist *dist, size_t event)
+{
+    if (reserve_nonzero(dist, dist->nonzero_size + 1))
+    {
+        return true;
+    }
+    dist->nonzero[dist->nonzero_size++] = event;
+    return false;
+}
+
+/**
+ * Remove an event whose count has just dropped to zero from the list of
+ * nonzero events.
+ */
+static void remove_nonzero(inform_dist *dist, size_t event)
+{
+    for (size_t i = 0; i < dist->nonzero_size; ++i)
+    {
+        if (dist->nonzero[i] == event)
+        {
+            dist->nonzero[i] = dist->nonzero[--dist->nonzero_size];
+            return;
+        }
+    }
+}
+
+/**
+ * Remove every event whose count is zero from the list of nonzero events.
+ */
+static void prune_nonzero(inform_dist *dist)
+{
+    size_t m = 0;
+    for (size_t i = 0; i < dist->nonzero_size; ++i)
+    {
+        size_t const event = dist->nonzero[i];
+        if (inform_counter_get(dist->counters, dist->width, event) != 0)
+        {
+            dist->nonzero[m++] = event;
         }
-        free(dist);
     }
+    dist->nonzero_size = m;
+}
+
+inform_dist* inform_dist_track_nonzero(inform_dist *dist, bool enable)
+{
+    if (dist == NULL)
+    {
+        return NULL;
+    }
+    if (!enable)
+    {
+        inform_aligned_free(dist->nonzero,
+            dist->nonzero_capacity * sizeof(size_t));
+        dist->nonzero = NULL;
+        dist->nonzero_size = 0;
+        dist->nonzero_capacity = 0;
+    }
+    else if (dist->nonzero == NULL)
+    {
+        // find the events which have already been observed
+        size_t m = 0;
+        for (size_t i = 0; i < dist->size; ++i)
+        {
+            m += (inform_counter_get(dist->counters, dist->width, i) != 0);
+        }
+        if (reserve_nonzero(dist, (m == 0) ? 1 : m))
+        {
+            return NULL;
+        }
+        for (size_t i = 0; i < dist->size; ++i)
+        {
+            if (inform_counter_get(dist->counters, dist->width, i) != 0)
+            {
+                dist->nonzero[dist->nonzero_size++] = i;
+            }
+        }
+    }
+    return dist;
+}
+
+size_t const *inform_dist_nonzero(inform_dist const *dist, size_t *n)
+{
+    if (dist == NULL || dist->nonzero == NULL)
+    {
+        if (n != NULL)
+        {
+            *n = 0;
+        }
+        return NULL;
+    }
+    if (n != NULL)
+    {
+        *n = dist->nonzero_size;
+    }
+    return dist->nonzero;
+}
+
+inform_dist* inform_dist_track_entropy(inform_dist *dist, bool enable)
+{
+    if (dist == NULL)
+    {
+        return NULL;
+    }
+    dist->track_entropy = enable;
+    if (enable)
+    {
+        sync_clogc(dist);
+    }
+    return dist;
+}
+
+void inform_dist_clear(inform_dist *dist)
+{
+    if (dist == NULL)
+    {
+        return;
+    }
+    if (dist->nonzero != NULL)
+    {
+        for (size_t i = 0; i < dist->nonzero_size; ++i)
+        {
+            inform_counter_set(dist->counters, dist->width, dist->nonzero[i], 0);
+        }
+        dist->nonzero_size = 0;
+    }
+    else
+    {
+        memset(dist->counters, 0, dist->size * inform_counter_bytes(dist->width));
+    }
+    dist->counts = 0;
+    dist->clogc = 0.;
+    dist->clogc_error = 0.;
 }
 
 size_t inform_dist_size(inform_dist const *dist)
@@ -220,7 +522,73 @@ uint32_t inform_dist_get(inform_dist const *dist, size_t event)
         return 0;
     }
     // otherwise return the number of occurances of the event
-    return dist->histogram[event];
+    uint64_t const x = inform_counter_get(dist->counters, dist->width, event);
+    return (x > UINT32_MAX) ? UINT32_MAX : (uint32_t) x;
+}
+
+uint64_t inform_dist_get64(inform_dist const *dist, size_t event)
+{
+    // if the distribution is NULL or the event is outsize of the support
+    if (dist == NULL || event >= dist->size)
+    {
+        return 0;
+    }
+    return inform_counter_get(dist->counters, dist->width, event);
+}
+
+inform_counter_width inform_dist_width(inform_dist const *dist)
+{
+    return (dist == NULL) ? INFORM_COUNTER_32 : dist->width;
+}
+
+/**
+ * Convert every counter of a distribution to a given, wider width.
+ *
+ * Returns `true`, leaving the distribution unscathed, if the allocation
+ * fails.
+ */
+static bool widen(inform_dist *dist, inform_counter_width width)
+{
+    void *counters = inform_aligned_calloc(dist->size,
+        inform_counter_bytes(width));
+    if (counters == NULL)
+    {
+        return true;
+    }
+    for (size_t i = 0; i < dist->size; ++i)
+    {
+        inform_counter_set(counters, width, i,
+            inform_counter_get(dist->counters, dist->width, i));
+    }
+    inform_dist_release_counters(dist);
+    dist->counters = counters;
+    dist->width = width;
+    return false;
+}
+
+/**
+ * Ensure that the counters of a distribution can hold a count of `x`,
+ * promoting them if they are adaptive.
+ *
+ * Returns `true` if the counters are adaptive but can't be promoted.
+ */
+static bool make_room(inform_dist *dist, uint64_t x)
+{
+    if (!dist->adaptive || x <= inform_counter_max(dist->width))
+    {
+        return false;
+    }
+    // promote to the narrowest width which holds the count
+    inform_counter_width width = INFORM_COUNTER_64;
+    if (x <= UINT16_MAX)
+    {
+        width = INFORM_COUNTER_16;
+    }
+    else if (x <= UINT32_MAX)
+    {
+        width = INFORM_COUNTER_32;
+    }
+    return widen(dist, width);
 }
 
 uint32_t inform_dist_set(inform_dist *dist, size_t event, uint32_t x)
@@ -230,12 +598,35 @@ uint32_t inform_dist_set(inform_dist *dist, size_t event, uint32_t x)
     {
         return 0;
     }
+    // make sure the counter is wide enough
+    if (make_room(dist, x))
+    {
+        return 0;
+    }
+    uint64_t const old = inform_counter_get(dist->counters, dist->width, event);
+    // keep the list of nonzero events up to date
+    if (dist->nonzero != NULL)
+    {
+        if (old == 0 && x != 0 && add_nonzero(dist, event))
+        {
+            return 0;
+        }
+        else if (old != 0 && x == 0)
+        {
+            remove_nonzero(dist, event);
+        }
+    }
+    if (dist->track_entropy)
+    {
+        add_clogc(dist, inform_clogc(x) - inform_clogc(old));
+    }
     // otherwise decrement counts by the old number of occurances
-    dist->counts -= dist->histogram[event];
+    dist->counts -= old;
     // increment counts by the new number of occurances
     dist->counts += x;
     // set and return the new number of occurances of the event
-    return (dist->histogram[event] = x);
+    inform_counter_set(dist->counters, dist->width, event, x);
+    return x;
 }
 
 uint32_t inform_dist_tick(inform_dist *dist, size_t event)
@@ -245,17 +636,228 @@ uint32_t inform_dist_tick(inform_dist *dist, size_t event)
     {
         return 0;
     }
-    // increment counts by one
+    // the common case of untracked 32-bit counters doesn't need to be
+    // widened
+    if (dist->width == INFORM_COUNTER_32 && !dist->adaptive &&
+        dist->nonzero == NULL && !dist->track_entropy)
+    {
+        // increment counts by one
+        dist->counts += 1;
+        // increment by one and return the new number of occurances of the
+        // event
+        return (dist->histogram[event] += 1);
+    }
+    uint64_t const x = inform_counter_get(dist->counters, dist->width, event) + 1;
+    // make sure the counter is wide enough
+    if (make_room(dist, x))
+    {
+        return 0;
+    }
+    if (dist->nonzero != NULL && x == 1 && add_nonzero(dist, event))
+    {
+        return 0;
+    }
     dist->counts += 1;
-    // increment by one and return the new number of occurances of the event
-    return (dist->histogram[event] += 1);
+    inform_counter_set(dist->counters, dist->width, event, x);
+    // a tracked 32-bit counter wraps around just as an untracked one does,
+    // at which point it is no longer nonzero
+    if (x > inform_counter_max(dist->width))
+    {
+        remove_nonzero(dist, event);
+        if (dist->track_entropy)
+        {
+            add_clogc(dist, -inform_clogc(x - 1));
+        }
+        return 0;
+    }
+    if (dist->track_entropy)
+    {
+        add_clogc(dist, inform_clogc(x) - inform_clogc(x - 1));
+    }
+    return (x > UINT32_MAX) ? UINT32_MAX : (uint32_t) x;
+}
+
+uint32_t inform_dist_untick(inform_dist *dist, size_t event)
+{
+    // if the distribution is NULL or the event is outsize of the support
+    if (dist == NULL || event >= dist->size)
+    {
+        return 0;
+    }
+    uint64_t const x = inform_counter_get(dist->counters, dist->width, event);
+    // if the event has not been observed, there is nothing to remove
+    if (x == 0)
+    {
+        return 0;
+    }
+    dist->counts -= 1;
+    inform_counter_set(dist->counters, dist->width, event, x - 1);
+    if (x == 1 && dist->nonzero != NULL)
+    {
+        remove_nonzero(dist, event);
+    }
+    if (dist->track_entropy)
+    {
+        add_clogc(dist, inform_clogc(x - 1) - inform_clogc(x));
+    }
+    return (x - 1 > UINT32_MAX) ? UINT32_MAX : (uint32_t)(x - 1);
+}
+
+/// the number of interleaved sub-histograms used by inform_dist_tick_many
+#define TICK_WAYS 4
+/// the largest support for which the sub-histograms are used; together they
+/// take 16KiB of stack, which fits comfortably in the L1 cache
+#define TICK_MAX_SIZE 1024
+
+/**
+ * Count events into TICK_WAYS interleaved histograms of `size` counters,
+ * returning the number of events counted before one was found outside of
+ * the support.
+ */
+static size_t tick_interleaved(uint32_t *ways, size_t size,
+    size_t const *events, size_t n)
+{
+    uint32_t *a = ways;
+    uint32_t *b = ways + size;
+    uint32_t *c = ways + 2 * size;
+    uint32_t *d = ways + 3 * size;
+    size_t i = 0;
+    for (; i + TICK_WAYS <= n; i += TICK_WAYS)
+    {
+        size_t const w = events[i], x = events[i + 1],
+              y = events[i + 2], z = events[i + 3];
+        // a single, well-predicted branch validates all four events
+        if ((w >= size) | (x >= size) | (y >= size) | (z >= size))
+        {
+            return i;
+        }
+        a[w]++;
+        b[x]++;
+        c[y]++;
+        d[z]++;
+    }
+    for (; i < n; ++i)
+    {
+        if (events[i] >= size)
+        {
+            return i;
+        }
+        a[events[i]]++;
+    }
+    return n;
+}
+
+/**
+ * Count events directly into a histogram of `size` counters, returning the
+ * number of events counted before one was found outside of the support.
+ */
+static size_t tick_direct(uint32_t *histogram, size_t size,
+    size_t const *events, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (events[i] >= size)
+        {
+            return i;
+        }
+        histogram[events[i]]++;
+    }
+    return n;
+}
+
+/**
+ * Count events one at a time into counters which may have to be widened,
+ * returning `true`, leaving the distribution as it was, if an event is
+ * outside of the support or the counters can't be widened.
+ */
+static bool tick_widening(inform_dist *dist, size_t const *events, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (events[i] >= dist->size)
+        {
+            return true;
+        }
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        // a tick which wraps a counter around still counts the event, so
+        // failure is signaled by the total count being left alone
+        uint64_t const counts = dist->counts;
+        inform_dist_tick(dist, events[i]);
+        if (dist->counts == counts)
+        {
+            // undo the events which were counted, along with their nonzero
+            // entries and entropy terms, whatever width the counters have
+            // been widened to in the meantime
+            while (i-- > 0)
+            {
+                inform_dist_untick(dist, events[i]);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t inform_dist_tick_many(inform_dist *dist, size_t const *events, size_t n)
+{
+    if (dist == NULL || events == NULL || n == 0)
+    {
+        return 0;
+    }
+    // only the common case of untracked 32-bit counters is counted in bulk
+    if (dist->width != INFORM_COUNTER_32 || dist->adaptive ||
+        dist->nonzero != NULL || dist->track_entropy)
+    {
+        return tick_widening(dist, events, n) ? 0 : n;
+    }
+    uint32_t *histogram = dist->histogram;
+    size_t const size = dist->size;
+    // consecutive observations of the same event form a chain of dependent
+    // increments through memory; counting alternate observations into
+    // separate histograms lets several increments be in flight at once
+    if (size <= TICK_MAX_SIZE && n >= TICK_WAYS * size)
+    {
+        uint32_t ways[TICK_WAYS * TICK_MAX_SIZE];
+        memset(ways, 0, TICK_WAYS * size * sizeof(uint32_t));
+        size_t const counted = tick_interleaved(ways, size, events, n);
+        if (counted == n)
+        {
+            for (size_t j = 0; j < size; ++j)
+            {
+                histogram[j] += ways[j] + ways[size + j] + ways[2 * size + j] +
+                    ways[3 * size + j];
+            }
+        }
+        if (counted != n)
+        {
+            return 0;
+        }
+    }
+    else
+    {
+        size_t const counted = tick_direct(histogram, size, events, n);
+        if (counted != n)
+        {
+            // leave the distribution as it was
+            for (size_t i = 0; i < counted; ++i)
+            {
+                histogram[events[i]]--;
+            }
+            return 0;
+        }
+    }
+    dist->counts += n;
+    return n;
 }
 
 static double inform_dist_unsafe_prob(inform_dist const *dist, size_t event)
 {
     // unsafely compute the probability of an event
     // this will fail if there have been no observations made
-    return (double)(dist->histogram[event]) / dist->counts;
+    return (double) inform_counter_get(dist->counters, dist->width, event) /
+        dist->counts;
 }
 
 double inform_dist_prob(inform_dist const *dist, size_t event)
@@ -285,6 +887,17 @@ size_t inform_dist_dump(inform_dist const *dist, double *probs, size_t n)
     {
         return 0;
     }
+    // only visit the nonzero events if they are known
+    if (dist->nonzero != NULL && dist->counts != 0)
+    {
+        memset(probs, 0, n * sizeof(double));
+        for (size_t i = 0; i < dist->nonzero_size; ++i)
+        {
+            probs[dist->nonzero[i]] = inform_dist_unsafe_prob(dist,
+                dist->nonzero[i]);
+        }
+        return n;
+    }
     // loop over the events
     for (size_t i = 0; i < inform_dist_size(dist); ++i)
     {
@@ -293,3 +906,519 @@ size_t inform_dist_dump(inform_dist const *dist, double *probs, size_t n)
     }
     return (int) n;
 }
+
+inform_dist* inform_dist_merge(inform_dist const *src, inform_dist *dest)
+{
+    if (src == NULL || dest == NULL || src->size != dest->size)
+    {
+        return NULL;
+    }
+    if (dest->counts > UINT64_MAX - src->counts)
+    {
+        return NULL;
+    }
+    // adaptive counters can hold any count once they have been widened
+    uint64_t const limit = dest->adaptive ? UINT64_MAX :
+        inform_counter_max(dest->width);
+    // check every counter before touching any, so that a failed merge leaves
+    // the destination unscathed
+    bool overflow = false;
+    uint64_t largest = 0;
+    size_t added = 0;
+    for (size_t i = 0; i < src->size; ++i)
+    {
+        uint64_t const a = inform_counter_get(dest->counters, dest->width, i);
+        uint64_t const b = inform_counter_get(src->counters, src->width, i);
+        overflow |= (b > limit || a > limit - b);
+        largest = (a + b > largest) ? a + b : largest;
+        added += (a == 0 && b != 0);
+    }
+    if (overflow || make_room(dest, largest))
+    {
+        return NULL;
+    }
+    if (dest->nonzero != NULL &&
+        reserve_nonzero(dest, dest->nonzero_size + added))
+    {
+        return NULL;
+    }
+    for (size_t i = 0; i < src->size; ++i)
+    {
+        uint64_t const a = inform_counter_get(dest->counters, dest->width, i);
+        uint64_t const b = inform_counter_get(src->counters, src->width, i);
+        inform_counter_set(dest->counters, dest->width, i, a + b);
+        if (dest->nonzero != NULL && a == 0 && b != 0)
+        {
+            dest->nonzero[dest->nonzero_size++] = i;
+        }
+    }
+    dest->counts += src->counts;
+    if (dest->track_entropy)
+    {
+        sync_clogc(dest);
+    }
+    return dest;
+}
+
+inform_dist* inform_dist_subtract(inform_dist const *src, inform_dist *dest)
+{
+    if (src == NULL || dest == NULL || src->size != dest->size)
+    {
+        return NULL;
+    }
+    bool underflow = (dest->counts < src->counts);
+    for (size_t i = 0; i < src->size; ++i)
+    {
+        underflow |= (inform_counter_get(dest->counters, dest->width, i) <
+            inform_counter_get(src->counters, src->width, i));
+    }
+    if (underflow)
+    {
+        return NULL;
+    }
+    for (size_t i = 0; i < src->size; ++i)
+    {
+        uint64_t const a = inform_counter_get(dest->counters, dest->width, i);
+        uint64_t const b = inform_counter_get(src->counters, src->width, i);
+        inform_counter_set(dest->counters, dest->width, i, a - b);
+    }
+    prune_nonzero(dest);
+    if (dest->track_entropy)
+    {
+        sync_clogc(dest);
+    }
+    dest->counts -= src->counts;
+    return dest;
+}
+
+/**
+ * Replace the contents of a distribution with `n` counts which sum to
+ * `total`, allocating the distribution if it is `NULL`.
+ *
+ * Returns `NULL`, leaving the distribution unscathed, if it has the wrong
+ * size, can't hold the counts, or an allocation fails.
+ */
+static inform_dist *store_counts(uint64_t const *counts, size_t n,
+    uint64_t total, inform_dist *dest)
+{
+    uint64_t largest = 0;
+    size_t nonzero = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        largest = (counts[i] > largest) ? counts[i] : largest;
+        nonzero += (counts[i] != 0);
+    }
+    if (dest == NULL)
+    {
+        dest = inform_dist_alloc_width(n, (largest > UINT32_MAX) ?
+            INFORM_COUNTER_64 : INFORM_COUNTER_32);
+        if (dest == NULL)
+        {
+            return NULL;
+        }
+    }
+    else if (dest->size != n ||
+        (!dest->adaptive && largest > inform_counter_max(dest->width)) ||
+        make_room(dest, largest) ||
+        (dest->nonzero != NULL && reserve_nonzero(dest, nonzero)))
+    {
+        return NULL;
+    }
+    dest->nonzero_size = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        inform_counter_set(dest->counters, dest->width, i, counts[i]);
+        if (dest->nonzero != NULL && counts[i] != 0)
+        {
+            dest->nonzero[dest->nonzero_size++] = i;
+        }
+    }
+    dest->counts = total;
+    if (dest->track_entropy)
+    {
+        sync_clogc(dest);
+    }
+    return dest;
+}
+
+inform_dist* inform_dist_marginal(inform_dist const *joint,
+    size_t const *shape, size_t rank, size_t const *axes, size_t naxes,
+    inform_dist *marginal)
+{
+    if (joint == NULL || shape == NULL || rank == 0 || naxes > rank ||
+        (axes == NULL && naxes != 0))
+    {
+        return NULL;
+    }
+    // the stride of each variable in the marginal's encoding, which is zero
+    // for the variables which are summed over
+    size_t *stride = inform_calloc(2 * rank, sizeof(size_t));
+    if (stride == NULL)
+    {
+        return NULL;
+    }
+    size_t *digit = stride + rank;
+    // the shape must cover the joint support exactly
+    size_t size = 1;
+    bool error = false;
+    for (size_t i = 0; i < rank && !error; ++i)
+    {
+        error = (shape[i] == 0 || size > SIZE_MAX / shape[i]);
+        size = error ? size : size * shape[i];
+    }
+    error = error || (size != joint->size);
+    // each kept variable must be distinct
+    size_t n = 1;
+    for (size_t j = naxes; j > 0 && !error; --j)
+    {
+        size_t const a = axes[j - 1];
+        error = (a >= rank || stride[a] != 0);
+        if (!error)
+        {
+            stride[a] = n;
+            n *= shape[a];
+        }
+    }
+    uint64_t *counts = error ? NULL : inform_calloc(n, sizeof(uint64_t));
+    if (counts == NULL)
+    {
+        inform_sized_free(stride, 2 * rank * sizeof(size_t));
+        return NULL;
+    }
+    if (joint->nonzero != NULL)
+    {
+        // decode each of the observed joint events
+        for (size_t k = 0; k < joint->nonzero_size; ++k)
+        {
+            size_t e = joint->nonzero[k], m = 0;
+            for (size_t i = rank; i > 0; --i)
+            {
+                m += (e % shape[i - 1]) * stride[i - 1];
+                e /= shape[i - 1];
+            }
+            counts[m] += inform_counter_get(joint->counters, joint->width,
+                joint->nonzero[k]);
+        }
+    }
+    else
+    {
+        // step through the joint events in order, keeping the digits of
+        // each variable and the marginal event up to date like an odometer
+        size_t m = 0;
+        for (size_t e = 0; e < joint->size; ++e)
+        {
+            counts[m] += inform_counter_get(joint->counters, joint->width, e);
+            for (size_t i = rank; i > 0; --i)
+            {
+                m += stride[i - 1];
+                if (++digit[i - 1] < shape[i - 1])
+                {
+                    break;
+                }
+                m -= stride[i - 1] * shape[i - 1];
+                digit[i - 1] = 0;
+            }
+        }
+    }
+    marginal = store_counts(counts, n, joint->counts, marginal);
+    inform_sized_free(counts, n * sizeof(uint64_t));
+    inform_sized_free(stride, 2 * rank * sizeof(size_t));
+    return marginal;
+}
+
+inform_dist* inform_dist_coarse_grain(inform_dist const *dist,
+    size_t const *map, size_t n, inform_dist *dest)
+{
+    if (dist == NULL || map == NULL || n == 0)
+    {
+        return NULL;
+    }
+    bool error = false;
+    for (size_t i = 0; i < dist->size; ++i)
+    {
+        error |= (map[i] >= n);
+    }
+    uint64_t *counts = error ? NULL : inform_calloc(n, sizeof(uint64_t));
+    if (counts == NULL)
+    {
+        return NULL;
+    }
+    if (dist->nonzero != NULL)
+    {
+        for (size_t k = 0; k < dist->nonzero_size; ++k)
+        {
+            size_t const e = dist->nonzero[k];
+            counts[map[e]] += inform_counter_get(dist->counters, dist->width, e);
+        }
+    }
+    else
+    {
+        for (size_t e = 0; e < dist->size; ++e)
+        {
+            counts[map[e]] += inform_counter_get(dist->counters, dist->width, e);
+        }
+    }
+    dest = store_counts(counts, n, dist->counts, dest);
+    inform_sized_free(counts, n * sizeof(uint64_t));
+    return dest;
+}
+
+/// the magic bytes which begin every serialized distribution
+static uint8_t const SERIAL_MAGIC[4] = { 'I', 'F', 'D', 'S' };
+/// the version of the serialization format
+#define SERIAL_VERSION 2
+/// every counter is stored, in order
+#define SERIAL_DENSE 0
+/// only the nonzero counters are stored, each with the gap since the last
+#define SERIAL_SPARSE 1
+/// the low bits of the flags hold the width of the counters
+#define SERIAL_WIDTH 0x03
+/// the counters are promoted when they would overflow
+#define SERIAL_ADAPTIVE 0x04
+/// the nonzero events are tracked
+#define SERIAL_NONZERO 0x08
+/// a running sum of c log2(c) is kept
+#define SERIAL_ENTROPY 0x10
+/// the magic bytes, the version, the encoding and the flags
+#define SERIAL_HEADER 7
+
+inline static size_t varint_size(uint64_t x)
+{
+    size_t n = 1;
+    while (x >= 0x80)
+    {
+        x >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+inline static uint8_t *put_varint(uint8_t *buffer, uint64_t x)
+{
+    while (x >= 0x80)
+    {
+        *buffer++ = (uint8_t)(x | 0x80);
+        x >>= 7;
+    }
+    *buffer++ = (uint8_t) x;
+    return buffer;
+}
+
+inline static bool get_varint(uint8_t const *buffer, size_t n, size_t *pos,
+    uint64_t *x)
+{
+    *x = 0;
+    for (unsigned shift = 0; shift < 64 && *pos < n; shift += 7)
+    {
+        uint8_t const byte = buffer[(*pos)++];
+        uint64_t const bits = (uint64_t)(byte & 0x7f);
+        // reject bits which would be shifted off of the top
+        if (shift == 63 && bits > 1)
+        {
+            return true;
+        }
+        *x |= bits << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Compute the sizes of the dense and sparse encodings of a histogram.
+ */
+static void encoded_sizes(inform_dist const *dist, size_t *dense,
+    size_t *sparse)
+{
+    size_t const header = SERIAL_HEADER + varint_size(dist->size) +
+        varint_size(dist->counts);
+    size_t nonzero = 0, body = 0, pairs = 0, last = 0;
+    for (size_t i = 0; i < dist->size; ++i)
+    {
+        uint64_t const x = inform_counter_get(dist->counters, dist->width, i);
+        body += varint_size(x);
+        if (x != 0)
+        {
+            pairs += varint_size(i - last) + varint_size(x);
+            last = i + 1;
+            ++nonzero;
+        }
+    }
+    *dense = header + body;
+    *sparse = header + varint_size(nonzero) + pairs;
+}
+
+size_t inform_dist_serialized_size(inform_dist const *dist)
+{
+    if (dist == NULL || dist->size == 0)
+    {
+        return 0;
+    }
+    size_t dense, sparse;
+    encoded_sizes(dist, &dense, &sparse);
+    return (sparse < dense) ? sparse : dense;
+}
+
+size_t inform_dist_serialize(inform_dist const *dist, uint8_t *buffer,
+    size_t n)
+{
+    if (dist == NULL || dist->size == 0 || buffer == NULL)
+    {
+        return 0;
+    }
+    size_t dense, sparse;
+    encoded_sizes(dist, &dense, &sparse);
+    size_t const size = (sparse < dense) ? sparse : dense;
+    if (n < size)
+    {
+        return 0;
+    }
+
+    uint8_t *p = buffer;
+    memcpy(p, SERIAL_MAGIC, sizeof(SERIAL_MAGIC));
+    p += sizeof(SERIAL_MAGIC);
+    *p++ = SERIAL_VERSION;
+    *p++ = (sparse < dense) ? SERIAL_SPARSE : SERIAL_DENSE;
+    *p++ = (uint8_t)((unsigned) dist->width |
+        (dist->adaptive ? SERIAL_ADAPTIVE : 0) |
+        (dist->nonzero != NULL ? SERIAL_NONZERO : 0) |
+        (dist->track_entropy ? SERIAL_ENTROPY : 0));
+    p = put_varint(p, dist->size);
+    p = put_varint(p, dist->counts);
+    if (sparse < dense)
+    {
+        size_t nonzero = 0;
+        for (size_t i = 0; i < dist->size; ++i)
+        {
+            nonzero += (inform_counter_get(dist->counters, dist->width, i) != 0);
+        }
+        p = put_varint(p, nonzero);
+        size_t last = 0;
+        for (size_t i = 0; i < dist->size; ++i)
+        {
+            uint64_t const x = inform_counter_get(dist->counters, dist->width, i);
+            if (x != 0)
+            {
+                p = put_varint(p, i - last);
+                p = put_varint(p, x);
+                last = i + 1;
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < dist->size; ++i)
+        {
+            p = put_varint(p, inform_counter_get(dist->counters, dist->width, i));
+        }
+    }
+    return (size_t)(p - buffer);
+}
+
+/**
+ * Store a deserialized count, promoting adaptive counters as needed.
+ *
+ * Returns `true` if the counters can't be widened, or if they aren't
+ * adaptive and the count doesn't fit.
+ */
+static bool store_count(inform_dist *dist, size_t event, uint64_t x)
+{
+    if (make_room(dist, x) || x > inform_counter_max(dist->width))
+    {
+        return true;
+    }
+    inform_counter_set(dist->counters, dist->width, event, x);
+    return false;
+}
+
+inform_dist* inform_dist_deserialize(uint8_t const *buffer, size_t n,
+    size_t max_size, size_t *read)
+{
+    if (buffer == NULL || n < SERIAL_HEADER)
+    {
+        return NULL;
+    }
+    if (memcmp(buffer, SERIAL_MAGIC, sizeof(SERIAL_MAGIC)) != 0 ||
+        buffer[4] != SERIAL_VERSION)
+    {
+        return NULL;
+    }
+    uint8_t const encoding = buffer[5];
+    uint8_t const flags = buffer[6];
+    size_t pos = SERIAL_HEADER;
+    uint64_t size, counts;
+    if (get_varint(buffer, n, &pos, &size) || get_varint(buffer, n, &pos, &counts))
+    {
+        return NULL;
+    }
+    // every dense counter takes at least a byte, so a dense support larger
+    // than the input is malformed and must not be allocated; a sparse one is
+    // only bounded by what the caller is prepared to allocate
+    if (size == 0 || size > max_size ||
+        (encoding == SERIAL_DENSE && size > n - pos) ||
+        (encoding != SERIAL_DENSE && encoding != SERIAL_SPARSE) ||
+        (flags & ~(SERIAL_WIDTH | SERIAL_ADAPTIVE | SERIAL_NONZERO |
+            SERIAL_ENTROPY)) != 0)
+    {
+        return NULL;
+    }
+
+    inform_dist *dist = inform_dist_alloc_width((size_t) size,
+        (inform_counter_width)(flags & SERIAL_WIDTH));
+    if (dist == NULL)
+    {
+        return NULL;
+    }
+    dist->adaptive = (flags & SERIAL_ADAPTIVE) != 0;
+    uint64_t total = 0, x;
+    bool error = false;
+    if (encoding == SERIAL_SPARSE)
+    {
+        uint64_t nonzero, gap;
+        error = get_varint(buffer, n, &pos, &nonzero) || nonzero > size;
+        for (uint64_t i = 0, j = 0; !error && j < nonzero; ++j)
+        {
+            error = get_varint(buffer, n, &pos, &gap) ||
+                get_varint(buffer, n, &pos, &x) ||
+                gap >= size - i || x == 0 || x > UINT64_MAX - total ||
+                store_count(dist, (size_t)(i + gap), x);
+            if (!error)
+            {
+                i += gap + 1;
+                total += x;
+            }
+        }
+    }
+    else
+    {
+        for (size_t i = 0; !error && i < (size_t) size; ++i)
+        {
+            error = get_varint(buffer, n, &pos, &x) ||
+                x > UINT64_MAX - total || store_count(dist, i, x);
+            if (!error)
+            {
+                total += x;
+            }
+        }
+    }
+    // the recorded number of observations doubles as a checksum
+    if (error || total != counts)
+    {
+        inform_dist_free(dist);
+        return NULL;
+    }
+    dist->counts = counts;
+    if (((flags & SERIAL_NONZERO) && !inform_dist_track_nonzero(dist, true)) ||
+        ((flags & SERIAL_ENTROPY) && !inform_dist_track_entropy(dist, true)))
+    {
+        inform_dist_free(dist);
+        return NULL;
+    }
+    if (read != NULL)
+    {
+        *read = pos;
+    }
+    return dist;
+}
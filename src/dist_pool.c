@@ -0,0 +1,146 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <inform/dist_pool.h>
+#include <string.h>
+#include "counters.h"
+#include "memory.h"
+
+/// the number of size classes of a pool
+#define POOL_CLASSES (8 * sizeof(size_t))
+/// the smallest size class, which holds the header and a cache line
+#define MIN_CLASS 8
+
+inform_dist_pool *inform_dist_pool_alloc(void)
+{
+    return inform_calloc(1, sizeof(inform_dist_pool));
+}
+
+void inform_dist_pool_free(inform_dist_pool *pool)
+{
+    if (pool != NULL)
+    {
+        inform_dist_pool_trim(pool);
+        inform_sized_free(pool, sizeof(inform_dist_pool));
+    }
+}
+
+/**
+ * Find the size class of the blocks which can hold `n` counters of `bytes`
+ * bytes each, or `POOL_CLASSES` if no block is large enough.
+ */
+static size_t size_class(size_t n, size_t bytes)
+{
+    if (n > (SIZE_MAX / 2 - INFORM_POOLED_HEADER) / bytes)
+    {
+        return POOL_CLASSES;
+    }
+    size_t const needed = INFORM_POOLED_HEADER + n * bytes;
+    size_t k = MIN_CLASS;
+    while (((size_t) 1 << k) < needed)
+    {
+        ++k;
+    }
+    return k;
+}
+
+inform_dist *inform_dist_pool_get(inform_dist_pool *pool, size_t n,
+    inform_counter_width width)
+{
+    if (pool == NULL)
+    {
+        return inform_dist_alloc_width(n, width);
+    }
+    if (n == 0 || width < INFORM_COUNTER_32 || width > INFORM_COUNTER_64)
+    {
+        return NULL;
+    }
+    size_t const bytes = inform_counter_bytes(width);
+    size_t const k = size_class(n, bytes);
+    if (k == POOL_CLASSES)
+    {
+        return NULL;
+    }
+    // reuse a free block of the right class, clearing the counters it held,
+    // or else allocate one which comes zeroed
+    inform_pooled_dist *block = pool->blocks[k];
+    if (block != NULL)
+    {
+        pool->blocks[k] = block->next;
+        pool->cached -= block->bytes;
+        memset((char *) block + INFORM_POOLED_HEADER, 0, n * bytes);
+    }
+    else
+    {
+        block = inform_aligned_calloc((size_t) 1 << k, 1);
+        if (block == NULL)
+        {
+            return NULL;
+        }
+        block->bytes = (size_t) 1 << k;
+    }
+    block->next = NULL;
+
+    inform_dist *dist = &block->dist;
+    dist->counters         = (char *) block + INFORM_POOLED_HEADER;
+    dist->size             = n;
+    dist->counts           = 0;
+    dist->width            = width;
+    dist->adaptive         = (width == INFORM_COUNTER_8 ||
+        width == INFORM_COUNTER_16);
+    dist->nonzero          = NULL;
+    dist->nonzero_size     = 0;
+    dist->nonzero_capacity = 0;
+    dist->track_entropy    = false;
+    dist->clogc            = 0.;
+    dist->clogc_error      = 0.;
+    dist->pooled           = true;
+    return dist;
+}
+
+void inform_dist_pool_put(inform_dist_pool *pool, inform_dist *dist)
+{
+    if (pool == NULL || dist == NULL || !dist->pooled)
+    {
+        inform_dist_free(dist);
+        return;
+    }
+    // counters which have moved out of the block, e.g. because the
+    // distribution was resized, go back to the heap
+    inform_dist_release_counters(dist);
+    inform_aligned_free(dist->nonzero,
+        dist->nonzero_capacity * sizeof(size_t));
+
+    inform_pooled_dist *block = (inform_pooled_dist *) dist;
+    size_t k = MIN_CLASS;
+    while (((size_t) 1 << k) < block->bytes)
+    {
+        ++k;
+    }
+    block->next = pool->blocks[k];
+    pool->blocks[k] = block;
+    pool->cached += block->bytes;
+}
+
+size_t inform_dist_pool_cached(inform_dist_pool const *pool)
+{
+    return (pool == NULL) ? 0 : pool->cached;
+}
+
+void inform_dist_pool_trim(inform_dist_pool *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+    for (size_t k = 0; k < POOL_CLASSES; ++k)
+    {
+        while (pool->blocks[k] != NULL)
+        {
+            inform_pooled_dist *block = pool->blocks[k];
+            pool->blocks[k] = block->next;
+            inform_aligned_free(block, block->bytes);
+        }
+    }
+    pool->cached = 0;
+}
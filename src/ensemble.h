@@ -0,0 +1,242 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/dist.h>
+#include <inform/error.h>
+#include <inform/sparse_dist.h>
+#include <inform/window_dist.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * A kernel which counts the observations of the initial conditions
+ * `[begin, end)` of an ensemble into the histogram block `data`.
+ */
+typedef void (*inform_ensemble_kernel)(void const *ctx, size_t begin,
+    size_t end, uint32_t *data);
+
+/**
+ * Accumulate the observations of `n` initial conditions, which make `N`
+ * observations in total, into a zeroed histogram block of `size` counters.
+ *
+ * The initial conditions are split across as many threads as are configured
+ * via inform_set_num_threads and are worth the cost of a private histogram
+ * block per thread. The private blocks are summed into `data` in a fixed
+ * order, so the result does not depend on the number of threads.
+ */
+void inform_accumulate_ensemble(inform_ensemble_kernel kernel, void const *ctx,
+    size_t n, size_t N, uint32_t *data, size_t size);
+
+/**
+ * A callback which receives the histograms of the observations of one
+ * history length `k`: the joint `states` of the histories and futures and
+ * their marginals `histories` and `futures`.
+ */
+typedef void (*inform_sweep_visitor)(void *ctx, size_t k,
+    inform_dist const *states, inform_dist const *histories,
+    inform_dist const *futures);
+
+/**
+ * Build the histograms of an ensemble of `n` base-`b` time series of length
+ * `m` for every history length from `K` down to 1, passing each to `visit`.
+ *
+ * The data are scanned once, for the longest history. The histograms of
+ * each shorter history are folded out of those of the next longer one, and
+ * only the single observation per time series which the longer history
+ * can't see is added to them. The support `b^(K+1)` must be dense.
+ *
+ * Returns `true` if the histograms can't be allocated.
+ */
+bool inform_sweep_histories(int const *series, size_t n, size_t m, int b,
+    size_t K, inform_sweep_visitor visit, void *ctx);
+
+/**
+ * Compute the number of distinct blocks of `k` base-`b` states, `b^k`.
+ *
+ * Returns `true` if the blocks cannot be encoded as 64-bit states, in which
+ * case `support` is set to `UINT64_MAX`.
+ */
+inline static bool inform_block_support(int b, size_t k, uint64_t *support)
+{
+    uint64_t size = 1;
+    for (size_t i = 0; i < k; ++i)
+    {
+        if (size > UINT64_MAX / (uint64_t) b)
+        {
+            *support = UINT64_MAX;
+            return true;
+        }
+        size *= (uint64_t) b;
+    }
+    *support = size;
+    return false;
+}
+
+/**
+ * Determine whether a joint histogram over `support` states, which together
+ * with its marginals spans at most twice as many counters, must be stored
+ * sparsely because it can't be addressed, or should be because it will only
+ * receive `N` observations.
+ */
+inline static bool inform_use_sparse(uint64_t support, size_t N)
+{
+    return support > SIZE_MAX / (2 * sizeof(uint32_t)) ||
+        inform_sparse_dist_preferred((size_t) support, N);
+}
+
+/**
+ * Allocate a distribution of 64-bit counters over the `b^k` blocks of `k`
+ * base-`b` states which keeps a running entropy, as used by the incremental
+ * accumulators of the measures.
+ *
+ * Returns `NULL`, and sets `err`, if the blocks can't be encoded or the
+ * allocation fails.
+ */
+inline static inform_dist *inform_tracked_blocks_alloc(int b, size_t k,
+    inform_error *err)
+{
+    uint64_t support;
+    if (inform_block_support(b, k, &support) ||
+        support > SIZE_MAX / sizeof(uint64_t))
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EKLONG, NULL);
+    }
+    inform_dist *dist = inform_dist_alloc_width((size_t) support,
+        INFORM_COUNTER_64);
+    if (dist == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+    return inform_dist_track_entropy(dist, true);
+}
+
+/**
+ * Allocate a sliding-window distribution over the `b^k` blocks of `k`
+ * base-`b` states, holding the last `window` observations, as used by the
+ * windowed measures.
+ *
+ * Returns `NULL`, and sets `err`, if the blocks can't be encoded or the
+ * allocation fails.
+ */
+inline static inform_window_dist *inform_window_blocks_alloc(int b, size_t k,
+    size_t window, inform_error *err)
+{
+    uint64_t support;
+    if (inform_block_support(b, k, &support) ||
+        support > SIZE_MAX / sizeof(uint64_t))
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EKLONG, NULL);
+    }
+    inform_window_dist *dist = inform_window_dist_alloc((size_t) support,
+        window);
+    if (dist == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+    return dist;
+}
+
+/**
+ * Add `count` observations of `event` to a sparse histogram. Returns `true`
+ * and sets `err` if the sum doesn't fit in a 32-bit counter or the histogram
+ * can't grow to hold the event.
+ */
+inline static bool inform_sparse_add(inform_sparse_dist *dist, uint64_t event,
+    uint32_t count, inform_error *err)
+{
+    uint32_t const total = inform_sparse_dist_get(dist, event);
+    if (total > UINT32_MAX - count)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EOVERFLOW, true);
+    }
+    inform_error e = INFORM_SUCCESS;
+    inform_sparse_dist_set(dist, event, total + count, &e);
+    if (inform_failed(&e))
+    {
+        INFORM_ERROR_RETURN(err, e, true);
+    }
+    return false;
+}
+
+/**
+ * Check the shape of `n` initial conditions of `m` base-`b` states, from which
+ * histories of length `k` are drawn, and that blocks of `span` states can be
+ * encoded. Returns `true` and sets `err` if they are invalid.
+ */
+inline static bool inform_check_history_shape(size_t n, size_t m, int b,
+    size_t k, size_t span, inform_error *err)
+{
+    if (n < 1)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ENOINITS, true);
+    }
+    else if (m < 2)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ESHORTSERIES, true);
+    }
+    else if (b < 2)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EBASE, true);
+    }
+    else if (k == 0)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EKZERO, true);
+    }
+    else if (m <= k)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EKLONG, true);
+    }
+    uint64_t support;
+    if (inform_block_support(b, span, &support))
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EKLONG, true);
+    }
+    return false;
+}
+
+/**
+ * Check that `m` states of a time series, pushed to an accumulator with base
+ * `b`, are valid. Returns `true` and sets `err` if they are not.
+ */
+inline static bool inform_check_pushed(int const *series, size_t m, int b,
+    inform_error *err)
+{
+    if (series == NULL && m != 0)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ETIMESERIES, true);
+    }
+    for (size_t i = 0; i < m; ++i)
+    {
+        if (series[i] < 0)
+        {
+            INFORM_ERROR_RETURN(err, INFORM_ENEGSTATE, true);
+        }
+        else if (b <= series[i])
+        {
+            INFORM_ERROR_RETURN(err, INFORM_EBADSTATE, true);
+        }
+    }
+    return false;
+}
+
+/**
+ * Check the arguments of a measure over the histories of length `k` of a
+ * base-`b` time series, as by inform_check_history_shape, along with each of
+ * its states. Returns `true` and sets `err` if they are invalid.
+ */
+inline static bool inform_check_history_args(int const *series, size_t n,
+    size_t m, int b, size_t k, size_t span, inform_error *err)
+{
+    if (series == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ETIMESERIES, true);
+    }
+    if (inform_check_history_shape(n, m, b, k, span, err))
+    {
+        return true;
+    }
+    return inform_check_pushed(series, n * m, b, err);
+}
@@ -0,0 +1,368 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <inform/active_info.h>
+#include <inform/block_entropy.h>
+#include <inform/entropy_rate.h>
+#include <inform/history_measures.h>
+#include <inform/shannon.h>
+#include <math.h>
+#include <string.h>
+#include "ensemble.h"
+#include "counters.h"
+#include "memory.h"
+
+/// the local measures
+#define LOCAL_MEASURES (INFORM_LOCAL_BLOCK_ENTROPY | \
+    INFORM_LOCAL_ENTROPY_RATE | INFORM_LOCAL_ACTIVE_INFO)
+/// the measures of blocks of `k` states, rather than of histories
+#define BLOCK_MEASURES (INFORM_BLOCK_ENTROPY | INFORM_LOCAL_BLOCK_ENTROPY)
+/// every measure
+#define ALL_MEASURES (BLOCK_MEASURES | INFORM_ENTROPY_RATE | \
+    INFORM_ACTIVE_INFO | INFORM_LOCAL_ENTROPY_RATE | INFORM_LOCAL_ACTIVE_INFO)
+
+struct ensemble
+{
+    int const *series;
+    size_t m;
+    int b;
+    size_t k;
+    uint64_t *state;
+};
+
+static void accumulate_ensemble(void const *ctx, size_t begin, size_t end,
+    uint32_t *data)
+{
+    struct ensemble const *e = ctx;
+    uint64_t q = 1;
+    for (size_t j = 0; j < e->k; ++j)
+    {
+        q *= e->b;
+    }
+    for (size_t i = begin; i < end; ++i)
+    {
+        int const *series = e->series + i * e->m;
+        uint64_t *state = (e->state == NULL) ? NULL : e->state + i * (e->m - e->k);
+        uint64_t history = 0;
+        for (size_t j = 0; j < e->k; ++j)
+        {
+            history = history * e->b + series[j];
+        }
+        for (size_t j = e->k; j < e->m; ++j)
+        {
+            uint64_t const s = history * e->b + series[j];
+            data[s]++;
+            if (state != NULL)
+            {
+                state[j - e->k] = s;
+            }
+            history = s - series[j - e->k] * q;
+        }
+    }
+}
+
+/**
+ * Encode the block of `k` states which ends a time series of length `m`.
+ */
+static uint64_t last_block(int const *series, size_t m, int b, size_t k)
+{
+    uint64_t block = 0;
+    for (size_t j = m - k; j < m; ++j)
+    {
+        block = block * b + series[j];
+    }
+    return block;
+}
+
+/**
+ * Free the arrays of local measures which were allocated rather than given.
+ */
+static void release_locals(size_t n, size_t N,
+    inform_history_results const *r, inform_history_results const *given)
+{
+    if (r->local_block_entropy != given->local_block_entropy)
+    {
+        inform_sized_free(r->local_block_entropy, (N + n) * sizeof(double));
+    }
+    if (r->local_entropy_rate != given->local_entropy_rate)
+    {
+        inform_sized_free(r->local_entropy_rate, N * sizeof(double));
+    }
+    if (r->local_active_info != given->local_active_info)
+    {
+        inform_sized_free(r->local_active_info, N * sizeof(double));
+    }
+}
+
+/**
+ * Make sure that there is an array for each requested local measure,
+ * allocating any which were not provided. Returns `true`, having freed
+ * what it allocated, if an allocation fails.
+ */
+static bool reserve_locals(size_t n, size_t m, size_t k, int measures,
+    inform_history_results *r, inform_history_results *given)
+{
+    *given = *r;
+    size_t const N = n * (m - k);
+    if ((measures & INFORM_LOCAL_BLOCK_ENTROPY) && r->local_block_entropy == NULL)
+    {
+        r->local_block_entropy = inform_malloc((N + n) * sizeof(double));
+    }
+    if ((measures & INFORM_LOCAL_ENTROPY_RATE) && r->local_entropy_rate == NULL)
+    {
+        r->local_entropy_rate = inform_malloc(N * sizeof(double));
+    }
+    if ((measures & INFORM_LOCAL_ACTIVE_INFO) && r->local_active_info == NULL)
+    {
+        r->local_active_info = inform_malloc(N * sizeof(double));
+    }
+    if (((measures & INFORM_LOCAL_BLOCK_ENTROPY) && r->local_block_entropy == NULL) ||
+        ((measures & INFORM_LOCAL_ENTROPY_RATE) && r->local_entropy_rate == NULL) ||
+        ((measures & INFORM_LOCAL_ACTIVE_INFO) && r->local_active_info == NULL))
+    {
+        release_locals(n, N, r, given);
+        *r = *given;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Compute the requested measures one at a time, for when the histograms are
+ * too large to share densely. Returns `true` if any of them fails.
+ */
+static bool separately(int const *series, size_t n, size_t m, int b,
+    size_t k, int measures, inform_history_results *r, inform_error *err)
+{
+    if (measures & INFORM_BLOCK_ENTROPY)
+    {
+        r->block_entropy = inform_block_entropy(series, n, m, b, k, err);
+    }
+    if (measures & INFORM_ENTROPY_RATE)
+    {
+        r->entropy_rate = inform_entropy_rate(series, n, m, b, k, err);
+    }
+    if (measures & INFORM_ACTIVE_INFO)
+    {
+        r->active_info = inform_active_info(series, n, m, b, k, err);
+    }
+    if (((measures & INFORM_LOCAL_BLOCK_ENTROPY) &&
+            !inform_local_block_entropy(series, n, m, b, k,
+                r->local_block_entropy, err)) ||
+        ((measures & INFORM_LOCAL_ENTROPY_RATE) &&
+            !inform_local_entropy_rate(series, n, m, b, k,
+                r->local_entropy_rate, err)) ||
+        ((measures & INFORM_LOCAL_ACTIVE_INFO) &&
+            !inform_local_active_info(series, n, m, b, k,
+                r->local_active_info, err)))
+    {
+        return true;
+    }
+    return inform_failed(err);
+}
+
+/**
+ * Determine whether the requested measures can share dense histograms of
+ * the histories and their futures, which requires that each measure's own
+ * call would count densely too, so that sharing them changes nothing.
+ */
+static bool shares_dense(size_t n, size_t m, int b, size_t k, int measures)
+{
+    uint64_t support;
+    if (inform_block_support(b, k + 1, &support) ||
+        inform_use_sparse(support, n * (m - k)))
+    {
+        return false;
+    }
+    if (measures & BLOCK_MEASURES)
+    {
+        inform_block_support(b, k, &support);
+        if (inform_use_sparse(support, n * (m - k + 1)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Compute the requested measures one at a time into `r`, and publish them to
+ * `results`. If any fails, the local arrays allocated for `r` are freed and
+ * `results` is left as it was.
+ */
+static inform_history_results *fall_back(int const *series, size_t n,
+    size_t m, int b, size_t k, int measures, inform_history_results *r,
+    inform_history_results const *given, inform_history_results *results,
+    inform_error *err)
+{
+    inform_error e = INFORM_SUCCESS;
+    if (separately(series, n, m, b, k, measures, r, &e))
+    {
+        release_locals(n, n * (m - k), r, given);
+        INFORM_ERROR_RETURN(err, e, NULL);
+    }
+    *results = *r;
+    return results;
+}
+
+inform_history_results *inform_history_measures(int const *series, size_t n,
+    size_t m, int b, size_t k, int measures, inform_history_results *results,
+    inform_error *err)
+{
+    if (results == NULL || (measures & ~ALL_MEASURES) != 0)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EARG, NULL);
+    }
+    // blocks only need to encode `k` states, histories and futures `k + 1`
+    size_t const span = (measures & ~BLOCK_MEASURES) ? k + 1 : k;
+    if (inform_check_history_args(series, n, m, b, k, span, err)) return NULL;
+
+    inform_history_results r = *results, given;
+    r.block_entropy = r.entropy_rate = r.active_info = NAN;
+    if (reserve_locals(n, m, k, measures, &r, &given))
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
+    if (!shares_dense(n, m, b, k, measures))
+    {
+        return fall_back(series, n, m, b, k, measures, &r, &given, results,
+            err);
+    }
+
+    size_t const N = n * (m - k);
+    uint64_t support;
+    inform_block_support(b, k + 1, &support);
+    size_t const states_size = (size_t) support;
+    size_t const histories_size = states_size / b;
+    bool const local = (measures & LOCAL_MEASURES) != 0;
+    bool const blocks = (measures & (INFORM_BLOCK_ENTROPY |
+        INFORM_LOCAL_BLOCK_ENTROPY)) != 0;
+
+    // the histograms of the states, histories, futures and, if asked for,
+    // blocks, followed by the observed states and a table of local values
+    size_t const counters = states_size + (blocks ? 2 : 1) * histories_size + b;
+    uint32_t *data = inform_aligned_calloc(counters, sizeof(uint32_t));
+    uint64_t *state = NULL;
+    double *table = NULL;
+    if (local)
+    {
+        state = inform_malloc(N * sizeof(uint64_t));
+        table = inform_malloc(states_size * sizeof(double));
+    }
+    if (data == NULL || (local && (state == NULL || table == NULL)))
+    {
+        inform_sized_free(table, states_size * sizeof(double));
+        inform_sized_free(state, N * sizeof(uint64_t));
+        inform_aligned_free(data, counters * sizeof(uint32_t));
+        return fall_back(series, n, m, b, k, measures, &r, &given, results,
+            err);
+    }
+
+    inform_dist states    = inform_dist_view(data, states_size, N);
+    inform_dist histories = inform_dist_view(data + states_size,
+        histories_size, N);
+    inform_dist futures   = inform_dist_view(data + states_size + histories_size,
+        b, N);
+    inform_dist block     = inform_dist_view(data + states_size +
+        histories_size + b, histories_size, N + n);
+
+    // count the histories and their futures in a single scan
+    struct ensemble const e = { series, m, b, k, state };
+    inform_accumulate_ensemble(accumulate_ensemble, &e, n, N, data,
+        states_size);
+    uint32_t const *joint = data;
+    for (size_t h = 0; h < histories_size; ++h)
+    {
+        for (int f = 0; f < b; ++f, ++joint)
+        {
+            histories.histogram[h] += *joint;
+            futures.histogram[f] += *joint;
+        }
+    }
+    // every block but the last of each series begins a history
+    if (blocks)
+    {
+        memcpy(block.histogram, histories.histogram,
+            histories_size * sizeof(uint32_t));
+        for (size_t i = 0; i < n; ++i)
+        {
+            block.histogram[last_block(series + i * m, m, b, k)]++;
+        }
+    }
+
+    double const base = (double) b;
+    if (measures & INFORM_BLOCK_ENTROPY)
+    {
+        r.block_entropy = inform_shannon(&block, base);
+    }
+    if (measures & INFORM_ENTROPY_RATE)
+    {
+        r.entropy_rate = inform_shannon_ce(&states, &histories, base);
+    }
+    if (measures & INFORM_ACTIVE_INFO)
+    {
+        r.active_info = inform_shannon_mi(&states, &histories, &futures, base);
+    }
+
+    // each local measure is computed once for each observed state
+    if (measures & INFORM_LOCAL_ENTROPY_RATE)
+    {
+        for (size_t s = 0; s < states_size; ++s)
+        {
+            if (states.histogram[s] != 0)
+            {
+                table[s] = inform_shannon_pce(&states, &histories, s, s / b,
+                    base);
+            }
+        }
+        for (size_t i = 0; i < N; ++i)
+        {
+            r.local_entropy_rate[i] = table[state[i]];
+        }
+    }
+    if (measures & INFORM_LOCAL_ACTIVE_INFO)
+    {
+        for (size_t s = 0; s < states_size; ++s)
+        {
+            if (states.histogram[s] != 0)
+            {
+                table[s] = inform_shannon_pmi(&states, &histories, &futures,
+                    s, s / b, s % b, base);
+            }
+        }
+        for (size_t i = 0; i < N; ++i)
+        {
+            r.local_active_info[i] = table[state[i]];
+        }
+    }
+    if (measures & INFORM_LOCAL_BLOCK_ENTROPY)
+    {
+        for (size_t h = 0; h < histories_size; ++h)
+        {
+            if (block.histogram[h] != 0)
+            {
+                table[h] = inform_shannon_si(&block, h, base);
+            }
+        }
+        // the blocks of a series are the histories of its observed states,
+        // followed by its last block
+        double *be = r.local_block_entropy;
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint64_t const *s = state + i * (m - k);
+            for (size_t j = 0; j < m - k; ++j)
+            {
+                *be++ = table[s[j] / b];
+            }
+            *be++ = table[last_block(series + i * m, m, b, k)];
+        }
+    }
+
+    inform_sized_free(table, states_size * sizeof(double));
+    inform_sized_free(state, N * sizeof(uint64_t));
+    inform_aligned_free(data, counters * sizeof(uint32_t));
+
+    *results = r;
+    return results;
+}
@@ -0,0 +1,440 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <inform/threads.h>
+#include <math.h>
+#include <string.h>
+#include "kernels.h"
+#include "memory.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define INFORM_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+/// the number of counts summed as a single unit of work
+#define BLOCK_SIZE (1 << 16)
+/// the minimum number of blocks worth splitting across threads
+#define PARALLEL_MIN_BLOCKS 16
+
+#define SQRT2 1.4142135623730951
+#define MANTISSA UINT64_C(0x000FFFFFFFFFFFFF)
+#define EXPONENT_ONE UINT64_C(0x3FF0000000000000)
+
+// log2(m) = 2 atanh(t) / ln(2) with t = (m - 1)/(m + 1). For m in
+// [sqrt(2)/2, sqrt(2)], |t| < 0.172 and the truncated series below is
+// accurate to within a few units in the last place.
+#define LOG2E 1.4426950408889634
+static double const series[] = {
+    2*LOG2E/1,  2*LOG2E/3,  2*LOG2E/5,  2*LOG2E/7,  2*LOG2E/9,  2*LOG2E/11,
+    2*LOG2E/13, 2*LOG2E/15, 2*LOG2E/17, 2*LOG2E/19, 2*LOG2E/21
+};
+#define SERIES_LENGTH (sizeof(series) / sizeof(double))
+
+/// the number of counts for which c log2(c) is cached
+#define TABLE_SIZE (1 << 12)
+
+// c log2(c) for every count c below TABLE_SIZE. The table is filled in its
+// entirety by whichever thread first needs it, and is read-only thereafter.
+static double table[TABLE_SIZE];
+
+enum { TABLE_EMPTY, TABLE_FILLING, TABLE_READY };
+
+// MSVC's C compiler doesn't provide <stdatomic.h> by default, so it uses
+// the equivalent interlocked intrinsics, each of which is a full barrier.
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+static long volatile table_state = TABLE_EMPTY;
+
+inline static int table_load(void)
+{
+    return (int) _InterlockedCompareExchange(&table_state, 0, 0);
+}
+
+inline static bool table_claim(void)
+{
+    return _InterlockedCompareExchange(&table_state, TABLE_FILLING,
+        TABLE_EMPTY) == TABLE_EMPTY;
+}
+
+inline static void table_publish(void)
+{
+    _InterlockedExchange(&table_state, TABLE_READY);
+}
+#else
+#include <stdatomic.h>
+static atomic_int table_state = TABLE_EMPTY;
+
+inline static int table_load(void)
+{
+    return atomic_load_explicit(&table_state, memory_order_acquire);
+}
+
+inline static bool table_claim(void)
+{
+    int empty = TABLE_EMPTY;
+    return atomic_compare_exchange_strong_explicit(&table_state, &empty,
+        TABLE_FILLING, memory_order_acquire, memory_order_relaxed);
+}
+
+inline static void table_publish(void)
+{
+    atomic_store_explicit(&table_state, TABLE_READY, memory_order_release);
+}
+#endif
+
+/**
+ * Ensure the c log2(c) table is filled, returning the number of its entries
+ * which can be looked up for a distribution of `counts` observations.
+ *
+ * This must not depend on OpenMP, as the library may be called from
+ * threads of the caller's own, so the first caller claims the table with an
+ * atomic compare-exchange and everyone else waits for it to be published.
+ */
+static size_t ensure_table(uint64_t counts)
+{
+    if (table_load() != TABLE_READY)
+    {
+        if (table_claim())
+        {
+            table[0] = 0.;
+            for (size_t c = 1; c < TABLE_SIZE; ++c)
+            {
+                table[c] = (double) c * log2((double) c);
+            }
+            table_publish();
+        }
+        else
+        {
+            while (table_load() != TABLE_READY);
+        }
+    }
+    // no count can exceed the total number of observations
+    return (counts < TABLE_SIZE) ? (size_t) counts + 1 : TABLE_SIZE;
+}
+
+inline static double log2_count(uint64_t count)
+{
+    double const c = (count == 0) ? 1.0 : (double) count;
+    // split c into 2^e * m with m in [1, 2)
+    uint64_t bits;
+    memcpy(&bits, &c, sizeof(bits));
+    double e = (double)(int)(bits >> 52) - 1023.0;
+    uint64_t const mbits = (bits & MANTISSA) | EXPONENT_ONE;
+    double m;
+    memcpy(&m, &mbits, sizeof(m));
+    // center the mantissa about one
+    if (m > SQRT2)
+    {
+        m = m * 0.5;
+        e = e + 1.0;
+    }
+    double const t = (m - 1.0) / (m + 1.0);
+    double const t2 = t * t;
+    double p = series[SERIES_LENGTH - 1];
+    for (size_t j = SERIES_LENGTH - 1; j > 0; --j)
+    {
+        p = p * t2 + series[j - 1];
+    }
+    return e + t * p;
+}
+
+inline static double clogp(uint64_t count, double log2n, size_t limit)
+{
+    // c log2(c/N) = c log2(c) - c log2(N), with c log2(c) cached for
+    // small counts; zero counts are in the table, so contribute nothing
+    if (count < limit)
+    {
+        return table[count] - (double) count * log2n;
+    }
+    return (double) count * (log2_count(count) - log2n);
+}
+
+// four partial sums, mirroring the lanes of the vectorized kernel, so that
+// every kernel gives the same result for the same counts
+#define DEFINE_BLOCK_CLOGP(NAME, TYPE) \
+    static double NAME(void const *counters, size_t n, double log2n, \
+        size_t limit) \
+    { \
+        TYPE const *histogram = counters; \
+        double lanes[4] = { 0., 0., 0., 0. }; \
+        for (size_t i = 0; i < n; ++i) \
+        { \
+            lanes[i % 4] += clogp(histogram[i], log2n, limit); \
+        } \
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]); \
+    }
+
+DEFINE_BLOCK_CLOGP(block_clogp8, uint8_t)
+DEFINE_BLOCK_CLOGP(block_clogp16, uint16_t)
+DEFINE_BLOCK_CLOGP(block_clogp, uint32_t)
+DEFINE_BLOCK_CLOGP(block_clogp64, uint64_t)
+
+#ifdef INFORM_HAVE_AVX2
+__attribute__((target("avx2")))
+inline static __m256d log2_count_avx2(__m256d count)
+{
+    __m256d const one = _mm256_set1_pd(1.0);
+    __m256d const half = _mm256_set1_pd(0.5);
+    __m256d const sqrt2 = _mm256_set1_pd(SQRT2);
+    __m256d const two52 = _mm256_set1_pd(4503599627370496.0);
+    __m256d const bias = _mm256_set1_pd(1023.0);
+    __m256i const mantissa = _mm256_set1_epi64x((long long) MANTISSA);
+    __m256i const exponent_one = _mm256_set1_epi64x((long long) EXPONENT_ONE);
+    __m256i const magic = _mm256_castpd_si256(two52);
+
+    __m256d const c = _mm256_max_pd(count, one);
+    // split c into 2^e * m with m in [1, 2)
+    __m256i const bits = _mm256_castpd_si256(c);
+    __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(
+        _mm256_or_si256(_mm256_srli_epi64(bits, 52), magic)), two52);
+    e = _mm256_sub_pd(e, bias);
+    __m256d m = _mm256_castsi256_pd(
+        _mm256_or_si256(_mm256_and_si256(bits, mantissa), exponent_one));
+    // center the mantissa about one
+    __m256d const mask = _mm256_cmp_pd(m, sqrt2, _CMP_GT_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, half), mask);
+    e = _mm256_add_pd(e, _mm256_and_pd(mask, one));
+    __m256d const t = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+    __m256d const t2 = _mm256_mul_pd(t, t);
+    __m256d p = _mm256_set1_pd(series[SERIES_LENGTH - 1]);
+    for (size_t j = SERIES_LENGTH - 1; j > 0; --j)
+    {
+        p = _mm256_add_pd(_mm256_mul_pd(p, t2), _mm256_set1_pd(series[j - 1]));
+    }
+    return _mm256_add_pd(e, _mm256_mul_pd(t, p));
+}
+
+__attribute__((target("avx2")))
+static double block_clogp_avx2(void const *counters, size_t n,
+    double log2n, size_t limit)
+{
+    uint32_t const *histogram = counters;
+    __m256d const two31 = _mm256_set1_pd(2147483648.0);
+    __m256d const offset = _mm256_set1_pd(log2n);
+    __m128i const flip = _mm_set1_epi32(INT32_MIN);
+    __m128i const bound = _mm_xor_si128(_mm_set1_epi32((int) limit), flip);
+
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        // convert the unsigned counts to doubles
+        __m128i const x = _mm_loadu_si128((__m128i const *)(histogram + i));
+        __m128i const flipped = _mm_xor_si128(x, flip);
+        __m256d const count = _mm256_add_pd(_mm256_cvtepi32_pd(flipped), two31);
+        // look up c log2(c) for the counts in the table, and send the rest
+        // to the (always present) zeroth entry
+        __m128i const cached = _mm_cmpgt_epi32(bound, flipped);
+        __m256d const clogc = _mm256_i32gather_pd(table, _mm_and_si128(x, cached), 8);
+        __m256d term = _mm256_sub_pd(clogc, _mm256_mul_pd(count, offset));
+        // fall back to evaluating the logarithm only if we must
+        if (_mm_movemask_epi8(cached) != 0xFFFF)
+        {
+            __m256d const log2c = log2_count_avx2(count);
+            __m256d const slow = _mm256_mul_pd(count, _mm256_sub_pd(log2c, offset));
+            term = _mm256_blendv_pd(slow, term,
+                _mm256_castsi256_pd(_mm256_cvtepi32_epi64(cached)));
+        }
+        acc = _mm256_add_pd(acc, term);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    for (; i < n; ++i)
+    {
+        lanes[i % 4] += clogp(histogram[i], log2n, limit);
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+#endif
+
+typedef double (*block_kernel)(void const *, size_t, double, size_t);
+
+static block_kernel select_kernel(size_t width)
+{
+    switch (width)
+    {
+        case sizeof(uint8_t):  return block_clogp8;
+        case sizeof(uint16_t): return block_clogp16;
+        case sizeof(uint64_t): return block_clogp64;
+    }
+#ifdef INFORM_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return block_clogp_avx2;
+    }
+#endif
+    return block_clogp;
+}
+
+double inform_sum_clogp(uint32_t const *histogram, size_t n, uint64_t counts)
+{
+    return inform_sum_clogp_width(histogram, sizeof(uint32_t), n, counts);
+}
+
+double inform_sum_clogp_width(void const *counters, size_t width, size_t n,
+    uint64_t counts)
+{
+    char const *histogram = counters;
+    double const log2n = log2((double) counts);
+    size_t const limit = ensure_table(counts);
+    block_kernel const kernel = select_kernel(width);
+    size_t const blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    double *partial = NULL;
+#ifdef _OPENMP
+    int const threads = inform_get_num_threads();
+    if (threads > 1 && blocks >= PARALLEL_MIN_BLOCKS)
+    {
+        partial = inform_malloc(blocks * sizeof(double));
+    }
+    if (partial != NULL)
+    {
+        #pragma omp parallel for num_threads(threads) schedule(static)
+        for (long long j = 0; j < (long long) blocks; ++j)
+        {
+            size_t const begin = (size_t) j * BLOCK_SIZE;
+            size_t const end = (begin + BLOCK_SIZE < n) ? begin + BLOCK_SIZE : n;
+            partial[j] = kernel(histogram + begin * width, end - begin, log2n, limit);
+        }
+    }
+#endif
+
+    // sum the blocks in order, whether or not they were computed in parallel
+    double sum = 0.;
+    for (size_t j = 0; j < blocks; ++j)
+    {
+        if (partial != NULL)
+        {
+            sum += partial[j];
+        }
+        else
+        {
+            size_t const begin = j * BLOCK_SIZE;
+            size_t const end = (begin + BLOCK_SIZE < n) ? begin + BLOCK_SIZE : n;
+            sum += kernel(histogram + begin * width, end - begin, log2n, limit);
+        }
+    }
+    inform_sized_free(partial, blocks * sizeof(double));
+    return sum;
+}
+
+double inform_clogc(uint64_t count)
+{
+    if (count < TABLE_SIZE)
+    {
+        ensure_table(count);
+        return table[count];
+    }
+    return (double) count * log2_count(count);
+}
+
+inline static uint64_t count_at(void const *counters, size_t width, size_t i)
+{
+    switch (width)
+    {
+        case sizeof(uint8_t):  return ((uint8_t const *) counters)[i];
+        case sizeof(uint16_t): return ((uint16_t const *) counters)[i];
+        case sizeof(uint64_t): return ((uint64_t const *) counters)[i];
+        default:               return ((uint32_t const *) counters)[i];
+    }
+}
+
+double inform_sum_clogp_indexed(void const *counters, size_t width,
+    size_t const *events, size_t n, uint64_t counts)
+{
+    double const log2n = log2((double) counts);
+    size_t const limit = ensure_table(counts);
+    // the events are scattered across the histogram, so there is nothing to
+    // gain from the vectorized kernel
+    double lanes[4] = { 0., 0., 0., 0. };
+    for (size_t i = 0; i < n; ++i)
+    {
+        lanes[i % 4] += clogp(count_at(counters, width, events[i]), log2n, limit);
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+inline static double clogc_below(uint64_t count, size_t limit)
+{
+    return (count < limit) ? table[count] : (double) count * log2_count(count);
+}
+
+/// the largest number of columns whose sums are kept on the stack
+#define STACK_COLUMNS 256
+
+#define DEFINE_BLOCK_CLOGC(NAME, TYPE) \
+    static void NAME(void const *counters, size_t blocks, size_t rows, \
+        size_t columns, size_t limit, uint64_t *sums, inform_clogc_sums *s) \
+    { \
+        TYPE const *c = counters; \
+        for (size_t k = 0; k < blocks; ++k) \
+        { \
+            memset(sums, 0, columns * sizeof(uint64_t)); \
+            uint64_t block = 0; \
+            for (size_t i = 0; i < rows; ++i, c += columns) \
+            { \
+                uint64_t row = 0; \
+                for (size_t j = 0; j < columns; ++j) \
+                { \
+                    s->joint += clogc_below(c[j], limit); \
+                    row += c[j]; \
+                    sums[j] += c[j]; \
+                } \
+                s->rows += clogc_below(row, limit); \
+                block += row; \
+            } \
+            for (size_t j = 0; j < columns; ++j) \
+            { \
+                s->columns += clogc_below(sums[j], limit); \
+            } \
+            s->blocks += clogc_below(block, limit); \
+        } \
+    }
+
+DEFINE_BLOCK_CLOGC(block_clogc8, uint8_t)
+DEFINE_BLOCK_CLOGC(block_clogc16, uint16_t)
+DEFINE_BLOCK_CLOGC(block_clogc32, uint32_t)
+DEFINE_BLOCK_CLOGC(block_clogc64, uint64_t)
+
+bool inform_sum_clogc_blocks(void const *counters, size_t width, size_t blocks,
+    size_t rows, size_t columns, uint64_t counts, inform_clogc_sums *sums)
+{
+    uint64_t stack[STACK_COLUMNS];
+    uint64_t *buffer = stack;
+    if (columns > STACK_COLUMNS)
+    {
+        buffer = inform_malloc(columns * sizeof(uint64_t));
+        if (buffer == NULL)
+        {
+            return true;
+        }
+    }
+    size_t const limit = ensure_table(counts);
+    inform_clogc_sums s = { 0., 0., 0., 0. };
+    switch (width)
+    {
+        case sizeof(uint8_t):
+            block_clogc8(counters, blocks, rows, columns, limit, buffer, &s);
+            break;
+        case sizeof(uint16_t):
+            block_clogc16(counters, blocks, rows, columns, limit, buffer, &s);
+            break;
+        case sizeof(uint64_t):
+            block_clogc64(counters, blocks, rows, columns, limit, buffer, &s);
+            break;
+        default:
+            block_clogc32(counters, blocks, rows, columns, limit, buffer, &s);
+            break;
+    }
+    if (buffer != stack)
+    {
+        inform_sized_free(buffer, columns * sizeof(uint64_t));
+    }
+    *sums = s;
+    return false;
+}
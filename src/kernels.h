@@ -0,0 +1,74 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Compute the sum of `c log2(c/N)` over the `n` counts `c` of a histogram
+ * which has made `N = counts` observations, taking `0 log2(0) = 0`.
+ *
+ * For small counts, `c log2(c)` is taken from a process-wide table of a few
+ * thousand entries, which is filled once on first use; larger counts have
+ * their logarithm evaluated directly. The sum is vectorized when the processor
+ * supports AVX2, and split across the threads configured via
+ * inform_set_num_threads when the histogram is large. The counts are always
+ * summed in the same order, so the result does not depend on the number of
+ * threads.
+ */
+double inform_sum_clogp(uint32_t const *histogram, size_t n, uint64_t counts);
+
+/**
+ * Compute the same sum as inform_sum_clogp over a histogram of unsigned
+ * counters which are each `width` bytes wide, where `width` is 1, 2, 4 or 8.
+ *
+ * Only 32-bit counters are vectorized, but every width gives exactly the
+ * same result for the same counts.
+ */
+double inform_sum_clogp_width(void const *counters, size_t width, size_t n,
+    uint64_t counts);
+
+/**
+ * Compute `c log2(c)` for a count `c`, taking `0 log2(0) = 0`, exactly as
+ * it is computed by inform_sum_clogp.
+ */
+double inform_clogc(uint64_t count);
+
+/**
+ * Compute the same sum as inform_sum_clogp_width over only the `n` counters
+ * of a histogram whose indices are listed in `events`, which must be
+ * distinct. Any counters which are not listed are taken to be zero.
+ */
+double inform_sum_clogp_indexed(void const *counters, size_t width,
+    size_t const *events, size_t n, uint64_t counts);
+
+/**
+ * The sums of `c log2(c)` over the counts of a histogram of blocks of rows
+ * and columns, and over the sums of its rows, columns and blocks
+ */
+typedef struct inform_clogc_sums
+{
+    /// over the counts of the histogram
+    double joint;
+    /// over the sums of each row of each block
+    double rows;
+    /// over the sums of each column of each block
+    double columns;
+    /// over the sums of each block
+    double blocks;
+} inform_clogc_sums;
+
+/**
+ * Compute the sums of `c log2(c)` over a histogram of `blocks` blocks of
+ * `rows` by `columns` counters, each `width` bytes wide, laid out block by
+ * block and row by row, and over its row, column and block sums, all in a
+ * single pass. The column sums of the current block are kept in a buffer of
+ * `columns` counts.
+ *
+ * Returns `true` if the buffer can't be allocated.
+ */
+bool inform_sum_clogc_blocks(void const *counters, size_t width, size_t blocks,
+    size_t rows, size_t columns, uint64_t counts, inform_clogc_sums *sums);
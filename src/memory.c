@@ -0,0 +1,210 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include "memory.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+/// the alignment of memory returned by malloc
+#define MALLOC_ALIGNMENT _Alignof(max_align_t)
+
+static void *default_alloc(size_t size, size_t alignment, void *context)
+{
+    if (alignment <= MALLOC_ALIGNMENT)
+    {
+        return malloc(size);
+    }
+    void *ptr = NULL;
+#ifdef _WIN32
+    ptr = _aligned_malloc(size, alignment);
+#else
+    if (posix_memalign(&ptr, alignment, size) != 0)
+    {
+        ptr = NULL;
+    }
+#endif
+    return ptr;
+}
+
+static void *default_zalloc(size_t size, size_t alignment, void *context)
+{
+    if (alignment <= MALLOC_ALIGNMENT)
+    {
+        // calloc can hand out pages which the system has already zeroed
+        return calloc(size, 1);
+    }
+    void *ptr = default_alloc(size, alignment, context);
+    if (ptr != NULL)
+    {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+static void *default_realloc(void *ptr, size_t old, size_t size,
+    size_t alignment, void *context)
+{
+    if (alignment <= MALLOC_ALIGNMENT)
+    {
+        return realloc(ptr, size);
+    }
+#ifdef _WIN32
+    return _aligned_realloc(ptr, size, alignment);
+#else
+    // realloc only promises malloc's alignment, so move the block ourselves
+    void *moved = default_alloc(size, alignment, context);
+    if (moved != NULL)
+    {
+        memcpy(moved, ptr, (old < size) ? old : size);
+        free(ptr);
+    }
+    return moved;
+#endif
+}
+
+static void default_free(void *ptr, size_t size, size_t alignment,
+    void *context)
+{
+#ifdef _WIN32
+    if (alignment > MALLOC_ALIGNMENT)
+    {
+        _aligned_free(ptr);
+        return;
+    }
+#endif
+    free(ptr);
+}
+
+static inform_allocator const default_allocator =
+{
+    default_alloc, default_zalloc, default_realloc, default_free, NULL
+};
+
+static inform_allocator allocator =
+{
+    default_alloc, default_zalloc, default_realloc, default_free, NULL
+};
+
+void inform_set_allocator(inform_allocator const *a)
+{
+    if (a == NULL || a->alloc == NULL || a->free == NULL)
+    {
+        allocator = default_allocator;
+    }
+    else
+    {
+        allocator = *a;
+    }
+}
+
+inform_allocator inform_get_allocator(void)
+{
+    return allocator;
+}
+
+/**
+ * The size of the block the hooks are asked for to hold `size` bytes.
+ */
+inline static size_t block_size(size_t size)
+{
+    // never ask the hooks for an empty block, which may come back NULL
+    return (size == 0) ? 1 : size;
+}
+
+static void *allocate(size_t size, size_t alignment, bool zeroed)
+{
+    size = block_size(size);
+    if (zeroed && allocator.zalloc != NULL)
+    {
+        return allocator.zalloc(size, alignment, allocator.context);
+    }
+    void *ptr = allocator.alloc(size, alignment, allocator.context);
+    if (zeroed && ptr != NULL)
+    {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void *inform_malloc(size_t size)
+{
+    return allocate(size, MALLOC_ALIGNMENT, false);
+}
+
+void *inform_calloc(size_t n, size_t size)
+{
+    if (size != 0 && n > SIZE_MAX / size)
+    {
+        return NULL;
+    }
+    return allocate(n * size, MALLOC_ALIGNMENT, true);
+}
+
+void inform_free(void *ptr)
+{
+    if (ptr != NULL)
+    {
+        allocator.free(ptr, 0, MALLOC_ALIGNMENT, allocator.context);
+    }
+}
+
+void inform_sized_free(void *ptr, size_t size)
+{
+    if (ptr != NULL)
+    {
+        allocator.free(ptr, block_size(size), MALLOC_ALIGNMENT,
+            allocator.context);
+    }
+}
+
+void *inform_aligned_calloc(size_t n, size_t size)
+{
+    if (size != 0 && n > SIZE_MAX / size)
+    {
+        return NULL;
+    }
+    return allocate(n * size, INFORM_ALIGNMENT, true);
+}
+
+void *inform_aligned_realloc(void *ptr, size_t old, size_t size)
+{
+    if (ptr == NULL)
+    {
+        return inform_aligned_calloc(size, 1);
+    }
+    old = block_size(old);
+    size = block_size(size);
+    void *moved = NULL;
+    if (allocator.realloc != NULL)
+    {
+        moved = allocator.realloc(ptr, old, size, INFORM_ALIGNMENT,
+            allocator.context);
+    }
+    else
+    {
+        moved = allocator.alloc(size, INFORM_ALIGNMENT, allocator.context);
+        if (moved != NULL)
+        {
+            memcpy(moved, ptr, (old < size) ? old : size);
+            allocator.free(ptr, old, INFORM_ALIGNMENT, allocator.context);
+        }
+    }
+    if (moved != NULL && old < size)
+    {
+        memset((char *) moved + old, 0, size - old);
+    }
+    return moved;
+}
+
+void inform_aligned_free(void *ptr, size_t size)
+{
+    if (ptr != NULL)
+    {
+        allocator.free(ptr, block_size(size), INFORM_ALIGNMENT,
+            allocator.context);
+    }
+}
@@ -0,0 +1,58 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/allocator.h>
+#include <stdint.h>
+
+/// the alignment, in bytes, of histograms allocated by the library
+#define INFORM_ALIGNMENT 64
+
+/**
+ * Allocate `size` bytes with the installed allocator, aligned as `malloc`
+ * would align them. Returns `NULL` if the allocation fails. The memory must
+ * be released with inform_sized_free, or with inform_free once it has been
+ * handed to the caller.
+ */
+void *inform_malloc(size_t size);
+
+/**
+ * Allocate a zeroed array of `n` elements of `size` bytes each with the
+ * installed allocator, aligned as `malloc` would align it. Returns `NULL`
+ * if the allocation fails. The memory must be released with
+ * inform_sized_free.
+ */
+void *inform_calloc(size_t n, size_t size);
+
+/**
+ * Free `size` bytes allocated with inform_malloc or inform_calloc, passing
+ * the size on to the allocator.
+ */
+void inform_sized_free(void *ptr, size_t size);
+
+/**
+ * Allocate a zeroed array of `n` elements of `size` bytes each, aligned to
+ * an INFORM_ALIGNMENT-byte boundary so that vectorized kernels can use
+ * aligned loads.
+ *
+ * Returns `NULL` if the allocation fails. The memory must be released with
+ * inform_aligned_free.
+ */
+void *inform_aligned_calloc(size_t n, size_t size);
+
+/**
+ * Resize an array allocated with inform_aligned_calloc from `old` to `size`
+ * bytes, keeping it aligned. The contents are preserved up to the smaller
+ * of the two sizes, and any newly added bytes are zeroed.
+ *
+ * Returns `NULL`, leaving the original array unscathed, if the allocation
+ * fails.
+ */
+void *inform_aligned_realloc(void *ptr, size_t old, size_t size);
+
+/**
+ * Free `size` bytes allocated with inform_aligned_calloc or
+ * inform_aligned_realloc.
+ */
+void inform_aligned_free(void *ptr, size_t size);
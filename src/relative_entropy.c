@@ -3,6 +3,22 @@
 // license that can be found in the LICENSE file.
 #include <inform/relative_entropy.h>
 #include <inform/shannon.h>
+#include "counters.h"
+#include "memory.h"
+#include "scratch.h"
+
+static bool check_shape(size_t n, int b, inform_error *err)
+{
+    if (n < 1)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ESHORTSERIES, true);
+    }
+    else if (b < 2)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EBASE, true);
+    }
+    return false;
+}
 
 static bool check_arguments(int const *xs, int const *ys, size_t n, int b,
     inform_error *err)
@@ -15,13 +31,9 @@ static bool check_arguments(int const *xs, int const *ys, size_t n, int b,
     {
         INFORM_ERROR_RETURN(err, INFORM_ETIMESERIES, true);
     }
-    else if (n < 1)
+    else if (check_shape(n, b, err))
     {
-        INFORM_ERROR_RETURN(err, INFORM_ESHORTSERIES, true);
-    }
-    else if (b < 2)
-    {
-        INFORM_ERROR_RETURN(err, INFORM_EBASE, true);
+        return true;
     }
     for (size_t i = 0; i < n; ++i)
     {
@@ -37,21 +49,6 @@ static bool check_arguments(int const *xs, int const *ys, size_t n, int b,
     return false;
 }
 
-inline static bool allocate(int b, inform_dist **x, inform_dist **y,
-    inform_error *err)
-{
-    if ((*x = inform_dist_alloc(b)) == NULL)
-    {
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, true);
-    }
-    if ((*y = inform_dist_alloc(b)) == NULL)
-    {
-        inform_dist_free(*x);
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, true);
-    }
-    return false;
-}
-
 inline static void accumulate(int const *xs, int const *ys, size_t n,
     inform_dist *x, inform_dist *y)
 {
@@ -65,52 +62,95 @@ inline static void accumulate(int const *xs, int const *ys, size_t n,
     }
 }
 
-inline static void free_all(inform_dist **x, inform_dist **y)
+inform_workspace_plan inform_relative_entropy_plan(size_t n, int b,
+    inform_error *err)
 {
-    inform_dist_free(*x);
-    inform_dist_free(*y);
+    inform_workspace_plan p = { 0, 0, 0, 0, false };
+    if (check_shape(n, b, err)) return p;
+    return inform_plan_dense(2 * (size_t) b, 0, 0, 0);
+}
+
+inform_workspace_plan inform_local_relative_entropy_plan(size_t n, int b,
+    inform_error *err)
+{
+    inform_workspace_plan p = { 0, 0, 0, 0, false };
+    if (check_shape(n, b, err)) return p;
+    return inform_plan_dense(2 * (size_t) b, 0, 0, n);
 }
 
 double inform_relative_entropy(int const *xs, int const *ys, size_t n, int b,
     double base, inform_error *err)
 {
+    inform_workspace ws = { NULL, 0, false, true };
+    double const re = inform_relative_entropy_ws(xs, ys, n, b, base, &ws, err);
+    inform_aligned_free(ws.buffer, ws.size);
+    return re;
+}
+
+double inform_relative_entropy_ws(int const *xs, int const *ys, size_t n, int b,
+    double base, inform_workspace *ws, inform_error *err)
+{
+    if (ws == NULL) return inform_relative_entropy(xs, ys, n, b, base, err);
+
     if (check_arguments(xs, ys, n, b, err)) return NAN;
 
-    inform_dist *x = NULL, *y = NULL;
-    if (allocate(b, &x, &y, err)) return NAN;
+    size_t const data_bytes = 2 * (size_t) b * sizeof(uint32_t);
 
-    accumulate(xs, ys, n, x, y);
+    uint32_t *data = inform_scratch(ws, data_bytes, data_bytes);
+    if (data == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NAN);
+    }
 
-    double re = inform_shannon_re(x, y, base);
+    inform_dist x = inform_dist_view(data, b, 0);
+    inform_dist y = inform_dist_view(data + b, b, 0);
 
-    free_all(&x, &y);
+    accumulate(xs, ys, n, &x, &y);
 
-    return re;
+    return inform_shannon_re(&x, &y, base);
 }
 
 double *inform_local_relative_entropy(int const *xs, int const *ys, size_t n,
     int b, double base, double *re, inform_error *err)
 {
+    inform_workspace ws = { NULL, 0, false, true };
+    re = inform_local_relative_entropy_ws(xs, ys, n, b, base, re, &ws, err);
+    inform_aligned_free(ws.buffer, ws.size);
+    return re;
+}
+
+double *inform_local_relative_entropy_ws(int const *xs, int const *ys,
+    size_t n, int b, double base, double *re, inform_workspace *ws,
+    inform_error *err)
+{
+    if (ws == NULL) return inform_local_relative_entropy(xs, ys, n, b, base, re, err);
+
     if (check_arguments(xs, ys, n, b, err)) return NULL;
 
+    size_t const data_bytes = 2 * (size_t) b * sizeof(uint32_t);
+
+    uint32_t *data = inform_scratch(ws, data_bytes, data_bytes);
+    if (data == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
     if (re == NULL)
     {
-        re = malloc(n * sizeof(double));
+        re = inform_malloc(n * sizeof(double));
         if (re == NULL)
             INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
     }
 
-    inform_dist *x = NULL, *y = NULL;
-    if (allocate(b, &x, &y, err)) return NULL;
+    inform_dist x = inform_dist_view(data, b, 0);
+    inform_dist y = inform_dist_view(data + b, b, 0);
 
-    accumulate(xs, ys, n, x, y);
+    accumulate(xs, ys, n, &x, &y);
 
     for (size_t i = 0; i < (size_t) b; ++i)
     {
-        re[i] = inform_shannon_pre(x, y, i, base);
+        re[i] = inform_shannon_pre(&x, &y, i, base);
     }
 
-    free_all(&x, &y);
-
     return re;
-}
\ No newline at end of file
+}
@@ -0,0 +1,112 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#pragma once
+
+#include <inform/sparse_dist.h>
+#include <inform/workspace.h>
+#include <stdint.h>
+#include <string.h>
+
+/// the alignment, in bytes, of each region carved out of a workspace
+#define INFORM_SCRATCH_ALIGNMENT 64
+
+/**
+ * Round a size in bytes up so that the region which follows it is aligned.
+ */
+inline static size_t inform_scratch_align(size_t bytes)
+{
+    return (bytes + INFORM_SCRATCH_ALIGNMENT - 1) &
+        ~(size_t)(INFORM_SCRATCH_ALIGNMENT - 1);
+}
+
+/**
+ * Take `bytes` of scratch space from a workspace, the first `zeroed` of which
+ * are guaranteed to be zero. Returns `NULL` if the space can't be had.
+ */
+inline static void *inform_scratch(inform_workspace *ws, size_t bytes,
+    size_t zeroed)
+{
+    void *buffer = inform_workspace_reserve(ws, bytes);
+    if (buffer != NULL)
+    {
+        if (ws->dirty)
+        {
+            memset(buffer, 0, zeroed);
+        }
+        ws->dirty = true;
+    }
+    return buffer;
+}
+
+/**
+ * Plan the workspace of a measure with dense histograms of `counters` counters
+ * which, if it is local, records `states` observed states and a table of
+ * `table` local values and outputs `outputs` values.
+ *
+ * The workspace is laid out as the histograms, then the observed states,
+ * then the table, each region aligned.
+ */
+inline static inform_workspace_plan inform_plan_dense(size_t counters,
+    size_t states, size_t table, size_t outputs)
+{
+    inform_workspace_plan plan;
+    plan.histogram = counters * sizeof(uint32_t);
+    plan.scratch = table * sizeof(double);
+    if (states != 0)
+    {
+        plan.scratch += inform_scratch_align(states * sizeof(uint64_t));
+    }
+    plan.output = outputs * sizeof(double);
+    plan.workspace = (plan.scratch == 0) ? plan.histogram :
+        inform_scratch_align(plan.histogram) + plan.scratch;
+    plan.sparse = false;
+    return plan;
+}
+
+/**
+ * Plan a measure with sparse histograms occupying at most `histogram` bytes
+ * which, if it is local, records `states` observed states and a table of
+ * local values indexed by the slots of a sparse distribution of `states`
+ * events, and outputs `outputs` values.
+ */
+inline static inform_workspace_plan inform_plan_sparse(size_t histogram,
+    size_t states, size_t outputs)
+{
+    inform_workspace_plan plan;
+    plan.histogram = histogram;
+    plan.scratch = 0;
+    if (states != 0)
+    {
+        // a table of doubles has fewer bytes per slot than the distribution
+        plan.scratch = states * sizeof(uint64_t) + inform_sparse_dist_bytes(states);
+    }
+    plan.output = outputs * sizeof(double);
+    plan.workspace = 0;
+    plan.sparse = true;
+    return plan;
+}
+
+/**
+ * Get the observed states region of a workspace laid out by inform_plan_dense.
+ */
+inline static uint64_t *inform_scratch_states(void *scratch,
+    inform_workspace_plan const *plan)
+{
+    return (uint64_t *)((char *) scratch + inform_scratch_align(plan->histogram));
+}
+
+/**
+ * Get the table region of a workspace laid out by inform_plan_dense for a
+ * measure which records `states` observed states.
+ */
+inline static double *inform_scratch_table(void *scratch,
+    inform_workspace_plan const *plan, size_t states)
+{
+    size_t offset = inform_scratch_align(plan->histogram);
+    if (states != 0)
+    {
+        offset += inform_scratch_align(states * sizeof(uint64_t));
+    }
+    return (double *)((char *) scratch + offset);
+}
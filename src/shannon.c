@@ -3,6 +3,8 @@
 // license that can be found in the LICENSE file.
 #include <inform/shannon.h>
 #include <inform/error.h>
+#include "counters.h"
+#include "kernels.h"
 
 double inform_shannon_si(inform_dist const *dist, size_t event, double base)
 {
@@ -13,25 +15,45 @@ double inform_shannon_si(inform_dist const *dist, size_t event, double base)
     return NAN;
 }
 
+/**
+ * Compute the entropy, in bits, of a valid distribution by visiting its
+ * counts.
+ */
+static double shannon_scan(inform_dist const *dist)
+{
+    // since every probability is a count over the total number of
+    // observations N, H = -(1/N) sum_i c_i log2(c_i/N)
+    size_t const width = inform_counter_bytes(dist->width);
+    // when the nonzero events are known, only they need to be visited
+    double const sum = (dist->nonzero != NULL) ?
+        inform_sum_clogp_indexed(dist->counters, width, dist->nonzero,
+            dist->nonzero_size, dist->counts) :
+        inform_sum_clogp_width(dist->counters, width, dist->size,
+            dist->counts);
+    return -sum / (double) dist->counts;
+}
+
 double inform_shannon(inform_dist const *dist, double base)
 {
     // ensure that the distribution is valid
     if (inform_dist_is_valid(dist))
     {
-        // get the size of the distribution's support
-        size_t const n = inform_dist_size(dist);
-        double h = 0.;
-        // for each element of the distribution's support
-        for (size_t i = 0; i < n; ++i)
+        double h;
+        // given a running sum of c log2(c),
+        // H = log2(N) - (1/N) sum_i c_i log2(c_i)
+        if (dist->track_entropy)
         {
-            // the observation_count is non-zero
-            if (dist->histogram[i] != 0)
-            {
-                // get the probability
-                double const p = (double) dist->histogram[i] / dist->counts;
-                // accumulate the weighted self-information of the event
-                h -= p * log2(p);
-            }
+            double const n = (double) dist->counts;
+            h = log2(n) - (dist->clogc + dist->clogc_error) / n;
+        }
+        else
+        {
+            h = shannon_scan(dist);
+        }
+        // don't let rounding push a vanishing entropy below zero
+        if (h < 0.)
+        {
+            h = 0.;
         }
         // return the entropy
         return h / log2(base);
@@ -91,6 +113,66 @@ double inform_shannon_cmi(inform_dist const *joint,
         inform_shannon(marginal_z, base);
 }
 
+/**
+ * Compute the sums of c log2(c) over a joint distribution of bz blocks of
+ * bx by by events and over its marginals.
+ *
+ * Returns `true` if the distribution is invalid, is not of the given shape,
+ * or the sums can't be computed.
+ */
+static bool joint_sums(inform_dist const *joint, size_t bz, size_t bx,
+    size_t by, inform_clogc_sums *sums)
+{
+    if (!inform_dist_is_valid(joint) || bz == 0 || bx == 0 || by == 0 ||
+        bx > SIZE_MAX / by || bz > SIZE_MAX / (bx * by) ||
+        bz * bx * by != joint->size)
+    {
+        return true;
+    }
+    return inform_sum_clogc_blocks(joint->counters,
+        inform_counter_bytes(joint->width), bz, bx, by, joint->counts, sums);
+}
+
+double inform_shannon_joint_mi(inform_dist const *joint, size_t bx,
+    size_t by, double base)
+{
+    inform_clogc_sums s;
+    if (joint_sums(joint, 1, bx, by, &s))
+    {
+        return NAN;
+    }
+    // with H = log2(N) - S/N for each of the joint and marginal sums S,
+    // I(X;Y) = H(X) + H(Y) - H(X,Y) = log2(N) + (S_xy - S_x - S_y)/N
+    double const n = (double) joint->counts;
+    return (log2(n) + (s.joint - s.rows - s.columns) / n) / log2(base);
+}
+
+double inform_shannon_joint_ce(inform_dist const *joint, size_t bx,
+    size_t by, double base)
+{
+    inform_clogc_sums s;
+    if (joint_sums(joint, 1, bx, by, &s))
+    {
+        return NAN;
+    }
+    // H(Y|X) = H(X,Y) - H(X) = (S_x - S_xy)/N
+    return ((s.rows - s.joint) / (double) joint->counts) / log2(base);
+}
+
+double inform_shannon_joint_cmi(inform_dist const *joint, size_t bz,
+    size_t bx, size_t by, double base)
+{
+    inform_clogc_sums s;
+    if (joint_sums(joint, bz, bx, by, &s))
+    {
+        return NAN;
+    }
+    // I(X;Y|Z) = H(X,Z) + H(Y,Z) - H(X,Y,Z) - H(Z)
+    //          = (S_xyz + S_z - S_xz - S_yz)/N
+    return ((s.joint + s.blocks - s.rows - s.columns) /
+        (double) joint->counts) / log2(base);
+}
+
 double inform_shannon_pre(inform_dist const *p, inform_dist const *q,
     size_t event, double base)
 {
@@ -107,17 +189,119 @@ double inform_shannon_re(inform_dist const *p, inform_dist const *q,
     double base)
 {
     if (inform_dist_is_valid(p) && inform_dist_is_valid(q) && p->size == q->size)
+    {
+        double re = 0.;
+        // only the events observed by p contribute, so when they are known
+        // only they need to be visited
+        size_t const n = (p->nonzero != NULL) ? p->nonzero_size : p->size;
+        for (size_t j = 0; j < n; ++j)
+        {
+            size_t const i = (p->nonzero != NULL) ? p->nonzero[j] : j;
+            uint64_t const a = inform_counter_get(p->counters, p->width, i);
+            uint64_t const b = inform_counter_get(q->counters, q->width, i);
+            if (a != 0 && b != 0)
+            {
+                double u = (double) a / p->counts;
+                double v = (double) b / q->counts;
+                re += u * log2(u / v);
+            }
+            else if (a != 0 && b == 0)
+            {
+                return NAN;
+            }
+        }
+        return re / log2(base);
+    }
+    return NAN;
+}
+
+double inform_sparse_shannon_si(inform_sparse_dist const *dist, uint64_t event,
+    double base)
+{
+    if (inform_sparse_dist_is_valid(dist))
+    {
+        return -log2(inform_sparse_dist_prob(dist, event)) / log2(base);
+    }
+    return NAN;
+}
+
+double inform_sparse_shannon(inform_sparse_dist const *dist, double base)
+{
+    // ensure that the distribution is valid
+    if (inform_sparse_dist_is_valid(dist))
+    {
+        double h = 0.;
+        // for each slot in the table
+        for (size_t i = 0; i < dist->capacity; ++i)
+        {
+            // the slot is occupied and the observation count is non-zero
+            if (dist->events[i] != INFORM_SPARSE_EMPTY && dist->histogram[i] != 0)
+            {
+                // get the probability
+                double const p = (double) dist->histogram[i] / dist->counts;
+                // accumulate the weighted self-information of the event
+                h -= p * log2(p);
+            }
+        }
+        // return the entropy
+        return h / log2(base);
+    }
+    // return NaN if the distribution is invalid
+    return NAN;
+}
+
+double inform_decay_shannon_si(inform_decay_dist const *dist, size_t event,
+    double base)
+{
+    if (inform_decay_dist_is_valid(dist))
+    {
+        return -log2(inform_decay_dist_prob(dist, event)) / log2(base);
+    }
+    return NAN;
+}
+
+double inform_decay_shannon(inform_decay_dist const *dist, double base)
+{
+    // ensure that the distribution is valid
+    if (inform_decay_dist_is_valid(dist))
+    {
+        double h = 0.;
+        for (size_t i = 0; i < dist->size; ++i)
+        {
+            // the weights of long past observations can underflow to zero
+            if (dist->weights[i] > 0.)
+            {
+                double const p = dist->weights[i] / dist->total;
+                h -= p * log2(p);
+            }
+        }
+        // don't let rounding push a vanishing entropy below zero
+        if (h < 0.)
+        {
+            h = 0.;
+        }
+        return h / log2(base);
+    }
+    // return NaN if the distribution is invalid
+    return NAN;
+}
+
+double inform_decay_shannon_re(inform_decay_dist const *p,
+    inform_decay_dist const *q, double base)
+{
+    if (inform_decay_dist_is_valid(p) && inform_decay_dist_is_valid(q) &&
+        p->size == q->size)
     {
         double re = 0.;
         for (size_t i = 0; i < p->size; ++i)
         {
-            if (p->histogram[i] != 0 && q->histogram[i] != 0)
+            if (p->weights[i] > 0. && q->weights[i] > 0.)
             {
-                double u = (double) p->histogram[i] / p->counts;
-                double v = (double) q->histogram[i] / q->counts;
+                double const u = p->weights[i] / p->total;
+                double const v = q->weights[i] / q->total;
                 re += u * log2(u / v);
             }
-            else if (p->histogram[i] != 0 && q->histogram[i] == 0)
+            else if (p->weights[i] > 0.)
             {
                 return NAN;
             }
@@ -125,4 +309,4 @@ double inform_shannon_re(inform_dist const *p, inform_dist const *q,
         return re / log2(base);
     }
     return NAN;
-}
\ No newline at end of file
+}
@@ -0,0 +1,252 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <inform/sparse_dist.h>
+#include <string.h>
+#include "memory.h"
+
+/// the smallest number of slots in a table
+#define MIN_CAPACITY 16
+/// the minimum size of a support for which a sparse distribution is used
+#define SPARSE_MIN_SUPPORT (1 << 16)
+
+inline static size_t slot_of(uint64_t event, size_t capacity)
+{
+    // fibonacci hashing folds the high bits down onto the low bits
+    uint64_t h = event * UINT64_C(0x9E3779B97F4A7C15);
+    h ^= h >> 32;
+    return (size_t)(h & (capacity - 1));
+}
+
+inline static size_t find(inform_sparse_dist const *dist, uint64_t event)
+{
+    // probe linearly until either the event or an empty slot is found
+    size_t i = slot_of(event, dist->capacity);
+    while (dist->events[i] != event && dist->events[i] != INFORM_SPARSE_EMPTY)
+    {
+        i = (i + 1) & (dist->capacity - 1);
+    }
+    return i;
+}
+
+static bool init_table(inform_sparse_dist *dist, size_t capacity)
+{
+    dist->events = inform_malloc(capacity * sizeof(uint64_t));
+    if (dist->events == NULL)
+    {
+        return true;
+    }
+    dist->histogram = inform_malloc(capacity * sizeof(uint32_t));
+    if (dist->histogram == NULL)
+    {
+        inform_sized_free(dist->events, capacity * sizeof(uint64_t));
+        return true;
+    }
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        dist->events[i] = INFORM_SPARSE_EMPTY;
+    }
+    dist->capacity = capacity;
+    return false;
+}
+
+static bool grow(inform_sparse_dist *dist)
+{
+    uint64_t *events = dist->events;
+    uint32_t *histogram = dist->histogram;
+    size_t const capacity = dist->capacity;
+    // allocate a table twice the size of the current one
+    if (init_table(dist, 2 * capacity))
+    {
+        // leave the original table unscathed
+        dist->events = events;
+        dist->histogram = histogram;
+        return true;
+    }
+    // rehash every occupied slot into the new table
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        if (events[i] != INFORM_SPARSE_EMPTY)
+        {
+            size_t const j = find(dist, events[i]);
+            dist->events[j] = events[i];
+            dist->histogram[j] = histogram[i];
+        }
+    }
+    inform_sized_free(histogram, capacity * sizeof(uint32_t));
+    inform_sized_free(events, capacity * sizeof(uint64_t));
+    return false;
+}
+
+inline static bool needs_growth(inform_sparse_dist const *dist)
+{
+    // keep the load factor of the table below 3/4
+    return 4 * (dist->size + 1) > 3 * dist->capacity;
+}
+
+inline static size_t capacity_for(size_t n)
+{
+    // choose the smallest power of two which holds n events without growing
+    size_t capacity = MIN_CAPACITY;
+    while (3 * capacity < 4 * (n + 1))
+    {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+inform_sparse_dist *inform_sparse_dist_alloc(size_t n)
+{
+    size_t const capacity = capacity_for(n);
+    inform_sparse_dist *dist = inform_malloc(sizeof(inform_sparse_dist));
+    if (dist != NULL)
+    {
+        if (init_table(dist, capacity))
+        {
+            inform_sized_free(dist, sizeof(inform_sparse_dist));
+            return NULL;
+        }
+        dist->size = 0;
+        dist->counts = 0;
+    }
+    return dist;
+}
+
+void inform_sparse_dist_free(inform_sparse_dist *dist)
+{
+    if (dist != NULL)
+    {
+        inform_sized_free(dist->histogram, dist->capacity * sizeof(uint32_t));
+        inform_sized_free(dist->events, dist->capacity * sizeof(uint64_t));
+        inform_sized_free(dist, sizeof(inform_sparse_dist));
+    }
+}
+
+size_t inform_sparse_dist_size(inform_sparse_dist const *dist)
+{
+    return (dist == NULL) ? 0 : dist->size;
+}
+
+uint64_t inform_sparse_dist_counts(inform_sparse_dist const *dist)
+{
+    return (dist == NULL) ? 0 : dist->counts;
+}
+
+bool inform_sparse_dist_is_valid(inform_sparse_dist const *dist)
+{
+    return dist != NULL && dist->counts != 0;
+}
+
+uint32_t inform_sparse_dist_get(inform_sparse_dist const *dist, uint64_t event)
+{
+    if (dist == NULL || event == INFORM_SPARSE_EMPTY)
+    {
+        return 0;
+    }
+    size_t const i = find(dist, event);
+    return (dist->events[i] == event) ? dist->histogram[i] : 0;
+}
+
+size_t inform_sparse_dist_slot(inform_sparse_dist const *dist, uint64_t event)
+{
+    if (dist == NULL || event == INFORM_SPARSE_EMPTY)
+    {
+        return SIZE_MAX;
+    }
+    size_t const i = find(dist, event);
+    return (dist->events[i] == event) ? i : SIZE_MAX;
+}
+
+uint32_t inform_sparse_dist_set(inform_sparse_dist *dist, uint64_t event,
+    uint32_t x, inform_error *err)
+{
+    if (dist == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EDIST, 0);
+    }
+    else if (event == INFORM_SPARSE_EMPTY)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EARG, 0);
+    }
+    size_t i = find(dist, event);
+    if (dist->events[i] == event)
+    {
+        dist->counts -= dist->histogram[i];
+    }
+    else
+    {
+        // a new event needs a slot, so the table may have to grow first
+        if (needs_growth(dist))
+        {
+            if (grow(dist))
+            {
+                INFORM_ERROR_RETURN(err, INFORM_ENOMEM, 0);
+            }
+            i = find(dist, event);
+        }
+        dist->events[i] = event;
+        dist->size += 1;
+    }
+    dist->counts += x;
+    return (dist->histogram[i] = x);
+}
+
+uint32_t inform_sparse_dist_tick(inform_sparse_dist *dist, uint64_t event,
+    inform_error *err)
+{
+    if (dist == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EDIST, 0);
+    }
+    else if (event == INFORM_SPARSE_EMPTY)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EARG, 0);
+    }
+    size_t i = find(dist, event);
+    if (dist->events[i] == event && dist->histogram[i] == UINT32_MAX)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EOVERFLOW, 0);
+    }
+    if (dist->events[i] != event)
+    {
+        if (needs_growth(dist))
+        {
+            if (grow(dist))
+            {
+                INFORM_ERROR_RETURN(err, INFORM_ENOMEM, 0);
+            }
+            i = find(dist, event);
+        }
+        dist->events[i] = event;
+        dist->histogram[i] = 0;
+        dist->size += 1;
+    }
+    dist->counts += 1;
+    return (dist->histogram[i] += 1);
+}
+
+double inform_sparse_dist_prob(inform_sparse_dist const *dist, uint64_t event)
+{
+    if (dist == NULL || dist->counts == 0)
+    {
+        return 0;
+    }
+    return (double) inform_sparse_dist_get(dist, event) / dist->counts;
+}
+
+bool inform_sparse_dist_preferred(size_t support, size_t n)
+{
+    // a sparse slot costs about three dense counters and the table is kept
+    // at most 3/4 full, so only switch once the dense support is much larger
+    // than the number of events that could possibly be observed
+    return support >= SPARSE_MIN_SUPPORT && support / 8 > n;
+}
+
+size_t inform_sparse_dist_bytes(size_t n)
+{
+    // a table grown to hold n events is never larger than one allocated to
+    // hold them, and while growing it coexists with a table half its size
+    size_t const capacity = capacity_for(n);
+    size_t const slot = sizeof(uint64_t) + sizeof(uint32_t);
+    return sizeof(inform_sparse_dist) + (capacity + capacity / 2) * slot;
+}
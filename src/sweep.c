@@ -0,0 +1,115 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <string.h>
+#include "ensemble.h"
+#include "counters.h"
+#include "memory.h"
+
+struct ensemble
+{
+    int const *series;
+    size_t m;
+    int b;
+    size_t k;
+};
+
+static void accumulate_ensemble(void const *ctx, size_t begin, size_t end,
+    uint32_t *data)
+{
+    struct ensemble const *e = ctx;
+    uint64_t q = 1;
+    for (size_t j = 0; j < e->k; ++j)
+    {
+        q *= e->b;
+    }
+    for (size_t i = begin; i < end; ++i)
+    {
+        int const *series = e->series + i * e->m;
+        uint64_t history = 0;
+        for (size_t j = 0; j < e->k; ++j)
+        {
+            history = history * e->b + series[j];
+        }
+        for (size_t j = e->k; j < e->m; ++j)
+        {
+            uint64_t const s = history * e->b + series[j];
+            data[s]++;
+            history = s - series[j - e->k] * q;
+        }
+    }
+}
+
+bool inform_sweep_histories(int const *series, size_t n, size_t m, int b,
+    size_t K, inform_sweep_visitor visit, void *ctx)
+{
+    uint64_t support;
+    inform_block_support(b, K + 1, &support);
+    size_t const states_size = (size_t) support;
+    size_t const histories_size = states_size / b;
+
+    uint32_t *data = inform_aligned_calloc(states_size + histories_size + b,
+        sizeof(uint32_t));
+    if (data == NULL)
+    {
+        return true;
+    }
+    uint32_t *histories = data + states_size;
+    uint32_t *futures = histories + histories_size;
+
+    // count the observations of the longest history in a single pass
+    struct ensemble const e = { series, m, b, K };
+    inform_accumulate_ensemble(accumulate_ensemble, &e, n, n * (m - K), data,
+        states_size);
+
+    size_t size = states_size;
+    for (size_t k = K; k >= 1; --k)
+    {
+        memset(histories, 0, (size / b) * sizeof(uint32_t));
+        memset(futures, 0, b * sizeof(uint32_t));
+        uint32_t const *joint = data;
+        for (size_t h = 0; h < size / b; ++h)
+        {
+            for (int f = 0; f < b; ++f, ++joint)
+            {
+                histories[h] += *joint;
+                futures[f] += *joint;
+            }
+        }
+        uint64_t const N = n * (m - k);
+        inform_dist const s = inform_dist_view(data, size, N);
+        inform_dist const h = inform_dist_view(histories, size / b, N);
+        inform_dist const f = inform_dist_view(futures, b, N);
+        visit(ctx, k, &s, &h, &f);
+
+        if (k > 1)
+        {
+            // forget the oldest state of each block, folding the histogram
+            // onto its first b^k counters...
+            size /= b;
+            for (int a = 1; a < b; ++a)
+            {
+                uint32_t const *block = data + a * size;
+                for (size_t j = 0; j < size; ++j)
+                {
+                    data[j] += block[j];
+                }
+            }
+            // ...and add the one observation per series which begins
+            // before the longer history could
+            for (size_t i = 0; i < n; ++i)
+            {
+                uint64_t s = 0;
+                for (size_t j = 0; j < k; ++j)
+                {
+                    s = s * b + series[i * m + j];
+                }
+                data[s]++;
+            }
+        }
+    }
+
+    inform_aligned_free(data,
+        (states_size + histories_size + b) * sizeof(uint32_t));
+    return false;
+}
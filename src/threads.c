@@ -0,0 +1,83 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <inform/threads.h>
+#include "ensemble.h"
+#include "memory.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static int num_threads = 1;
+
+void inform_set_num_threads(int n)
+{
+#ifdef _OPENMP
+    num_threads = (n < 1) ? omp_get_num_procs() : n;
+#else
+    (void) n;
+#endif
+}
+
+int inform_get_num_threads(void)
+{
+    return num_threads;
+}
+
+static size_t threads_for(size_t n, size_t N, size_t size)
+{
+    size_t threads = (size_t) num_threads;
+    // there is no sense in having more threads than initial conditions
+    if (threads > n)
+    {
+        threads = n;
+    }
+    // each thread must observe at least as many events as it has private
+    // counters, otherwise zeroing and merging dominates the counting
+    while (threads > 1 && N / threads < size)
+    {
+        --threads;
+    }
+    return threads;
+}
+
+void inform_accumulate_ensemble(inform_ensemble_kernel kernel, void const *ctx,
+    size_t n, size_t N, uint32_t *data, size_t size)
+{
+    size_t const threads = threads_for(n, N, size);
+    // the private histograms of every thread but the first, which counts
+    // directly into the result
+    uint32_t *blocks = NULL;
+    if (threads > 1)
+    {
+        blocks = inform_aligned_calloc((threads - 1) * size, sizeof(uint32_t));
+    }
+    // fall back to a serial accumulation if we can't afford the histograms
+    if (blocks == NULL)
+    {
+        kernel(ctx, 0, n, data);
+        return;
+    }
+#ifdef _OPENMP
+    // the runtime may start fewer threads than we ask for (a nested region,
+    // OMP_THREAD_LIMIT, dynamic adjustment), so the ranges are handed out as
+    // loop iterations rather than keyed on the thread number
+    #pragma omp parallel for schedule(static) num_threads((int) threads)
+    for (long long i = 0; i < (long long) threads; ++i)
+    {
+        size_t const t = (size_t) i;
+        uint32_t *block = (t == 0) ? data : blocks + (t - 1) * size;
+        kernel(ctx, t * n / threads, (t + 1) * n / threads, block);
+    }
+    #pragma omp parallel for num_threads((int) threads)
+    for (long long i = 0; i < (long long) size; ++i)
+    {
+        for (size_t t = 1; t < threads; ++t)
+        {
+            data[i] += blocks[(t - 1) * size + i];
+        }
+    }
+#endif
+    inform_aligned_free(blocks, (threads - 1) * size * sizeof(uint32_t));
+}
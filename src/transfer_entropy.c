@@ -3,12 +3,15 @@
 // license that can be found in the LICENSE file.
 #include <inform/shannon.h>
 #include <inform/transfer_entropy.h>
+#include "ensemble.h"
+#include "counters.h"
+#include "memory.h"
+#include "scratch.h"
 
 static void accumulate_observations(int const *series_y, int const *series_x,
-     size_t n, int b, size_t k, inform_dist *states,
-     inform_dist *histories, inform_dist *sources, inform_dist *predicates)
+     size_t n, int b, size_t k, inform_dist *states, uint64_t *state)
 {
-    int history = 0, q = 1, y_state, future, state, source, predicate;
+    uint64_t history = 0, q = 1;
     for (size_t i = 0; i < k; ++i)
     {
         q *= b;
@@ -17,68 +20,237 @@ static void accumulate_observations(int const *series_y, int const *series_x,
     }
     for (size_t i = k; i < n; ++i)
     {
-        y_state   = series_y[i-1];
-        future    = series_x[i];
-        state     = (history * b + future) * b + y_state;
-        source    = history * b + y_state;
-        predicate = history * b + future;
+        uint64_t const predicate = history * b + series_x[i];
+        uint64_t const s = predicate * b + series_y[i-1];
+        states->histogram[s]++;
+        if (state != NULL)
+        {
+            state[i - k] = s;
+        }
+        history = predicate - series_x[i - k]*q;
+    }
+}
+
+static void accumulate_marginals(inform_dist const *states, int b,
+    inform_dist *histories, inform_dist *sources, inform_dist *predicates)
+{
+    uint32_t const *joint = states->histogram;
+    for (size_t history = 0; history < histories->size; ++history)
+    {
+        uint32_t *source = sources->histogram + history * b;
+        for (int future = 0; future < b; ++future)
+        {
+            uint32_t *predicate = predicates->histogram + history * b + future;
+            for (int y_state = 0; y_state < b; ++y_state, ++joint)
+            {
+                *predicate += *joint;
+                source[y_state] += *joint;
+            }
+            histories->histogram[history] += *predicate;
+        }
+    }
+}
 
-        states->histogram[state]++;
-        histories->histogram[history]++;
-        sources->histogram[source]++;
-        predicates->histogram[predicate]++;
+struct ensemble
+{
+    int const *node_y, *node_x;
+    size_t m;
+    int b;
+    size_t k;
+    size_t states_size;
+    uint64_t *state;
+};
 
-        history = predicate - series_x[i - k]*q;
+static void accumulate_ensemble(void const *ctx, size_t begin, size_t end,
+    uint32_t *data)
+{
+    struct ensemble const *e = ctx;
+    inform_dist states = inform_dist_view(data, e->states_size, 0);
+    for (size_t i = begin; i < end; ++i)
+    {
+        uint64_t *state = (e->state == NULL) ? NULL : e->state + i * (e->m - e->k);
+        accumulate_observations(e->node_y + i * e->m, e->node_x + i * e->m,
+            e->m, e->b, e->k, &states, state);
     }
 }
 
-static void accumulate_local_observations(int const *series_y,
-    int const *series_x, size_t n, int b, size_t k,
-    inform_dist *states, inform_dist *histories, inform_dist *sources,
-    inform_dist *predicates, int *state, int *history,
-    int *source, int *predicate)
+static bool accumulate_sparse_observations(int const *series_y,
+    int const *series_x, size_t n, int b, size_t k, inform_sparse_dist *states,
+    uint64_t *state, inform_error *err)
 {
-    history[0] = 0;
-    int q = 1;
+    uint64_t history = 0, q = 1;
     for (size_t i = 0; i < k; ++i)
     {
         q *= b;
-        history[0] *= b;
-        history[0] += series_x[i];
+        history *= b;
+        history += series_x[i];
     }
     for (size_t i = k; i < n; ++i)
     {
-        size_t l = i - k;
-        int y_state   = series_y[i-1];
-        int future    = series_x[i];
-        predicate[l]  = history[l] * b + future;
-        state[l]      = predicate[l] * b + y_state;
-        source[l]     = history[l] * b + y_state;
+        uint64_t const predicate = history * b + series_x[i];
+        uint64_t const s = predicate * b + series_y[i-1];
+        if (inform_sparse_dist_tick(states, s, err) == 0)
+        {
+            return true;
+        }
+        if (state != NULL)
+        {
+            state[i - k] = s;
+        }
+        history = predicate - series_x[i - k]*q;
+    }
+    return false;
+}
+
+static bool accumulate_sparse_marginals(inform_sparse_dist const *states,
+    int b, inform_sparse_dist *histories, inform_sparse_dist *sources,
+    inform_sparse_dist *predicates, inform_error *err)
+{
+    for (size_t i = 0; i < states->capacity; ++i)
+    {
+        if (states->events[i] != INFORM_SPARSE_EMPTY)
+        {
+            uint64_t const state = states->events[i];
+            uint64_t const history = state / (b*b);
+            uint32_t const count = states->histogram[i];
+            uint64_t const source = history * b + state % b;
+            if (inform_sparse_add(histories, history, count, err) ||
+                inform_sparse_add(sources, source, count, err) ||
+                inform_sparse_add(predicates, state / b, count, err))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
-        states->histogram[state[l]]++;
-        histories->histogram[history[l]]++;
-        sources->histogram[source[l]]++;
-        predicates->histogram[predicate[l]]++;
+static void free_sparse(inform_sparse_dist *states,
+    inform_sparse_dist *histories, inform_sparse_dist *sources,
+    inform_sparse_dist *predicates)
+{
+    inform_sparse_dist_free(predicates);
+    inform_sparse_dist_free(sources);
+    inform_sparse_dist_free(histories);
+    inform_sparse_dist_free(states);
+}
 
-        if (i + 1 != n)
+static bool sparse_accumulate(int const *node_y, int const *node_x, size_t n,
+    size_t m, int b, size_t k, inform_sparse_dist **states,
+    inform_sparse_dist **histories, inform_sparse_dist **sources,
+    inform_sparse_dist **predicates, uint64_t *state, inform_error *err)
+{
+    *states = inform_sparse_dist_alloc(0);
+    *histories = inform_sparse_dist_alloc(0);
+    *sources = inform_sparse_dist_alloc(0);
+    *predicates = inform_sparse_dist_alloc(0);
+    if (*states == NULL || *histories == NULL || *sources == NULL ||
+        *predicates == NULL)
+    {
+        free_sparse(*states, *histories, *sources, *predicates);
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, true);
+    }
+    for (size_t i = 0; i < n; ++i, node_x += m, node_y += m)
+    {
+        if (accumulate_sparse_observations(node_y, node_x, m, b, k, *states,
+            state, err))
+        {
+            free_sparse(*states, *histories, *sources, *predicates);
+            return true;
+        }
+        if (state != NULL)
         {
-            history[l + 1] = predicate[l] - series_x[l]*q;
+            state += (m - k);
         }
     }
+    if (accumulate_sparse_marginals(*states, b, *histories, *sources,
+        *predicates, err))
+    {
+        free_sparse(*states, *histories, *sources, *predicates);
+        return true;
+    }
+    return false;
 }
 
-static bool check_arguments(int const *node_y, int const *node_x,
+static double sparse_transfer_entropy(int const *node_y, int const *node_x,
     size_t n, size_t m, int b, size_t k, inform_error *err)
 {
-    if (node_y == NULL)
+    inform_sparse_dist *states = NULL, *histories = NULL, *sources = NULL,
+        *predicates = NULL;
+    if (sparse_accumulate(node_y, node_x, n, m, b, k, &states, &histories,
+        &sources, &predicates, NULL, err))
     {
-        INFORM_ERROR_RETURN(err, INFORM_ETIMESERIES, true);
+        return NAN;
     }
-    else if (node_x == NULL)
+
+    double te = inform_sparse_shannon(sources, (double) b) +
+        inform_sparse_shannon(predicates, (double) b) -
+        inform_sparse_shannon(states, (double) b) -
+        inform_sparse_shannon(histories, (double) b);
+
+    free_sparse(states, histories, sources, predicates);
+
+    return te;
+}
+
+static double *sparse_local_transfer_entropy(int const *node_y,
+    int const *node_x, size_t n, size_t m, int b, size_t k, double *te,
+    inform_error *err)
+{
+    size_t const N = n * (m - k);
+
+    uint64_t *state = inform_malloc(N * sizeof(uint64_t));
+    if (state == NULL)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ETIMESERIES, true);
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
+    inform_sparse_dist *states = NULL, *histories = NULL, *sources = NULL,
+        *predicates = NULL;
+    if (sparse_accumulate(node_y, node_x, n, m, b, k, &states, &histories,
+        &sources, &predicates, state, err))
+    {
+        inform_sized_free(state, N * sizeof(uint64_t));
+        return NULL;
+    }
+
+    double *local = inform_malloc(states->capacity * sizeof(double));
+    if (local == NULL)
+    {
+        free_sparse(states, histories, sources, predicates);
+        inform_sized_free(state, N * sizeof(uint64_t));
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
+    // compute the local transfer entropy once for each observed state
+    for (size_t j = 0; j < states->capacity; ++j)
+    {
+        uint64_t const s = states->events[j];
+        if (s != INFORM_SPARSE_EMPTY)
+        {
+            uint64_t const history = s / (b*b);
+            local[j] = inform_sparse_shannon_si(sources, history * b + s % b, (double) b) +
+                inform_sparse_shannon_si(predicates, s / b, (double) b) -
+                inform_sparse_shannon_si(states, s, (double) b) -
+                inform_sparse_shannon_si(histories, history, (double) b);
+        }
+    }
+    for (size_t i = 0; i < N; ++i)
+    {
+        te[i] = local[inform_sparse_dist_slot(states, state[i])];
     }
-    else if (n < 1)
+
+    inform_sized_free(local, states->capacity * sizeof(double));
+    free_sparse(states, histories, sources, predicates);
+    inform_sized_free(state, N * sizeof(uint64_t));
+
+    return te;
+}
+
+static bool check_shape(size_t n, size_t m, int b, size_t k,
+    inform_error *err)
+{
+    if (n < 1)
     {
         INFORM_ERROR_RETURN(err, INFORM_ENOINITS, true);
     }
@@ -98,6 +270,29 @@ static bool check_arguments(int const *node_y, int const *node_x,
     {
         INFORM_ERROR_RETURN(err, INFORM_EKZERO, true);
     }
+    uint64_t support;
+    if (inform_block_support(b, k + 2, &support))
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EKLONG, true);
+    }
+    return false;
+}
+
+static bool check_arguments(int const *node_y, int const *node_x,
+    size_t n, size_t m, int b, size_t k, inform_error *err)
+{
+    if (node_y == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ETIMESERIES, true);
+    }
+    else if (node_x == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ETIMESERIES, true);
+    }
+    if (check_shape(n, m, b, k, err))
+    {
+        return true;
+    }
     for (size_t i = 0; i < n * m; ++i)
     {
         if (b <= node_y[i] || b <= node_x[i])
@@ -112,127 +307,394 @@ static bool check_arguments(int const *node_y, int const *node_x,
     return false;
 }
 
+static inform_workspace_plan plan(size_t n, size_t m, int b, size_t k,
+    bool local)
+{
+    size_t const N = n * (m - k);
+    uint64_t support;
+    inform_block_support(b, k + 2, &support);
+    if (inform_use_sparse(support, N))
+    {
+        return inform_plan_sparse(4 * inform_sparse_dist_bytes(N),
+            local ? N : 0, local ? N : 0);
+    }
+    size_t const states_size = (size_t) support;
+    size_t const q = states_size / (b*b);
+    size_t const total_size = states_size + q + 2*b*q;
+    if (local)
+    {
+        return inform_plan_dense(total_size, N, states_size, N);
+    }
+    return inform_plan_dense(total_size, 0, 0, 0);
+}
+
+inform_workspace_plan inform_transfer_entropy_plan(size_t n, size_t m, int b,
+    size_t k, inform_error *err)
+{
+    inform_workspace_plan p = { 0, 0, 0, 0, false };
+    if (check_shape(n, m, b, k, err)) return p;
+    return plan(n, m, b, k, false);
+}
+
+inform_workspace_plan inform_local_transfer_entropy_plan(size_t n, size_t m,
+    int b, size_t k, inform_error *err)
+{
+    inform_workspace_plan p = { 0, 0, 0, 0, false };
+    if (check_shape(n, m, b, k, err)) return p;
+    return plan(n, m, b, k, true);
+}
+
 double inform_transfer_entropy(int const *node_y, int const *node_x, size_t n,
     size_t m, int b, size_t k, inform_error *err)
 {
+    inform_workspace ws = { NULL, 0, false, true };
+    double const te = inform_transfer_entropy_ws(node_y, node_x, n, m, b, k, &ws, err);
+    inform_aligned_free(ws.buffer, ws.size);
+    return te;
+}
+
+double inform_transfer_entropy_ws(int const *node_y, int const *node_x,
+    size_t n, size_t m, int b, size_t k, inform_workspace *ws,
+    inform_error *err)
+{
+    if (ws == NULL) return inform_transfer_entropy(node_y, node_x, n, m, b, k, err);
+
     if (check_arguments(node_y, node_x, n, m, b, k, err)) return NAN;
 
+    inform_workspace_plan const p = plan(n, m, b, k, false);
+    if (p.sparse)
+    {
+        return sparse_transfer_entropy(node_y, node_x, n, m, b, k, err);
+    }
+
     size_t const N = n * (m - k);
 
-    size_t const q = (size_t) pow((double) b, (double) k);
-    size_t const states_size     = b*b*q;
+    uint64_t support;
+    inform_block_support(b, k + 2, &support);
+    size_t const states_size     = (size_t) support;
+    size_t const q               = states_size / (b*b);
     size_t const histories_size  = q;
     size_t const sources_size    = b*q;
     size_t const predicates_size = b*q;
-    size_t const total_size = states_size + histories_size + sources_size + predicates_size;
 
-    uint32_t *data = calloc(total_size, sizeof(uint32_t));
+    uint32_t *data = inform_scratch(ws, p.workspace, p.histogram);
     if (data == NULL)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NAN);
+        if (!ws->owned)
+        {
+            INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NAN);
+        }
+        return sparse_transfer_entropy(node_y, node_x, n, m, b, k, err);
     }
 
-    inform_dist states     = { data, states_size, N };
-    inform_dist histories  = { data + states_size, histories_size, N };
-    inform_dist sources    = { data + states_size + histories_size, sources_size, N };
-    inform_dist predicates = { data + states_size + histories_size + sources_size, predicates_size, N };
+    inform_dist states     = inform_dist_view(data, states_size, N);
+    inform_dist histories  = inform_dist_view(data + states_size,
+        histories_size, N);
+    inform_dist sources    = inform_dist_view(data + states_size + histories_size,
+        sources_size, N);
+    inform_dist predicates = inform_dist_view(data + states_size + histories_size + sources_size,
+        predicates_size, N);
 
-    for (size_t i = 0; i < n; ++i, node_x += m, node_y += m)
-    {
-        accumulate_observations(node_y, node_x, m, b, k, &states, &histories, &sources, &predicates);
-    }
+    struct ensemble const e = { node_y, node_x, m, b, k, states_size, NULL };
+    inform_accumulate_ensemble(accumulate_ensemble, &e, n, N, data, states_size);
+    accumulate_marginals(&states, b, &histories, &sources, &predicates);
 
-    double te = inform_shannon(&sources, (double) b) +
+    return inform_shannon(&sources, (double) b) +
         inform_shannon(&predicates, (double) b) -
         inform_shannon(&states, (double) b) -
         inform_shannon(&histories, (double) b);
-
-    free(data);
-
-    return te;
 }
 
 double *inform_local_transfer_entropy(int const *node_y, int const *node_x,
     size_t n, size_t m, int b, size_t k, double *te, inform_error *err)
 {
+    inform_workspace ws = { NULL, 0, false, true };
+    te = inform_local_transfer_entropy_ws(node_y, node_x, n, m, b, k, te, &ws, err);
+    inform_aligned_free(ws.buffer, ws.size);
+    return te;
+}
+
+double *inform_local_transfer_entropy_ws(int const *node_y, int const *node_x,
+    size_t n, size_t m, int b, size_t k, double *te, inform_workspace *ws,
+    inform_error *err)
+{
+    if (ws == NULL) return inform_local_transfer_entropy(node_y, node_x, n, m, b, k, te, err);
+
     if (check_arguments(node_y, node_x, n, m, b, k, err)) return NULL;
 
     size_t const N = n * (m - k);
 
-    if (te == NULL)
+    // allocate the output only once the workspace is known to suffice, so
+    // that it isn't leaked if a borrowed workspace is too small
+    inform_workspace_plan const p = plan(n, m, b, k, true);
+    uint32_t *data = p.sparse ? NULL :
+        inform_scratch(ws, p.workspace, p.histogram);
+    if (data == NULL && !p.sparse && !ws->owned)
     {
-        te = malloc(N * sizeof(double));
-        if (te == NULL)
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
+    double *out = (te == NULL) ? inform_malloc(N * sizeof(double)) : te;
+    if (out == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+    }
+
+    // fall back on sparse histograms if the support is too large for dense
+    // ones, or if they can't be allocated
+    if (data == NULL)
+    {
+        if (sparse_local_transfer_entropy(node_y, node_x, n, m, b, k, out, err) == NULL)
         {
-            INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+            if (out != te) inform_sized_free(out, N * sizeof(double));
+            return NULL;
         }
+        return out;
     }
 
-    size_t const q = (size_t) pow((double) b, (double) k);
-    size_t const states_size     = b*b*q;
+    uint64_t support;
+    inform_block_support(b, k + 2, &support);
+    size_t const states_size     = (size_t) support;
+    size_t const q               = states_size / (b*b);
     size_t const histories_size  = q;
     size_t const sources_size    = b*q;
     size_t const predicates_size = b*q;
-    size_t const total_size = states_size + histories_size + sources_size + predicates_size;
 
-    uint32_t *data = calloc(total_size, sizeof(uint32_t));
-    if (data == NULL)
+    uint64_t *state = inform_scratch_states(data, &p);
+    double *local = inform_scratch_table(data, &p, N);
+
+    inform_dist states     = inform_dist_view(data, states_size, N);
+    inform_dist histories  = inform_dist_view(data + states_size,
+        histories_size, N);
+    inform_dist sources    = inform_dist_view(data + states_size + histories_size,
+        sources_size, N);
+    inform_dist predicates = inform_dist_view(data + states_size + histories_size + sources_size,
+        predicates_size, N);
+
+    struct ensemble const e = { node_y, node_x, m, b, k, states_size, state };
+    inform_accumulate_ensemble(accumulate_ensemble, &e, n, N, data, states_size);
+    accumulate_marginals(&states, b, &histories, &sources, &predicates);
+
+    // compute the local transfer entropy once for each observed state
+    for (size_t s = 0; s < states_size; ++s)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+        if (states.histogram[s] != 0)
+        {
+            size_t const history = s / (b*b);
+            local[s] = inform_shannon_pcmi(&states, &sources, &predicates,
+                &histories, s, history * b + s % b, s / b, history, (double) b);
+        }
+    }
+    for (size_t i = 0; i < N; ++i)
+    {
+        out[i] = local[state[i]];
     }
 
-    inform_dist states     = { data, states_size, N };
-    inform_dist histories  = { data + states_size, histories_size, N };
-    inform_dist sources    = { data + states_size + histories_size, sources_size, N };
-    inform_dist predicates = { data + states_size + histories_size + sources_size, predicates_size, N };
+    return out;
+}
 
-    int *state      = malloc(N * sizeof(int));
-    if (state == NULL)
+inform_transfer_entropy_acc *inform_transfer_entropy_acc_alloc(int b, size_t k,
+    inform_error *err)
+{
+    if (b < 2)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+        INFORM_ERROR_RETURN(err, INFORM_EBASE, NULL);
     }
-    int *history    = malloc(N * sizeof(int));
-    if (history == NULL)
+    else if (k == 0)
     {
-        INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+        INFORM_ERROR_RETURN(err, INFORM_EKZERO, NULL);
     }
-    int *source     = malloc(N * sizeof(int));
-    if (source == NULL)
+    inform_transfer_entropy_acc *acc =
+        inform_calloc(1, sizeof(inform_transfer_entropy_acc));
+    if (acc == NULL)
     {
         INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
     }
-    int *predicate  = malloc(N * sizeof(int));
-    if (predicate == NULL)
+    acc->b = b;
+    acc->k = k;
+    acc->states = inform_tracked_blocks_alloc(b, k + 2, err);
+    acc->histories = inform_tracked_blocks_alloc(b, k, err);
+    acc->sources = inform_tracked_blocks_alloc(b, k + 1, err);
+    acc->predicates = inform_tracked_blocks_alloc(b, k + 1, err);
+    if (acc->states == NULL || acc->histories == NULL ||
+        acc->sources == NULL || acc->predicates == NULL)
+    {
+        inform_transfer_entropy_acc_free(acc);
+        return NULL;
+    }
+    return acc;
+}
+
+void inform_transfer_entropy_acc_free(inform_transfer_entropy_acc *acc)
+{
+    if (acc != NULL)
+    {
+        inform_dist_free(acc->predicates);
+        inform_dist_free(acc->sources);
+        inform_dist_free(acc->histories);
+        inform_dist_free(acc->states);
+        inform_sized_free(acc, sizeof(inform_transfer_entropy_acc));
+    }
+}
+
+void inform_transfer_entropy_acc_push(inform_transfer_entropy_acc *acc,
+    int const *series_y, int const *series_x, size_t m, inform_error *err)
+{
+    if (acc == NULL)
+    {
+        INFORM_ERROR_RETURN_VOID(err, INFORM_EFAULT);
+    }
+    if (inform_check_pushed(series_y, m, acc->b, err) ||
+        inform_check_pushed(series_x, m, acc->b, err))
+    {
+        return;
+    }
+    // the history wraps around modulo the number of histories, b^k
+    size_t const q = acc->histories->size;
+    for (size_t i = 0; i < m; ++i)
+    {
+        uint64_t const predicate = acc->history * acc->b + series_x[i];
+        // the source's state at the previous time step is paired with the
+        // target's history and future
+        if (acc->seen == acc->k)
+        {
+            uint64_t const source = acc->history * acc->b + acc->source;
+            inform_dist_tick(acc->states, predicate * acc->b + acc->source);
+            inform_dist_tick(acc->histories, acc->history);
+            inform_dist_tick(acc->sources, source);
+            inform_dist_tick(acc->predicates, predicate);
+        }
+        else
+        {
+            acc->seen += 1;
+        }
+        acc->history = predicate % q;
+        acc->source = series_y[i];
+    }
+}
+
+void inform_transfer_entropy_acc_restart(inform_transfer_entropy_acc *acc)
+{
+    if (acc != NULL)
+    {
+        acc->history = 0;
+        acc->source = 0;
+        acc->seen = 0;
+    }
+}
+
+void inform_transfer_entropy_acc_clear(inform_transfer_entropy_acc *acc)
+{
+    if (acc != NULL)
     {
+        inform_dist_clear(acc->states);
+        inform_dist_clear(acc->histories);
+        inform_dist_clear(acc->sources);
+        inform_dist_clear(acc->predicates);
+        inform_transfer_entropy_acc_restart(acc);
+    }
+}
+
+double inform_transfer_entropy_acc_value(inform_transfer_entropy_acc const *acc,
+    inform_error *err)
+{
+    if (acc == NULL)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EFAULT, NAN);
+    }
+    else if (!inform_dist_is_valid(acc->states))
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EDIST, NAN);
+    }
+    double const b = (double) acc->b;
+    return inform_shannon(acc->sources, b) +
+        inform_shannon(acc->predicates, b) -
+        inform_shannon(acc->states, b) -
+        inform_shannon(acc->histories, b);
+}
+
+static void free_windows(inform_window_dist *states,
+    inform_window_dist *histories, inform_window_dist *sources,
+    inform_window_dist *predicates)
+{
+    inform_window_dist_free(predicates);
+    inform_window_dist_free(sources);
+    inform_window_dist_free(histories);
+    inform_window_dist_free(states);
+}
+
+double *inform_windowed_transfer_entropy(int const *node_y, int const *node_x,
+    size_t n, size_t m, int b, size_t k, size_t w, double *te,
+    inform_error *err)
+{
+    if (check_arguments(node_y, node_x, n, m, b, k, err)) return NULL;
+
+    if (w <= k)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EKLONG, NULL);
+    }
+    else if (w > m)
+    {
+        INFORM_ERROR_RETURN(err, INFORM_EARG, NULL);
+    }
+
+    // each position of the window holds w - k observations per series
+    size_t const window = n * (w - k);
+    inform_window_dist *states = inform_window_blocks_alloc(b, k + 2, window, err);
+    inform_window_dist *histories = inform_window_blocks_alloc(b, k, window, err);
+    inform_window_dist *sources = inform_window_blocks_alloc(b, k + 1, window, err);
+    inform_window_dist *predicates = inform_window_blocks_alloc(b, k + 1, window, err);
+    uint64_t *history = inform_calloc(n, sizeof(uint64_t));
+    double *out = (te == NULL) ? inform_malloc((m - w + 1) * sizeof(double)) : te;
+    if (states == NULL || histories == NULL || sources == NULL ||
+        predicates == NULL || history == NULL || out == NULL)
+    {
+        if (out != te) inform_sized_free(out, (m - w + 1) * sizeof(double));
+        inform_sized_free(history, n * sizeof(uint64_t));
+        free_windows(states, histories, sources, predicates);
         INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
     }
 
-    int const *node_y_ptr = node_y, *node_x_ptr = node_x;
-    int *state_ptr = state, *source_ptr = source, *history_ptr = history, *predicate_ptr = predicate;
+    size_t const q = inform_window_dist_dist(histories)->size;
     for (size_t i = 0; i < n; ++i)
     {
-        accumulate_local_observations(node_y_ptr, node_x_ptr, m, b, k, &states,
-            &histories, &sources, &predicates, state_ptr, history_ptr,
-            source_ptr, predicate_ptr);
-        node_y_ptr += m;
-        node_x_ptr += m;
-        state_ptr += (m - k);
-        history_ptr += (m - k);
-        source_ptr += (m - k);
-        predicate_ptr += (m - k);
+        for (size_t t = 0; t < k; ++t)
+        {
+            history[i] = history[i] * b + node_x[i * m + t];
+        }
     }
-
-    for (size_t i = 0; i < N; ++i)
+    // slide the window one time step at a time, the observations of each
+    // step displacing those of the step which leaves the window
+    for (size_t t = k; t < m; ++t)
     {
-        te[i] = inform_shannon_pcmi(&states, &sources, &predicates, &histories,
-            state[i], source[i], predicate[i], history[i], (double) b);
+        for (size_t i = 0; i < n; ++i)
+        {
+            int const source = node_y[i * m + t - 1];
+            uint64_t const predicate = history[i] * b + node_x[i * m + t];
+            if (inform_window_dist_tick(states, predicate * b + source) == 0 ||
+                inform_window_dist_tick(histories, history[i]) == 0 ||
+                inform_window_dist_tick(sources, history[i] * b + source) == 0 ||
+                inform_window_dist_tick(predicates, predicate) == 0)
+            {
+                if (out != te) inform_sized_free(out, (m - w + 1) * sizeof(double));
+                inform_sized_free(history, n * sizeof(uint64_t));
+                free_windows(states, histories, sources, predicates);
+                INFORM_ERROR_RETURN(err, INFORM_ENOMEM, NULL);
+            }
+            history[i] = predicate % q;
+        }
+        if (t + 1 >= w)
+        {
+            out[t + 1 - w] =
+                inform_shannon(inform_window_dist_dist(sources), (double) b) +
+                inform_shannon(inform_window_dist_dist(predicates), (double) b) -
+                inform_shannon(inform_window_dist_dist(states), (double) b) -
+                inform_shannon(inform_window_dist_dist(histories), (double) b);
+        }
     }
 
-    free(predicate);
-    free(source);
-    free(history);
-    free(state);
-    free(data);
+    inform_sized_free(history, n * sizeof(uint64_t));
+    free_windows(states, histories, sources, predicates);
 
-    return te;
+    return out;
 }
@@ -3,6 +3,7 @@
 // license that can be found in the LICENSE file.
 #include <inform/utilities/coalesce.h>
 #include <string.h>
+#include "../memory.h"
 
 static int compare_ints(void const *a, void const *b)
 {
@@ -22,7 +23,7 @@ int inform_coalesce(int const *series, size_t n, int *coal, inform_error *err)
     else if (coal == NULL)
         INFORM_ERROR_RETURN(err, INFORM_ETIMESERIES, 0);
 
-    int *tmp = malloc(n * sizeof(int));
+    int *tmp = inform_malloc(n * sizeof(int));
     if (tmp == NULL)
     {
         INFORM_ERROR_RETURN(err, INFORM_ENOMEM, 0);
@@ -35,10 +36,10 @@ int inform_coalesce(int const *series, size_t n, int *coal, inform_error *err)
         if (tmp[i] != tmp[i-1]) ++b;
     }
 
-    int *map = malloc(b * sizeof(int));
+    int *map = inform_malloc(b * sizeof(int));
     if (map == NULL)
     {
-        free(tmp);
+        inform_sized_free(tmp, n * sizeof(int));
         INFORM_ERROR_RETURN(err, INFORM_ENOMEM, 0);
     }
     map[0] = tmp[0];
@@ -46,19 +47,19 @@ int inform_coalesce(int const *series, size_t n, int *coal, inform_error *err)
     {
         if (tmp[i] != tmp[i-1]) map[j++] = tmp[i];
     }
-    free(tmp);
+    inform_sized_free(tmp, n * sizeof(int));
 
     for (size_t i = 0; i < n; ++i)
     {
         int *x = bsearch(series + i, map, b, sizeof(int), compare_ints);
         if (x == NULL)
         {
-            free(map);
+            inform_sized_free(map, b * sizeof(int));
             INFORM_ERROR_RETURN(err, INFORM_EBIN, 0);
         }
         coal[i] = (int) (x - map);
     }
 
-    free(map);
+    inform_sized_free(map, b * sizeof(int));
     return b;
 }
\ No newline at end of file
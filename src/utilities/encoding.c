@@ -39,3 +39,47 @@ void inform_decode(int32_t encoding, int b, int *state, size_t n, inform_error *
     if (encoding != 0)
         INFORM_ERROR_RETURN_VOID(err, INFORM_EENCODE);
 }
+
+int64_t inform_encode64(int const *state, size_t n, int b, inform_error *err)
+{
+    if (state == NULL || n == 0)
+        INFORM_ERROR_RETURN(err, INFORM_EARG, -1);
+    else if (b < 2)
+        INFORM_ERROR_RETURN(err, INFORM_EBASE, -1);
+
+    // ensure that every base-b state of length n fits in 63 bits
+    int64_t max = 1;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (max > INT64_MAX / b)
+            INFORM_ERROR_RETURN(err, INFORM_EENCODE, -1);
+        max *= b;
+    }
+
+    int64_t encoding = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (state[i] < 0 || b <= state[i])
+            INFORM_ERROR_RETURN(err, INFORM_EENCODE, -1);
+        encoding *= b;
+        encoding += state[i];
+    }
+    return encoding;
+}
+
+void inform_decode64(int64_t encoding, int b, int *state, size_t n,
+    inform_error *err)
+{
+    if (encoding < 0)
+        INFORM_ERROR_RETURN_VOID(err, INFORM_EARG);
+    else if (b < 2)
+        INFORM_ERROR_RETURN_VOID(err, INFORM_EBASE);
+    else if (state == NULL || n == 0)
+        INFORM_ERROR_RETURN_VOID(err, INFORM_EARG);
+
+    for (size_t i = 0; i < n; ++i, encoding /= b)
+        state[n - i - 1] = (int)(encoding % b);
+
+    if (encoding != 0)
+        INFORM_ERROR_RETURN_VOID(err, INFORM_EENCODE);
+}
@@ -4,6 +4,7 @@
 #include <inform/utilities/random.h>
 #include <stdlib.h>
 #include <time.h>
+#include "../memory.h"
 
 void inform_random_seed()
 {
@@ -17,7 +18,7 @@ int inform_random_int(int a, int b)
 
 int *inform_random_ints(int a, int b, size_t n)
 {
-    int *xs = malloc(n * sizeof(int));
+    int *xs = inform_malloc(n * sizeof(int));
     if (xs == NULL)
         return NULL;
     for (size_t i = 0; i < n; ++i)
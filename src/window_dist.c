@@ -0,0 +1,98 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <inform/window_dist.h>
+#include "memory.h"
+
+inform_window_dist *inform_window_dist_alloc(size_t n, size_t window)
+{
+    if (n == 0 || window == 0)
+    {
+        return NULL;
+    }
+    inform_window_dist *dist = inform_malloc(sizeof(inform_window_dist));
+    if (dist == NULL)
+    {
+        return NULL;
+    }
+    // no count can exceed the size of the window, so start with the
+    // narrowest counters which can hold it
+    inform_counter_width const width = (window <= UINT8_MAX) ?
+        INFORM_COUNTER_8 : INFORM_COUNTER_16;
+    dist->dist = inform_dist_alloc_width(n, width);
+    dist->events = inform_malloc(window * sizeof(size_t));
+    if (dist->dist == NULL || dist->events == NULL ||
+        inform_dist_track_entropy(dist->dist, true) == NULL)
+    {
+        inform_sized_free(dist->events, window * sizeof(size_t));
+        inform_dist_free(dist->dist);
+        inform_sized_free(dist, sizeof(inform_window_dist));
+        return NULL;
+    }
+    dist->window = window;
+    dist->head = 0;
+    return dist;
+}
+
+void inform_window_dist_free(inform_window_dist *dist)
+{
+    if (dist != NULL)
+    {
+        inform_sized_free(dist->events, dist->window * sizeof(size_t));
+        inform_dist_free(dist->dist);
+        inform_sized_free(dist, sizeof(inform_window_dist));
+    }
+}
+
+inform_dist const *inform_window_dist_dist(inform_window_dist const *dist)
+{
+    return (dist == NULL) ? NULL : dist->dist;
+}
+
+size_t inform_window_dist_counts(inform_window_dist const *dist)
+{
+    return (dist == NULL) ? 0 : (size_t) dist->dist->counts;
+}
+
+uint32_t inform_window_dist_tick(inform_window_dist *dist, size_t event)
+{
+    if (dist == NULL || event >= dist->dist->size)
+    {
+        return 0;
+    }
+    size_t const n = (size_t) dist->dist->counts;
+    // until the window is full, events are appended after the oldest
+    if (n < dist->window)
+    {
+        uint32_t const x = inform_dist_tick(dist->dist, event);
+        if (x != 0)
+        {
+            size_t tail = dist->head + n;
+            tail = (tail < dist->window) ? tail : tail - dist->window;
+            dist->events[tail] = event;
+        }
+        return x;
+    }
+    // otherwise the new event replaces the oldest
+    size_t const oldest = dist->events[dist->head];
+    inform_dist_untick(dist->dist, oldest);
+    uint32_t const x = inform_dist_tick(dist->dist, event);
+    if (x == 0)
+    {
+        // put the oldest event back, which needs no more room than it had
+        inform_dist_tick(dist->dist, oldest);
+        return 0;
+    }
+    dist->events[dist->head] = event;
+    dist->head = (dist->head + 1 == dist->window) ? 0 : dist->head + 1;
+    return x;
+}
+
+void inform_window_dist_clear(inform_window_dist *dist)
+{
+    if (dist != NULL)
+    {
+        inform_dist_clear(dist->dist);
+        dist->head = 0;
+    }
+}
@@ -0,0 +1,74 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <inform/workspace.h>
+#include "memory.h"
+
+inform_workspace *inform_workspace_alloc(size_t size)
+{
+    inform_workspace *ws = inform_malloc(sizeof(inform_workspace));
+    if (ws != NULL)
+    {
+        ws->buffer = NULL;
+        ws->size = 0;
+        ws->dirty = false;
+        ws->owned = true;
+        if (size != 0 && inform_workspace_reserve(ws, size) == NULL)
+        {
+            inform_sized_free(ws, sizeof(inform_workspace));
+            return NULL;
+        }
+    }
+    return ws;
+}
+
+void inform_workspace_free(inform_workspace *ws)
+{
+    if (ws != NULL)
+    {
+        if (ws->owned)
+        {
+            inform_aligned_free(ws->buffer, ws->size);
+        }
+        inform_sized_free(ws, sizeof(inform_workspace));
+    }
+}
+
+inform_workspace inform_workspace_wrap(void *buffer, size_t size)
+{
+    // nothing is known about the contents of the buffer
+    inform_workspace ws = { buffer, (buffer == NULL) ? 0 : size, true, false };
+    return ws;
+}
+
+size_t inform_workspace_size(inform_workspace const *ws)
+{
+    return (ws == NULL) ? 0 : ws->size;
+}
+
+void *inform_workspace_reserve(inform_workspace *ws, size_t size)
+{
+    if (ws == NULL)
+    {
+        return NULL;
+    }
+    if (size > ws->size || ws->buffer == NULL)
+    {
+        if (!ws->owned)
+        {
+            return NULL;
+        }
+        // a fresh, zeroed buffer may come from pages that the allocator
+        // knows to be clear, which is cheaper than clearing it ourselves
+        void *buffer = inform_aligned_calloc(size, 1);
+        if (buffer == NULL)
+        {
+            return NULL;
+        }
+        inform_aligned_free(ws->buffer, ws->size);
+        ws->buffer = buffer;
+        ws->size = size;
+        ws->dirty = false;
+    }
+    return ws->buffer;
+}
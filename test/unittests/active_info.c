@@ -385,6 +385,280 @@ UNIT(LocalActiveInfoEnsemble_Base4)
     }
 }
 
+UNIT(ActiveInfoSparseSupport)
+{
+    int const series[] = {
+        0,0,1,1,1,0,1,0,0,1,1,0,1,1,1,1,0,0,0,1,
+        1,0,1,1,0,0,0,1,0,1,1,1,0,0,1,0,1,0,0,1,
+    };
+    // declaring a base of 64 makes the support far too large for the few
+    // observations, so the sparse path is taken; the bits must not change
+    double const dense = inform_active_info(series, 2, 20, 2, 3, NULL);
+    double const sparse = inform_active_info(series, 2, 20, 64, 3, NULL);
+    ASSERT_DBL_NEAR_TOL(dense, 6 * sparse, 1e-12);
+}
+
+UNIT(LocalActiveInfoSparseSupport)
+{
+    int const series[] = {
+        0,0,1,1,1,0,1,0,0,1,1,0,1,1,1,1,0,0,0,1,
+        1,0,1,1,0,0,0,1,0,1,1,1,0,0,1,0,1,0,0,1,
+    };
+    double dense[34], sparse[34];
+    // declaring a base of 64 makes the support far too large for the few
+    // observations, so the sparse path is taken; the bits must not change
+    ASSERT_NOT_NULL(inform_local_active_info(series, 2, 20, 2, 3, dense, NULL));
+    ASSERT_NOT_NULL(inform_local_active_info(series, 2, 20, 64, 3, sparse, NULL));
+    for (size_t i = 0; i < 34; ++i)
+    {
+        ASSERT_DBL_NEAR_TOL(dense[i], 6 * sparse[i], 1e-12);
+    }
+}
+
+UNIT(ActiveInfoLongHistory)
+{
+    int series[100];
+    unsigned seed = 2016;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        series[i] = (seed >> 16) & 1;
+    }
+
+    // with k = 40 the joint states need 41 bits, and every history is
+    // distinct, so the future is fully determined by the history
+    double ones = 0;
+    for (size_t i = 40; i < 100; ++i)
+    {
+        ones += series[i];
+    }
+    double const p = ones / 60;
+    double const h = -p*log2(p) - (1-p)*log2(1-p);
+
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_DBL_NEAR_TOL(h, inform_active_info(series, 1, 100, 2, 40, &err), 1e-12);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+}
+
+UNIT(ActiveInfoHistoryOverflows)
+{
+    int series[70] = {0};
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_TRUE(isnan(inform_active_info(series, 1, 70, 2, 64, &err)));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_local_active_info(series, 1, 70, 2, 64, NULL, &err));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+}
+
+static void fill_series(int *series, size_t n, int b, unsigned seed)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        series[i] = (int)((seed >> 16) % (unsigned) b);
+    }
+}
+
+UNIT(ActiveInfoAccumulatorErrors)
+{
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_active_info_acc_alloc(1, 2, &err));
+    ASSERT_EQUAL(INFORM_EBASE, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_active_info_acc_alloc(2, 0, &err));
+    ASSERT_EQUAL(INFORM_EKZERO, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_active_info_acc_alloc(2, 64, &err));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+
+    err = INFORM_SUCCESS;
+    ASSERT_TRUE(isnan(inform_active_info_acc_value(NULL, &err)));
+    ASSERT_EQUAL(INFORM_EFAULT, err);
+    err = INFORM_SUCCESS;
+    inform_active_info_acc_push(NULL, NULL, 0, &err);
+    ASSERT_EQUAL(INFORM_EFAULT, err);
+    inform_active_info_acc_restart(NULL);
+    inform_active_info_acc_clear(NULL);
+    inform_active_info_acc_free(NULL);
+
+    err = INFORM_SUCCESS;
+    inform_active_info_acc *acc = inform_active_info_acc_alloc(2, 2, &err);
+    ASSERT_NOT_NULL(acc);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(isnan(inform_active_info_acc_value(acc, &err)));
+    ASSERT_EQUAL(INFORM_EDIST, err);
+
+    // a time series no longer than the history observes nothing
+    int const series[] = {0,1,1,0,2,1};
+    err = INFORM_SUCCESS;
+    inform_active_info_acc_push(acc, series, 2, &err);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(isnan(inform_active_info_acc_value(acc, &err)));
+
+    // invalid states are rejected as a whole
+    err = INFORM_SUCCESS;
+    inform_active_info_acc_push(acc, NULL, 1, &err);
+    ASSERT_EQUAL(INFORM_ETIMESERIES, err);
+    err = INFORM_SUCCESS;
+    inform_active_info_acc_push(acc, series + 2, 4, &err);
+    ASSERT_EQUAL(INFORM_EBADSTATE, err);
+    err = INFORM_SUCCESS;
+    int const negative[] = {1,-1};
+    inform_active_info_acc_push(acc, negative, 2, &err);
+    ASSERT_EQUAL(INFORM_ENEGSTATE, err);
+    ASSERT_EQUAL(0, inform_dist_counts(acc->states));
+
+    inform_active_info_acc_free(acc);
+}
+
+UNIT(ActiveInfoAccumulator)
+{
+    size_t const n = 6, m = 50;
+    int series[6 * 50];
+    int const bases[] = {2, 3, 4};
+    size_t const chunks[] = {1, 0, 7, 2, 13, 50};
+    for (size_t t = 0; t < 3; ++t)
+    {
+        int const b = bases[t];
+        size_t const k = 3 - t;
+        fill_series(series, n * m, b, 17 + (unsigned) t);
+
+        inform_error err = INFORM_SUCCESS;
+        inform_active_info_acc *acc = inform_active_info_acc_alloc(b, k, &err);
+        ASSERT_NOT_NULL(acc);
+        for (size_t i = 0; i < n; ++i)
+        {
+            // push each time series in uneven pieces
+            size_t pushed = 0;
+            for (size_t c = 0; pushed < m; ++c)
+            {
+                size_t const size = (chunks[c] < m - pushed) ? chunks[c] : m - pushed;
+                inform_active_info_acc_push(acc, series + i * m + pushed, size, &err);
+                pushed += size;
+            }
+            ASSERT_EQUAL(INFORM_SUCCESS, err);
+            ASSERT_DBL_NEAR_TOL(inform_active_info(series, i + 1, m, b, k, &err),
+                inform_active_info_acc_value(acc, &err), 1e-10);
+            inform_active_info_acc_restart(acc);
+        }
+
+        // a cleared accumulator starts over
+        inform_active_info_acc_clear(acc);
+        inform_active_info_acc_push(acc, series + m, m, &err);
+        ASSERT_DBL_NEAR_TOL(inform_active_info(series + m, 1, m, b, k, &err),
+            inform_active_info_acc_value(acc, &err), 1e-10);
+        ASSERT_EQUAL(INFORM_SUCCESS, err);
+        inform_active_info_acc_free(acc);
+    }
+}
+
+UNIT(WindowedActiveInfoErrors)
+{
+    int const series[] = {0,1,1,0,1,0,0,1};
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_windowed_active_info(NULL, 1, 8, 2, 2, 4, NULL, &err));
+    ASSERT_EQUAL(INFORM_ETIMESERIES, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_windowed_active_info(series, 1, 8, 2, 2, 2, NULL, &err));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_windowed_active_info(series, 1, 8, 2, 2, 9, NULL, &err));
+    ASSERT_EQUAL(INFORM_EARG, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_windowed_active_info(series, 1, 8, 1, 2, 4, NULL, &err));
+    ASSERT_EQUAL(INFORM_EBASE, err);
+}
+
+UNIT(WindowedActiveInfo)
+{
+    size_t const n = 3, m = 80;
+    int series[3 * 80], window[3 * 80];
+    size_t const ws[] = {3, 12, 80};
+    for (size_t t = 0; t < 3; ++t)
+    {
+        int const b = 2 + (int) t;
+        size_t const k = 2, w = ws[t];
+        fill_series(series, n * m, b, 5 + (unsigned) t);
+        // let the dynamics change half way through
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = m / 2; j < m; j += 2)
+            {
+                series[i * m + j] = series[i * m + j - 1];
+            }
+        }
+
+        inform_error err = INFORM_SUCCESS;
+        double *ai = inform_windowed_active_info(series, n, m, b, k, w, NULL, &err);
+        ASSERT_NOT_NULL(ai);
+        ASSERT_EQUAL(INFORM_SUCCESS, err);
+        for (size_t j = 0; j + w <= m; ++j)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                for (size_t l = 0; l < w; ++l)
+                {
+                    window[i * w + l] = series[i * m + j + l];
+                }
+            }
+            ASSERT_DBL_NEAR_TOL(inform_active_info(window, n, w, b, k, &err),
+                ai[j], 1e-10);
+        }
+
+        // the output may be provided
+        double out[80];
+        ASSERT_TRUE(out == inform_windowed_active_info(series, n, m, b, k, w, out, &err));
+        ASSERT_DBL_NEAR(ai[m - w], out[m - w]);
+        free(ai);
+    }
+}
+
+UNIT(ActiveInfoSweep)
+{
+    size_t const n = 4, m = 100;
+    int series[4 * 100];
+    int const bases[] = {2, 3, 2};
+    // the last history is long enough that its histograms are sparse
+    size_t const Ks[] = {7, 4, 20};
+    for (size_t t = 0; t < 3; ++t)
+    {
+        int const b = bases[t];
+        size_t const K = Ks[t];
+        fill_series(series, n * m, b, 3 + (unsigned) t);
+        for (size_t i = 3; i < n * m; i += 3)
+        {
+            series[i] = series[i - 3];
+        }
+
+        inform_error err = INFORM_SUCCESS;
+        double *ai = inform_active_info_sweep(series, n, m, b, K, NULL, &err);
+        ASSERT_NOT_NULL(ai);
+        ASSERT_EQUAL(INFORM_SUCCESS, err);
+        for (size_t k = 1; k <= K; ++k)
+        {
+            ASSERT_DBL_NEAR_TOL(inform_active_info(series, n, m, b, k, &err), ai[k - 1],
+                1e-10);
+        }
+        free(ai);
+    }
+
+    inform_error err = INFORM_SUCCESS;
+    double out[4];
+    ASSERT_TRUE(out == inform_active_info_sweep(series, n, m, 2, 4, out, &err));
+    ASSERT_DBL_NEAR(inform_active_info(series, n, m, 2, 4, &err), out[3]);
+
+    ASSERT_NULL(inform_active_info_sweep(series, n, m, 2, 0, NULL, &err));
+    ASSERT_EQUAL(INFORM_EKZERO, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_active_info_sweep(series, n, m, 2, m, NULL, &err));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_active_info_sweep(NULL, n, m, 2, 3, NULL, &err));
+    ASSERT_EQUAL(INFORM_ETIMESERIES, err);
+}
+
 BEGIN_SUITE(ActiveInformation)
     ADD_UNIT(ActiveInfoSeriesNULLSeries)
     ADD_UNIT(ActiveInfoSeriesNoInits)
@@ -398,6 +672,9 @@ BEGIN_SUITE(ActiveInformation)
     ADD_UNIT(ActiveInfoSingleSeries_Base4)
     ADD_UNIT(ActiveInfoEnsemble)
     ADD_UNIT(ActiveInfoEnsemble_Base4)
+    ADD_UNIT(ActiveInfoSparseSupport)
+    ADD_UNIT(ActiveInfoLongHistory)
+    ADD_UNIT(ActiveInfoHistoryOverflows)
     ADD_UNIT(LocalActiveInfoSeriesNULLSeries)
     ADD_UNIT(LocalActiveInfoSeriesNoInits)
     ADD_UNIT(LocalActiveInfoSeriesTooShort)
@@ -411,4 +688,10 @@ BEGIN_SUITE(ActiveInformation)
     ADD_UNIT(LocalActiveInfoSingleSeries_Base4)
     ADD_UNIT(LocalActiveInfoEnsemble)
     ADD_UNIT(LocalActiveInfoEnsemble_Base4)
+    ADD_UNIT(LocalActiveInfoSparseSupport)
+    ADD_UNIT(ActiveInfoAccumulatorErrors)
+    ADD_UNIT(ActiveInfoAccumulator)
+    ADD_UNIT(WindowedActiveInfoErrors)
+    ADD_UNIT(WindowedActiveInfo)
+    ADD_UNIT(ActiveInfoSweep)
 END_SUITE
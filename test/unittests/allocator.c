@@ -0,0 +1,280 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <unit.h>
+#include <inform/active_info.h>
+#include <inform/allocator.h>
+#include <inform/dist.h>
+#include <inform/sparse_dist.h>
+#include <inform/transfer_entropy.h>
+#include <inform/utilities/coalesce.h>
+#include <inform/workspace.h>
+#include <stdint.h>
+
+/// the most blocks a counting allocator keeps track of at once
+#define LIVE_BLOCKS 1024
+
+typedef struct counter
+{
+    inform_allocator base;
+    size_t allocs;
+    size_t frees;
+    size_t misaligned;
+    /// frees whose size didn't match that of the allocation
+    size_t missized;
+    /// frees whose size wasn't known
+    size_t unsized;
+    /// the blocks which are live, and their sizes
+    struct { void *ptr; size_t size; } live[LIVE_BLOCKS];
+} counter;
+
+static void track(counter *c, void *ptr, size_t size)
+{
+    for (size_t i = 0; ptr != NULL && i < LIVE_BLOCKS; ++i)
+    {
+        if (c->live[i].ptr == NULL)
+        {
+            c->live[i].ptr = ptr;
+            c->live[i].size = size;
+            return;
+        }
+    }
+}
+
+static void untrack(counter *c, void *ptr, size_t size)
+{
+    for (size_t i = 0; i < LIVE_BLOCKS; ++i)
+    {
+        if (c->live[i].ptr == ptr)
+        {
+            if (size == 0)
+            {
+                c->unsized += 1;
+            }
+            else if (size != c->live[i].size)
+            {
+                c->missized += 1;
+            }
+            c->live[i].ptr = NULL;
+            return;
+        }
+    }
+}
+
+static void check_alignment(counter *c, void *ptr, size_t alignment)
+{
+    if (ptr != NULL && ((uintptr_t) ptr & (alignment - 1)) != 0)
+    {
+        c->misaligned += 1;
+    }
+}
+
+static void *counting_alloc(size_t size, size_t alignment, void *context)
+{
+    counter *c = context;
+    void *ptr = c->base.alloc(size, alignment, c->base.context);
+    c->allocs += (ptr != NULL);
+    check_alignment(c, ptr, alignment);
+    track(c, ptr, size);
+    return ptr;
+}
+
+static void *counting_zalloc(size_t size, size_t alignment, void *context)
+{
+    counter *c = context;
+    void *ptr = c->base.zalloc(size, alignment, c->base.context);
+    c->allocs += (ptr != NULL);
+    check_alignment(c, ptr, alignment);
+    track(c, ptr, size);
+    return ptr;
+}
+
+static void *counting_realloc(void *ptr, size_t old, size_t size,
+    size_t alignment, void *context)
+{
+    counter *c = context;
+    void *moved = c->base.realloc(ptr, old, size, alignment, c->base.context);
+    check_alignment(c, moved, alignment);
+    if (moved != NULL)
+    {
+        untrack(c, ptr, old);
+        track(c, moved, size);
+    }
+    return moved;
+}
+
+static void counting_free(void *ptr, size_t size, size_t alignment,
+    void *context)
+{
+    counter *c = context;
+    c->frees += 1;
+    untrack(c, ptr, size);
+    c->base.free(ptr, size, alignment, c->base.context);
+}
+
+static void *failing_alloc(size_t size, size_t alignment, void *context)
+{
+    return NULL;
+}
+
+static void failing_free(void *ptr, size_t size, size_t alignment,
+    void *context)
+{
+}
+
+UNIT(AllocatorDefault)
+{
+    inform_allocator a = inform_get_allocator();
+    ASSERT_NOT_NULL(a.alloc);
+    ASSERT_NOT_NULL(a.free);
+
+    // an incomplete allocator restores the default
+    inform_allocator incomplete = { failing_alloc, NULL, NULL, NULL, NULL };
+    inform_set_allocator(&incomplete);
+    ASSERT_TRUE(inform_get_allocator().alloc == a.alloc);
+
+    inform_set_allocator(NULL);
+    ASSERT_TRUE(inform_get_allocator().alloc == a.alloc);
+    ASSERT_TRUE(inform_get_allocator().free == a.free);
+
+    inform_free(NULL);
+}
+
+UNIT(AllocatorHonored)
+{
+    counter c = { .base = inform_get_allocator() };
+    inform_allocator a = { counting_alloc, counting_zalloc, counting_realloc,
+        counting_free, &c };
+    inform_set_allocator(&a);
+
+    inform_dist *dist = inform_dist_alloc(5);
+    ASSERT_NOT_NULL(dist);
+    inform_dist_tick(dist, 4);
+    dist = inform_dist_realloc(dist, 1000);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(1, inform_dist_get(dist, 4));
+    inform_dist_free(dist);
+
+    inform_sparse_dist *sparse = inform_sparse_dist_alloc(0);
+    ASSERT_NOT_NULL(sparse);
+    for (uint64_t i = 0; i < 100; ++i)
+    {
+        inform_sparse_dist_tick(sparse, i * i, NULL);
+    }
+    inform_sparse_dist_free(sparse);
+
+    int series[] = {0,0,1,1,1,1,0,0,0,1,0,1,1,0,0,1,0,0,1,1};
+    int source[] = {1,0,1,1,0,1,0,0,0,1,1,1,0,0,1,1,0,1,1,0};
+    inform_error err = INFORM_SUCCESS;
+    double *ai = inform_local_active_info(series, 2, 10, 2, 2, NULL, &err);
+    ASSERT_NOT_NULL(ai);
+    inform_free(ai);
+
+    inform_workspace *ws = inform_workspace_alloc(0);
+    ASSERT_NOT_NULL(ws);
+    inform_transfer_entropy_ws(source, series, 2, 10, 2, 2, ws, &err);
+    inform_workspace_free(ws);
+
+    // a history too long for a dense histogram takes the sparse path
+    inform_active_info(series, 1, 20, 2, 16, &err);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+
+    int coal[20];
+    ASSERT_EQUAL(2, inform_coalesce(source, 20, coal, &err));
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+
+    inform_set_allocator(NULL);
+
+    ASSERT_TRUE(c.allocs > 0);
+    ASSERT_EQUAL(c.allocs, c.frees);
+    ASSERT_EQUAL(0, c.misaligned);
+    // every block is freed with the size it was allocated with, except for
+    // the returned array which the caller released
+    ASSERT_EQUAL(0, c.missized);
+    ASSERT_EQUAL(1, c.unsized);
+}
+
+UNIT(AllocatorOptionalHooks)
+{
+    counter c = { .base = inform_get_allocator() };
+    inform_allocator a = { counting_alloc, NULL, NULL, counting_free, &c };
+    inform_set_allocator(&a);
+
+    // the library zeros and moves memory itself
+    inform_dist *dist = inform_dist_alloc(3);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(0, inform_dist_get(dist, 2));
+    inform_dist_set(dist, 2, 7);
+    dist = inform_dist_realloc(dist, 300);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(7, inform_dist_get(dist, 2));
+    for (size_t i = 3; i < 300; ++i)
+    {
+        ASSERT_EQUAL(0, inform_dist_get(dist, i));
+    }
+    dist = inform_dist_realloc(dist, 2);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(0, inform_dist_counts(dist));
+    inform_dist_free(dist);
+
+    inform_set_allocator(NULL);
+
+    ASSERT_EQUAL(c.allocs, c.frees);
+    ASSERT_EQUAL(0, c.misaligned);
+    ASSERT_EQUAL(0, c.missized);
+    ASSERT_EQUAL(0, c.unsized);
+}
+
+UNIT(AllocatorFailure)
+{
+    inform_dist *narrow = inform_dist_alloc_width(2, INFORM_COUNTER_8);
+    ASSERT_NOT_NULL(narrow);
+    inform_dist_set(narrow, 1, UINT8_MAX);
+
+    inform_dist *tracked = inform_dist_alloc_width(4, INFORM_COUNTER_8);
+    ASSERT_NOT_NULL(tracked);
+    inform_dist_set(tracked, 1, UINT8_MAX);
+    ASSERT_NOT_NULL(inform_dist_track_nonzero(tracked, true));
+    ASSERT_NOT_NULL(inform_dist_track_entropy(tracked, true));
+    double const clogc = tracked->clogc;
+
+    inform_allocator a = { failing_alloc, NULL, NULL, failing_free, NULL };
+    inform_set_allocator(&a);
+
+    // counters which can't be widened are left as they were
+    ASSERT_EQUAL(0, inform_dist_tick(narrow, 1));
+    ASSERT_EQUAL(UINT8_MAX, inform_dist_get(narrow, 1));
+    ASSERT_EQUAL(UINT8_MAX, inform_dist_counts(narrow));
+    ASSERT_EQUAL(INFORM_COUNTER_8, inform_dist_width(narrow));
+
+    // a batch which fails part way through is rolled back entirely
+    size_t const events[] = {0, 2, 0, 1};
+    ASSERT_EQUAL(0, inform_dist_tick_many(tracked, events, 4));
+    ASSERT_EQUAL(UINT8_MAX, inform_dist_counts(tracked));
+    ASSERT_EQUAL(0, inform_dist_get(tracked, 0));
+    ASSERT_EQUAL(0, inform_dist_get(tracked, 2));
+    size_t nonzero = 0;
+    ASSERT_TRUE(inform_dist_nonzero(tracked, &nonzero) != NULL);
+    ASSERT_EQUAL(1, nonzero);
+    ASSERT_DBL_NEAR_TOL(clogc, tracked->clogc, 1e-9);
+
+    ASSERT_NULL(inform_dist_alloc(5));
+    ASSERT_NULL(inform_sparse_dist_alloc(5));
+    ASSERT_NULL(inform_workspace_alloc(16));
+
+    int series[] = {0,0,1,1,1,1,0,0,0,1};
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_local_active_info(series, 1, 10, 2, 2, NULL, &err));
+    ASSERT_EQUAL(INFORM_ENOMEM, err);
+
+    inform_set_allocator(NULL);
+    inform_dist_free(tracked);
+    inform_dist_free(narrow);
+}
+
+BEGIN_SUITE(Allocator)
+    ADD_UNIT(AllocatorDefault)
+    ADD_UNIT(AllocatorHonored)
+    ADD_UNIT(AllocatorOptionalHooks)
+    ADD_UNIT(AllocatorFailure)
+END_SUITE
@@ -385,6 +385,144 @@ UNIT(LocalBlockEntropyEnsemble_Base4)
     }
 }
 
+UNIT(BlockEntropySparseSupport)
+{
+    int const series[] = {
+        0,0,1,1,1,0,1,0,0,1,1,0,1,1,1,1,0,0,0,1,
+        1,0,1,1,0,0,0,1,0,1,1,1,0,0,1,0,1,0,0,1,
+    };
+    // declaring a base of 64 makes the support far too large for the few
+    // observations, so the sparse path is taken; the bits must not change
+    double const dense = inform_block_entropy(series, 2, 20, 2, 3, NULL);
+    double const sparse = inform_block_entropy(series, 2, 20, 64, 3, NULL);
+    ASSERT_DBL_NEAR_TOL(dense, 6 * sparse, 1e-12);
+}
+
+UNIT(LocalBlockEntropySparseSupport)
+{
+    int const series[] = {
+        0,0,1,1,1,0,1,0,0,1,1,0,1,1,1,1,0,0,0,1,
+        1,0,1,1,0,0,0,1,0,1,1,1,0,0,1,0,1,0,0,1,
+    };
+    double dense[36], sparse[36];
+    // declaring a base of 64 makes the support far too large for the few
+    // observations, so the sparse path is taken; the bits must not change
+    ASSERT_NOT_NULL(inform_local_block_entropy(series, 2, 20, 2, 3, dense, NULL));
+    ASSERT_NOT_NULL(inform_local_block_entropy(series, 2, 20, 64, 3, sparse, NULL));
+    for (size_t i = 0; i < 36; ++i)
+    {
+        ASSERT_DBL_NEAR_TOL(dense[i], 6 * sparse[i], 1e-12);
+    }
+}
+
+UNIT(BlockEntropyLongBlocks)
+{
+    int series[100];
+    unsigned seed = 2016;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        series[i] = (seed >> 16) & 1;
+    }
+
+    // all 61 blocks of length 40 are distinct
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_DBL_NEAR_TOL(log2(61), inform_block_entropy(series, 1, 100, 2, 40, &err), 1e-12);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+
+    err = INFORM_SUCCESS;
+    ASSERT_TRUE(isnan(inform_block_entropy(series, 1, 100, 2, 65, &err)));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+}
+
+static void fill_series(int *series, size_t n, int b, unsigned seed)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        series[i] = (int)((seed >> 16) % (unsigned) b);
+    }
+}
+
+UNIT(BlockEntropySweep)
+{
+    size_t const n = 3, m = 120;
+    int series[3 * 120];
+    int const bases[] = {2, 4, 2};
+    size_t const Ks[] = {40, 10, 119};
+    for (size_t t = 0; t < 3; ++t)
+    {
+        int const b = bases[t];
+        size_t const K = Ks[t];
+        fill_series(series, n * m, b, 9 + (unsigned) t);
+        // repeat a stretch of the first series, so that some long blocks
+        // occur more than once
+        for (size_t j = 60; j < m; ++j)
+        {
+            series[j] = series[j - 50];
+        }
+
+        inform_error err = INFORM_SUCCESS;
+        double *be = inform_block_entropy_sweep(series, n, m, b, K, NULL, &err);
+        ASSERT_NOT_NULL(be);
+        ASSERT_EQUAL(INFORM_SUCCESS, err);
+        for (size_t k = 1; k <= K && k < 64; ++k)
+        {
+            ASSERT_DBL_NEAR_TOL(inform_block_entropy(series, n, m, b, k, &err),
+                be[k - 1], 1e-10);
+        }
+        free(be);
+    }
+}
+
+UNIT(BlockEntropySweepLongBlocks)
+{
+    // a periodic series has as many distinct blocks of every length as its
+    // period, far beyond the lengths a histogram could be built for
+    int series[2 * 100];
+    for (size_t i = 0; i < 200; ++i)
+    {
+        series[i] = (int)((i % 100) % 5);
+    }
+    inform_error err = INFORM_SUCCESS;
+    double be[99];
+    ASSERT_TRUE(be == inform_block_entropy_sweep(series, 2, 100, 5, 99, be, &err));
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    for (size_t k = 1; k <= 99; ++k)
+    {
+        // the block at time t is determined by t mod 5
+        double const N = 101 - k;
+        double h = 0.0;
+        for (size_t r = 0; r < 5; ++r)
+        {
+            double const c = (r <= 100 - k) ? (double)((100 - k - r) / 5 + 1) : 0;
+            if (c > 0)
+            {
+                h -= (c / N) * log(c / N) / log(5.0);
+            }
+        }
+        ASSERT_DBL_NEAR_TOL(h, be[k - 1], 1e-10);
+    }
+}
+
+UNIT(BlockEntropySweepErrors)
+{
+    int series[] = {0,1,1,0,1,0,0,1};
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_block_entropy_sweep(NULL, 1, 8, 2, 3, NULL, &err));
+    ASSERT_EQUAL(INFORM_ETIMESERIES, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_block_entropy_sweep(series, 1, 8, 2, 0, NULL, &err));
+    ASSERT_EQUAL(INFORM_EKZERO, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_block_entropy_sweep(series, 1, 8, 2, 8, NULL, &err));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+    err = INFORM_SUCCESS;
+    series[3] = 2;
+    ASSERT_NULL(inform_block_entropy_sweep(series, 1, 8, 2, 3, NULL, &err));
+    ASSERT_EQUAL(INFORM_EBADSTATE, err);
+}
+
 BEGIN_SUITE(BlockEntropy)
     ADD_UNIT(BlockEntropyNULLSeries)
     ADD_UNIT(BlockEntropyNoInits)
@@ -398,6 +536,8 @@ BEGIN_SUITE(BlockEntropy)
     ADD_UNIT(BlockEntropySingleSeries_Base4)
     ADD_UNIT(BlockEntropyEnsemble)
     ADD_UNIT(BlockEntropyEnsemble_Base4)
+    ADD_UNIT(BlockEntropySparseSupport)
+    ADD_UNIT(BlockEntropyLongBlocks)
     ADD_UNIT(LocalBlockEntropyNULLSeries)
     ADD_UNIT(LocalBlockEntropyNoInits)
     ADD_UNIT(LocalBlockEntropySeriesTooShort)
@@ -411,4 +551,8 @@ BEGIN_SUITE(BlockEntropy)
     ADD_UNIT(LocalBlockEntropySingleSeries_Base4)
     ADD_UNIT(LocalBlockEntropyEnsemble)
     ADD_UNIT(LocalBlockEntropyEnsemble_Base4)
+    ADD_UNIT(LocalBlockEntropySparseSupport)
+    ADD_UNIT(BlockEntropySweep)
+    ADD_UNIT(BlockEntropySweepLongBlocks)
+    ADD_UNIT(BlockEntropySweepErrors)
 END_SUITE
@@ -0,0 +1,158 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <unit.h>
+#include <inform/decay_dist.h>
+#include <inform/shannon.h>
+#include <math.h>
+
+UNIT(DecayAlloc)
+{
+    ASSERT_NULL(inform_decay_dist_alloc(0, 0.5));
+    ASSERT_NULL(inform_decay_dist_alloc(3, 0.0));
+    ASSERT_NULL(inform_decay_dist_alloc(3, 1.5));
+    ASSERT_NULL(inform_decay_dist_alloc(3, NAN));
+
+    inform_decay_dist *dist = inform_decay_dist_alloc(3, 1.0);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(3, inform_decay_dist_size(dist));
+    ASSERT_DBL_NEAR(0.0, inform_decay_dist_weight(dist));
+    ASSERT_FALSE(inform_decay_dist_is_valid(dist));
+    inform_decay_dist_free(dist);
+}
+
+UNIT(DecayNull)
+{
+    ASSERT_EQUAL(0, inform_decay_dist_size(NULL));
+    ASSERT_DBL_NEAR(0.0, inform_decay_dist_weight(NULL));
+    ASSERT_FALSE(inform_decay_dist_is_valid(NULL));
+    ASSERT_DBL_NEAR(0.0, inform_decay_dist_get(NULL, 0));
+    ASSERT_DBL_NEAR(0.0, inform_decay_dist_tick(NULL, 0));
+    ASSERT_DBL_NEAR(0.0, inform_decay_dist_prob(NULL, 0));
+    ASSERT_EQUAL(0, inform_decay_dist_dump(NULL, NULL, 0));
+    ASSERT_TRUE(isnan(inform_decay_shannon(NULL, 2.0)));
+    ASSERT_TRUE(isnan(inform_decay_shannon_si(NULL, 0, 2.0)));
+    inform_decay_dist_clear(NULL);
+    inform_decay_dist_free(NULL);
+}
+
+UNIT(DecayTick)
+{
+    inform_decay_dist *dist = inform_decay_dist_alloc(3, 0.5);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_DBL_NEAR(0.0, inform_decay_dist_tick(dist, 3));
+    ASSERT_DBL_NEAR(1.0, inform_decay_dist_tick(dist, 0));
+    ASSERT_DBL_NEAR(1.0, inform_decay_dist_tick(dist, 1));
+    ASSERT_DBL_NEAR(1.5, inform_decay_dist_tick(dist, 1));
+    ASSERT_DBL_NEAR(0.25, inform_decay_dist_get(dist, 0));
+    ASSERT_DBL_NEAR(1.5, inform_decay_dist_get(dist, 1));
+    ASSERT_DBL_NEAR(0.0, inform_decay_dist_get(dist, 2));
+    ASSERT_DBL_NEAR(1.75, inform_decay_dist_weight(dist));
+    ASSERT_DBL_NEAR(0.25 / 1.75, inform_decay_dist_prob(dist, 0));
+
+    double probs[3];
+    ASSERT_EQUAL(0, inform_decay_dist_dump(dist, probs, 2));
+    ASSERT_EQUAL(3, inform_decay_dist_dump(dist, probs, 3));
+    ASSERT_DBL_NEAR(1.0 / 7, probs[0]);
+    ASSERT_DBL_NEAR(6.0 / 7, probs[1]);
+    ASSERT_DBL_NEAR(0.0, probs[2]);
+
+    inform_decay_dist_clear(dist);
+    ASSERT_FALSE(inform_decay_dist_is_valid(dist));
+    ASSERT_DBL_NEAR(0.0, inform_decay_dist_get(dist, 1));
+    inform_decay_dist_free(dist);
+}
+
+UNIT(DecayNoDecay)
+{
+    // without decay, the weights are simply counts
+    inform_decay_dist *dist = inform_decay_dist_alloc(4, 1.0);
+    inform_dist *counts = inform_dist_alloc(4);
+    int const events[] = {0, 1, 1, 3, 1, 0, 0, 1, 2, 1};
+    for (size_t i = 0; i < 10; ++i)
+    {
+        inform_decay_dist_tick(dist, events[i]);
+        inform_dist_tick(counts, events[i]);
+    }
+    for (size_t i = 0; i < 4; ++i)
+    {
+        ASSERT_DBL_NEAR(inform_dist_get(counts, i), inform_decay_dist_get(dist, i));
+    }
+    ASSERT_DBL_NEAR_TOL(inform_shannon(counts, 2.0),
+        inform_decay_shannon(dist, 2.0), 1e-12);
+    ASSERT_DBL_NEAR_TOL(inform_shannon_si(counts, 3, 2.0),
+        inform_decay_shannon_si(dist, 3, 2.0), 1e-12);
+    inform_dist_free(counts);
+    inform_decay_dist_free(dist);
+}
+
+UNIT(DecayLongStream)
+{
+    // long enough for the weights to be rescaled many times over
+    double const decay = 0.9;
+    inform_decay_dist *dist = inform_decay_dist_alloc(2, decay);
+    ASSERT_NOT_NULL(dist);
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        inform_decay_dist_tick(dist, i % 2);
+    }
+    // the weights converge to geometric series, the latest event being odd
+    double const odd = 1. / (1. - decay * decay);
+    ASSERT_DBL_NEAR_TOL(odd, inform_decay_dist_get(dist, 1), 1e-9);
+    ASSERT_DBL_NEAR_TOL(decay * odd, inform_decay_dist_get(dist, 0), 1e-9);
+    ASSERT_DBL_NEAR_TOL(1. / (1. - decay), inform_decay_dist_weight(dist), 1e-9);
+
+    double const p = 1. / (1. + decay);
+    double const h = -p * log2(p) - (1. - p) * log2(1. - p);
+    ASSERT_DBL_NEAR_TOL(h, inform_decay_shannon(dist, 2.0), 1e-9);
+
+    // a drift to a single event drives the entropy towards zero
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        inform_decay_dist_tick(dist, 0);
+    }
+    ASSERT_DBL_NEAR_TOL(0.0, inform_decay_shannon(dist, 2.0), 1e-9);
+    inform_decay_dist_free(dist);
+}
+
+UNIT(DecayRelativeEntropy)
+{
+    inform_decay_dist *fast = inform_decay_dist_alloc(3, 0.5);
+    inform_decay_dist *slow = inform_decay_dist_alloc(3, 1.0);
+    inform_decay_dist *other = inform_decay_dist_alloc(2, 1.0);
+    int const events[] = {0, 0, 1, 1, 1, 2, 0};
+    for (size_t i = 0; i < 7; ++i)
+    {
+        inform_decay_dist_tick(fast, events[i]);
+        inform_decay_dist_tick(slow, events[i]);
+    }
+    ASSERT_DBL_NEAR(0.0, inform_decay_shannon_re(slow, slow, 2.0));
+
+    double re = 0.;
+    for (size_t i = 0; i < 3; ++i)
+    {
+        double const u = inform_decay_dist_prob(fast, i);
+        double const v = inform_decay_dist_prob(slow, i);
+        re += u * log2(u / v);
+    }
+    ASSERT_DBL_NEAR_TOL(re, inform_decay_shannon_re(fast, slow, 2.0), 1e-12);
+    ASSERT_TRUE(isnan(inform_decay_shannon_re(fast, other, 2.0)));
+
+    inform_decay_dist_tick(other, 1);
+    inform_decay_dist_clear(slow);
+    inform_decay_dist_tick(slow, 2);
+    ASSERT_TRUE(isnan(inform_decay_shannon_re(fast, slow, 2.0)));
+
+    inform_decay_dist_free(other);
+    inform_decay_dist_free(slow);
+    inform_decay_dist_free(fast);
+}
+
+BEGIN_SUITE(DecayDistribution)
+    ADD_UNIT(DecayAlloc)
+    ADD_UNIT(DecayNull)
+    ADD_UNIT(DecayTick)
+    ADD_UNIT(DecayNoDecay)
+    ADD_UNIT(DecayLongStream)
+    ADD_UNIT(DecayRelativeEntropy)
+END_SUITE
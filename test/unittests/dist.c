@@ -3,6 +3,8 @@
 // license that can be found in the LICENSE file.
 #include <unit.h>
 #include <inform/dist.h>
+#include <stdint.h>
+#include <string.h>
 
 UNIT(AllocZero)
 {
@@ -295,6 +297,70 @@ UNIT(Tick)
     inform_dist_free(dist);
 }
 
+UNIT(TickManyNull)
+{
+    size_t events[] = {0, 1, 0};
+    ASSERT_EQUAL(0, inform_dist_tick_many(NULL, events, 3));
+
+    inform_dist *dist = inform_dist_alloc(2);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(0, inform_dist_tick_many(dist, NULL, 3));
+    ASSERT_EQUAL(0, inform_dist_tick_many(dist, events, 0));
+    ASSERT_EQUAL(0, inform_dist_counts(dist));
+    inform_dist_free(dist);
+}
+
+UNIT(TickMany)
+{
+    // long enough, and over a small enough support, to count into
+    // interleaved histograms as well as short enough to count directly
+    size_t const sizes[] = {3, 3, 4097};
+    size_t const lengths[] = {7, 10001, 10001};
+    for (size_t t = 0; t < 3; ++t)
+    {
+        size_t const size = sizes[t], n = lengths[t];
+        size_t *events = malloc(n * sizeof(size_t));
+        ASSERT_NOT_NULL(events);
+        unsigned seed = 7;
+        for (size_t i = 0; i < n; ++i)
+        {
+            seed = seed * 1103515245u + 12345u;
+            // mostly a single event, as in a low-entropy stream
+            events[i] = ((seed >> 16) % 4 == 0) ? (seed >> 8) % size : 0;
+        }
+
+        inform_dist *expect = inform_dist_alloc(size);
+        inform_dist *got = inform_dist_alloc(size);
+        ASSERT_NOT_NULL(expect);
+        ASSERT_NOT_NULL(got);
+        inform_dist_tick(got, 1);
+        inform_dist_tick(expect, 1);
+        for (size_t i = 0; i < n; ++i)
+        {
+            inform_dist_tick(expect, events[i]);
+        }
+        ASSERT_EQUAL(n, inform_dist_tick_many(got, events, n));
+        ASSERT_EQUAL(inform_dist_counts(expect), inform_dist_counts(got));
+        for (size_t i = 0; i < size; ++i)
+        {
+            ASSERT_EQUAL(inform_dist_get(expect, i), inform_dist_get(got, i));
+        }
+
+        // an event outside of the support leaves the distribution unchanged
+        events[n - 2] = size;
+        ASSERT_EQUAL(0, inform_dist_tick_many(got, events, n));
+        ASSERT_EQUAL(inform_dist_counts(expect), inform_dist_counts(got));
+        for (size_t i = 0; i < size; ++i)
+        {
+            ASSERT_EQUAL(inform_dist_get(expect, i), inform_dist_get(got, i));
+        }
+
+        inform_dist_free(got);
+        inform_dist_free(expect);
+        free(events);
+    }
+}
+
 UNIT(Prob)
 {
     inform_dist* dist = inform_dist_alloc(5);
@@ -340,10 +406,775 @@ UNIT(Dump)
     inform_dist_free(dist);
 }
 
+UNIT(AllocAligned)
+{
+    inform_dist *dist = inform_dist_alloc(7);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(0, (uintptr_t) dist->histogram % 64);
+
+    dist = inform_dist_realloc(dist, 1031);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(0, (uintptr_t) dist->histogram % 64);
+
+    inform_dist *dup = inform_dist_dup(dist);
+    ASSERT_NOT_NULL(dup);
+    ASSERT_EQUAL(0, (uintptr_t) dup->histogram % 64);
+
+    inform_dist *created = inform_dist_create((uint32_t[]){1,2,3}, 3);
+    ASSERT_NOT_NULL(created);
+    ASSERT_EQUAL(0, (uintptr_t) created->histogram % 64);
+
+    inform_dist_free(created);
+    inform_dist_free(dup);
+    inform_dist_free(dist);
+}
+
+UNIT(MergeNull)
+{
+    inform_dist *dist = inform_dist_alloc(3);
+    inform_dist *other = inform_dist_alloc(4);
+    ASSERT_NULL(inform_dist_merge(NULL, dist));
+    ASSERT_NULL(inform_dist_merge(dist, NULL));
+    ASSERT_NULL(inform_dist_merge(dist, other));
+    ASSERT_NULL(inform_dist_subtract(NULL, dist));
+    ASSERT_NULL(inform_dist_subtract(dist, NULL));
+    ASSERT_NULL(inform_dist_subtract(dist, other));
+    inform_dist_free(other);
+    inform_dist_free(dist);
+}
+
+UNIT(Merge)
+{
+    uint32_t a[] = {1, 0, 3, 2};
+    uint32_t b[] = {0, 5, 1, 2};
+    inform_dist *src = inform_dist_create(a, 4);
+    inform_dist *dest = inform_dist_create(b, 4);
+    ASSERT_TRUE(dest == inform_dist_merge(src, dest));
+    ASSERT_EQUAL(14, inform_dist_counts(dest));
+    ASSERT_EQUAL(1, inform_dist_get(dest, 0));
+    ASSERT_EQUAL(5, inform_dist_get(dest, 1));
+    ASSERT_EQUAL(4, inform_dist_get(dest, 2));
+    ASSERT_EQUAL(4, inform_dist_get(dest, 3));
+
+    ASSERT_TRUE(dest == inform_dist_subtract(src, dest));
+    ASSERT_EQUAL(8, inform_dist_counts(dest));
+    for (size_t i = 0; i < 4; ++i)
+    {
+        ASSERT_EQUAL(b[i], inform_dist_get(dest, i));
+    }
+
+    // the source has more observations of the first event
+    ASSERT_NULL(inform_dist_subtract(src, dest));
+    ASSERT_EQUAL(8, inform_dist_counts(dest));
+    for (size_t i = 0; i < 4; ++i)
+    {
+        ASSERT_EQUAL(b[i], inform_dist_get(dest, i));
+    }
+
+    inform_dist_free(dest);
+    inform_dist_free(src);
+}
+
+UNIT(MergeOverflow)
+{
+    uint32_t a[] = {1, 1, 1};
+    uint32_t b[] = {0, 2, UINT32_MAX};
+    inform_dist *src = inform_dist_create(a, 3);
+    inform_dist *dest = inform_dist_create(b, 3);
+    ASSERT_NULL(inform_dist_merge(src, dest));
+    ASSERT_EQUAL(0, inform_dist_get(dest, 0));
+    ASSERT_EQUAL(2, inform_dist_get(dest, 1));
+    ASSERT_EQUAL(UINT32_MAX, inform_dist_get(dest, 2));
+    inform_dist_free(dest);
+    inform_dist_free(src);
+}
+
+UNIT(MergeShards)
+{
+    size_t events[1000];
+    unsigned seed = 3;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        events[i] = (seed >> 16) % 10;
+    }
+    inform_dist *whole = inform_dist_alloc(10);
+    inform_dist_tick_many(whole, events, 1000);
+
+    inform_dist *total = inform_dist_alloc(10);
+    for (size_t shard = 0; shard < 4; ++shard)
+    {
+        inform_dist *part = inform_dist_alloc(10);
+        inform_dist_tick_many(part, events + 250 * shard, 250);
+        ASSERT_NOT_NULL(inform_dist_merge(part, total));
+        inform_dist_free(part);
+    }
+    ASSERT_EQUAL(inform_dist_counts(whole), inform_dist_counts(total));
+    for (size_t i = 0; i < 10; ++i)
+    {
+        ASSERT_EQUAL(inform_dist_get(whole, i), inform_dist_get(total, i));
+    }
+    inform_dist_free(total);
+    inform_dist_free(whole);
+}
+
+static void assert_same_dist(inform_dist *a, inform_dist *b)
+{
+    ASSERT_NOT_NULL(a);
+    ASSERT_NOT_NULL(b);
+    ASSERT_EQUAL(inform_dist_size(a), inform_dist_size(b));
+    ASSERT_EQUAL(inform_dist_counts(a), inform_dist_counts(b));
+    for (size_t i = 0; i < inform_dist_size(a); ++i)
+    {
+        ASSERT_EQUAL(inform_dist_get64(a, i), inform_dist_get64(b, i));
+    }
+}
+
+UNIT(SerializeNull)
+{
+    uint8_t buffer[64];
+    ASSERT_EQUAL(0, inform_dist_serialized_size(NULL));
+    ASSERT_EQUAL(0, inform_dist_serialize(NULL, buffer, 64));
+    ASSERT_NULL(inform_dist_deserialize(NULL, 64, SIZE_MAX, NULL));
+
+    inform_dist *dist = inform_dist_alloc(3);
+    ASSERT_EQUAL(0, inform_dist_serialize(dist, NULL, 64));
+    // the buffer is too small
+    size_t const size = inform_dist_serialized_size(dist);
+    ASSERT_EQUAL(0, inform_dist_serialize(dist, buffer, size - 1));
+    inform_dist_free(dist);
+}
+
+UNIT(SerializeDense)
+{
+    uint32_t data[] = {3, 0, 200, 70000, UINT32_MAX};
+    inform_dist *dist = inform_dist_create(data, 5);
+    size_t const size = inform_dist_serialized_size(dist);
+    uint8_t *buffer = malloc(size);
+    ASSERT_EQUAL(size, inform_dist_serialize(dist, buffer, size));
+    ASSERT_EQUAL('I', buffer[0]);
+    ASSERT_EQUAL('F', buffer[1]);
+    ASSERT_EQUAL('D', buffer[2]);
+    ASSERT_EQUAL('S', buffer[3]);
+    ASSERT_EQUAL(2, buffer[4]);
+    ASSERT_EQUAL(0, buffer[5]);
+    ASSERT_EQUAL(INFORM_COUNTER_32, buffer[6]);
+
+    size_t read = 0;
+    inform_dist *copy = inform_dist_deserialize(buffer, size, SIZE_MAX, &read);
+    ASSERT_EQUAL(size, read);
+    assert_same_dist(dist, copy);
+
+    inform_dist_free(copy);
+    free(buffer);
+    inform_dist_free(dist);
+}
+
+UNIT(SerializeSparse)
+{
+    inform_dist *dist = inform_dist_alloc(100000);
+    inform_dist_set(dist, 0, 5);
+    inform_dist_set(dist, 777, 1);
+    inform_dist_set(dist, 99999, 300);
+    size_t const size = inform_dist_serialized_size(dist);
+    ASSERT_TRUE(size < 32);
+    uint8_t buffer[32];
+    ASSERT_EQUAL(size, inform_dist_serialize(dist, buffer, 32));
+    ASSERT_EQUAL(1, buffer[5]);
+
+    inform_dist *copy = inform_dist_deserialize(buffer, size, SIZE_MAX, NULL);
+    assert_same_dist(dist, copy);
+
+    inform_dist_free(copy);
+    inform_dist_free(dist);
+}
+
+UNIT(SerializeConcatenated)
+{
+    uint32_t a[] = {1, 2, 3};
+    uint32_t b[] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 9};
+    inform_dist *x = inform_dist_create(a, 3);
+    inform_dist *y = inform_dist_create(b, 12);
+
+    uint8_t buffer[64];
+    size_t n = inform_dist_serialize(x, buffer, 64);
+    ASSERT_TRUE(n > 0);
+    size_t const m = inform_dist_serialize(y, buffer + n, 64 - n);
+    ASSERT_TRUE(m > 0);
+
+    size_t read = 0;
+    inform_dist *u = inform_dist_deserialize(buffer, n + m, SIZE_MAX, &read);
+    ASSERT_EQUAL(n, read);
+    inform_dist *v = inform_dist_deserialize(buffer + read, n + m - read, SIZE_MAX, &read);
+    ASSERT_EQUAL(m, read);
+    assert_same_dist(x, u);
+    assert_same_dist(y, v);
+
+    inform_dist_free(v);
+    inform_dist_free(u);
+    inform_dist_free(y);
+    inform_dist_free(x);
+}
+
+UNIT(DeserializeMalformed)
+{
+    uint32_t data[] = {1, 130, 2};
+    inform_dist *dist = inform_dist_create(data, 3);
+    uint8_t buffer[32];
+    size_t const size = inform_dist_serialize(dist, buffer, 32);
+    ASSERT_TRUE(size > 0);
+
+    // truncated at every possible length
+    for (size_t n = 0; n < size; ++n)
+    {
+        ASSERT_NULL(inform_dist_deserialize(buffer, n, SIZE_MAX, NULL));
+    }
+
+    uint8_t bad[32];
+    // the wrong magic
+    memcpy(bad, buffer, size);
+    bad[0] = 'X';
+    ASSERT_NULL(inform_dist_deserialize(bad, size, SIZE_MAX, NULL));
+    // an unknown version
+    memcpy(bad, buffer, size);
+    bad[4] = 3;
+    ASSERT_NULL(inform_dist_deserialize(bad, size, SIZE_MAX, NULL));
+    // an unknown encoding
+    memcpy(bad, buffer, size);
+    bad[5] = 7;
+    ASSERT_NULL(inform_dist_deserialize(bad, size, SIZE_MAX, NULL));
+    // unknown flags
+    memcpy(bad, buffer, size);
+    bad[6] = 0x80;
+    ASSERT_NULL(inform_dist_deserialize(bad, size, SIZE_MAX, NULL));
+    // the counts don't add up
+    memcpy(bad, buffer, size);
+    bad[size - 1] += 1;
+    ASSERT_NULL(inform_dist_deserialize(bad, size, SIZE_MAX, NULL));
+    // the counts don't fit in counters which can't be promoted
+    inform_dist *wide = inform_dist_alloc_width(3, INFORM_COUNTER_64);
+    ASSERT_NOT_NULL(wide);
+    inform_dist_set(wide, 1, 300);
+    size_t const m = inform_dist_serialize(wide, bad, 32);
+    ASSERT_TRUE(m > 0);
+    bad[6] = INFORM_COUNTER_8;
+    ASSERT_NULL(inform_dist_deserialize(bad, m, SIZE_MAX, NULL));
+    inform_dist_free(wide);
+
+    inform_dist_free(dist);
+}
+
+UNIT(DeserializeMaxSize)
+{
+    inform_dist *dist = inform_dist_alloc(100000);
+    ASSERT_NOT_NULL(dist);
+    inform_dist_set(dist, 99999, 3);
+    uint8_t buffer[32];
+    size_t const size = inform_dist_serialize(dist, buffer, 32);
+    ASSERT_TRUE(size > 0);
+
+    ASSERT_NULL(inform_dist_deserialize(buffer, size, 99999, NULL));
+    inform_dist *copy = inform_dist_deserialize(buffer, size, 100000, NULL);
+    assert_same_dist(dist, copy);
+    inform_dist_free(copy);
+    inform_dist_free(dist);
+
+    // a short sparse encoding which claims an enormous, empty support
+    uint8_t const huge[] = {'I', 'F', 'D', 'S', 2, 1, 0,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3f, 0, 0};
+    ASSERT_NULL(inform_dist_deserialize(huge, sizeof(huge), 1 << 20, NULL));
+}
+
+UNIT(AllocWidth)
+{
+    ASSERT_NULL(inform_dist_alloc_width(0, INFORM_COUNTER_8));
+    ASSERT_NULL(inform_dist_alloc_width(3, (inform_counter_width) 42));
+    ASSERT_EQUAL(INFORM_COUNTER_32, inform_dist_width(NULL));
+
+    inform_counter_width const widths[] = {INFORM_COUNTER_8, INFORM_COUNTER_16,
+        INFORM_COUNTER_32, INFORM_COUNTER_64};
+    for (size_t i = 0; i < 4; ++i)
+    {
+        inform_dist *dist = inform_dist_alloc_width(3, widths[i]);
+        ASSERT_NOT_NULL(dist);
+        ASSERT_EQUAL(widths[i], inform_dist_width(dist));
+        ASSERT_EQUAL(3, inform_dist_size(dist));
+        ASSERT_EQUAL(0, inform_dist_counts(dist));
+        for (size_t j = 0; j < 3; ++j)
+        {
+            ASSERT_EQUAL(0, inform_dist_get64(dist, j));
+        }
+        inform_dist_free(dist);
+    }
+}
+
+UNIT(AdaptiveWidth)
+{
+    inform_dist *dist = inform_dist_alloc_width(3, INFORM_COUNTER_8);
+    ASSERT_NOT_NULL(dist);
+    for (size_t i = 0; i < 255; ++i)
+    {
+        inform_dist_tick(dist, 1);
+    }
+    ASSERT_EQUAL(INFORM_COUNTER_8, inform_dist_width(dist));
+    ASSERT_EQUAL(256, inform_dist_tick(dist, 1));
+    ASSERT_EQUAL(INFORM_COUNTER_16, inform_dist_width(dist));
+    ASSERT_EQUAL(256, inform_dist_get(dist, 1));
+    ASSERT_EQUAL(256, inform_dist_counts(dist));
+
+    // a count is promoted straight to the narrowest width which holds it
+    ASSERT_EQUAL(70000, inform_dist_set(dist, 0, 70000));
+    ASSERT_EQUAL(INFORM_COUNTER_32, inform_dist_width(dist));
+    ASSERT_EQUAL(70000, inform_dist_get(dist, 0));
+    ASSERT_EQUAL(256, inform_dist_get(dist, 1));
+    ASSERT_EQUAL(70256, inform_dist_counts(dist));
+
+    // and keeps growing past the range of a 32-bit counter
+    inform_dist *more = inform_dist_alloc_width(3, INFORM_COUNTER_64);
+    ASSERT_NOT_NULL(more);
+    inform_dist_set(more, 0, UINT32_MAX);
+    ASSERT_NOT_NULL(inform_dist_merge(more, dist));
+    ASSERT_EQUAL(INFORM_COUNTER_64, inform_dist_width(dist));
+    ASSERT_EQUAL(UINT64_C(70000) + UINT32_MAX, inform_dist_get64(dist, 0));
+    ASSERT_EQUAL(UINT32_MAX, inform_dist_get(dist, 0));
+    ASSERT_EQUAL(UINT64_C(70256) + UINT32_MAX, inform_dist_counts(dist));
+
+    inform_dist_free(more);
+    inform_dist_free(dist);
+}
+
+UNIT(WideCounts)
+{
+    inform_dist *dist = inform_dist_alloc_width(4, INFORM_COUNTER_64);
+    ASSERT_NOT_NULL(dist);
+    inform_dist_set(dist, 2, UINT32_MAX);
+    ASSERT_EQUAL(UINT32_MAX, inform_dist_tick(dist, 2));
+    ASSERT_EQUAL(UINT64_C(1) + UINT32_MAX, inform_dist_get64(dist, 2));
+    ASSERT_EQUAL(UINT32_MAX, inform_dist_get(dist, 2));
+    inform_dist_tick(dist, 0);
+    ASSERT_DBL_NEAR(1. / (UINT64_C(2) + UINT32_MAX), inform_dist_prob(dist, 0));
+
+    // a 32-bit distribution can't hold the counts, but a copy can
+    inform_dist *legacy = inform_dist_alloc(4);
+    ASSERT_NOT_NULL(legacy);
+    inform_dist_tick(legacy, 2);
+    ASSERT_NULL(inform_dist_merge(dist, legacy));
+    ASSERT_EQUAL(1, inform_dist_get(legacy, 2));
+    ASSERT_NOT_NULL(inform_dist_copy(dist, legacy));
+    ASSERT_EQUAL(INFORM_COUNTER_64, inform_dist_width(legacy));
+    assert_same_dist(dist, legacy);
+
+    inform_dist *dup = inform_dist_dup(dist);
+    assert_same_dist(dist, dup);
+    ASSERT_EQUAL(INFORM_COUNTER_64, inform_dist_width(dup));
+    dup = inform_dist_realloc(dup, 8);
+    ASSERT_NOT_NULL(dup);
+    ASSERT_EQUAL(UINT64_C(1) + UINT32_MAX, inform_dist_get64(dup, 2));
+    ASSERT_EQUAL(0, inform_dist_get64(dup, 7));
+
+    ASSERT_NOT_NULL(inform_dist_subtract(legacy, dist));
+    ASSERT_EQUAL(0, inform_dist_counts(dist));
+
+    inform_dist_free(dup);
+    inform_dist_free(legacy);
+    inform_dist_free(dist);
+}
+
+UNIT(TickManyWidths)
+{
+    size_t const n = 2000;
+    size_t *events = malloc(n * sizeof(size_t));
+    ASSERT_NOT_NULL(events);
+    for (size_t i = 0; i < n; ++i)
+    {
+        events[i] = (i % 7 == 0) ? 2 : 0;
+    }
+    inform_dist *expect = inform_dist_alloc(3);
+    inform_dist *got = inform_dist_alloc_width(3, INFORM_COUNTER_8);
+    ASSERT_NOT_NULL(expect);
+    ASSERT_NOT_NULL(got);
+    ASSERT_EQUAL(n, inform_dist_tick_many(expect, events, n));
+    ASSERT_EQUAL(n, inform_dist_tick_many(got, events, n));
+    ASSERT_EQUAL(INFORM_COUNTER_16, inform_dist_width(got));
+    assert_same_dist(expect, got);
+
+    events[n - 1] = 3;
+    ASSERT_EQUAL(0, inform_dist_tick_many(got, events, n));
+    assert_same_dist(expect, got);
+
+    inform_dist_free(got);
+    inform_dist_free(expect);
+    free(events);
+}
+
+UNIT(SerializeWide)
+{
+    inform_dist *dist = inform_dist_alloc_width(5, INFORM_COUNTER_64);
+    ASSERT_NOT_NULL(dist);
+    inform_dist_set(dist, 1, UINT32_MAX);
+    inform_dist_merge(dist, dist);
+    inform_dist_tick(dist, 3);
+    ASSERT_EQUAL(UINT64_C(2) * UINT32_MAX, inform_dist_get64(dist, 1));
+
+    size_t const size = inform_dist_serialized_size(dist);
+    uint8_t *buffer = malloc(size);
+    ASSERT_NOT_NULL(buffer);
+    ASSERT_EQUAL(size, inform_dist_serialize(dist, buffer, size));
+    inform_dist *copy = inform_dist_deserialize(buffer, size, SIZE_MAX, NULL);
+    assert_same_dist(dist, copy);
+    ASSERT_EQUAL(INFORM_COUNTER_64, inform_dist_width(copy));
+
+    // the width, adaptivity and tracking of the counters survive the trip
+    inform_dist *narrow = inform_dist_alloc_width(5, INFORM_COUNTER_8);
+    ASSERT_NOT_NULL(narrow);
+    inform_dist_set(narrow, 4, 9);
+    inform_dist_set(narrow, 1, 2);
+    ASSERT_NOT_NULL(inform_dist_track_nonzero(narrow, true));
+    ASSERT_NOT_NULL(inform_dist_track_entropy(narrow, true));
+    uint8_t a[32];
+    size_t const m = inform_dist_serialize(narrow, a, sizeof(a));
+    ASSERT_TRUE(m != 0);
+    inform_dist *restored = inform_dist_deserialize(a, m, SIZE_MAX, NULL);
+    assert_same_dist(narrow, restored);
+    ASSERT_EQUAL(INFORM_COUNTER_8, inform_dist_width(restored));
+    ASSERT_TRUE(restored->adaptive);
+    ASSERT_TRUE(restored->track_entropy);
+    ASSERT_DBL_NEAR(narrow->clogc, restored->clogc);
+    size_t nonzero = 0;
+    ASSERT_TRUE(inform_dist_nonzero(restored, &nonzero) != NULL);
+    ASSERT_EQUAL(2, nonzero);
+
+    inform_dist_free(restored);
+    inform_dist_free(narrow);
+    inform_dist_free(copy);
+    free(buffer);
+    inform_dist_free(dist);
+}
+
+static void assert_nonzero(inform_dist *dist)
+{
+    size_t n = 0;
+    size_t const *events = inform_dist_nonzero(dist, &n);
+    ASSERT_NOT_NULL((void *) events);
+    size_t expect = 0;
+    for (size_t i = 0; i < inform_dist_size(dist); ++i)
+    {
+        expect += (inform_dist_get64(dist, i) != 0);
+    }
+    ASSERT_EQUAL(expect, n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        ASSERT_TRUE(events[i] < inform_dist_size(dist));
+        ASSERT_TRUE(inform_dist_get64(dist, events[i]) != 0);
+        for (size_t j = 0; j < i; ++j)
+        {
+            ASSERT_TRUE(events[i] != events[j]);
+        }
+    }
+}
+
+UNIT(TrackNonzeroNull)
+{
+    size_t n = 5;
+    ASSERT_NULL(inform_dist_track_nonzero(NULL, true));
+    ASSERT_NULL((void *) inform_dist_nonzero(NULL, &n));
+    ASSERT_EQUAL(0, n);
+    inform_dist_clear(NULL);
+
+    inform_dist *dist = inform_dist_alloc(3);
+    n = 5;
+    ASSERT_NULL((void *) inform_dist_nonzero(dist, &n));
+    ASSERT_EQUAL(0, n);
+    inform_dist_free(dist);
+}
+
+UNIT(TrackNonzero)
+{
+    inform_dist *dist = inform_dist_alloc(1000);
+    ASSERT_NOT_NULL(dist);
+    inform_dist_tick(dist, 10);
+    inform_dist_set(dist, 999, 4);
+    ASSERT_TRUE(inform_dist_track_nonzero(dist, true) == dist);
+    assert_nonzero(dist);
+
+    // observing, resetting and re-observing events
+    for (size_t i = 0; i < 100; ++i)
+    {
+        inform_dist_tick(dist, (i * 37) % 1000);
+    }
+    assert_nonzero(dist);
+    inform_dist_set(dist, 10, 0);
+    inform_dist_set(dist, 999, 0);
+    inform_dist_set(dist, 999, 0);
+    assert_nonzero(dist);
+    inform_dist_tick(dist, 10);
+    size_t const events[] = {1, 2, 3, 1, 1, 500};
+    ASSERT_EQUAL(6, inform_dist_tick_many(dist, events, 6));
+    assert_nonzero(dist);
+
+    // merging, subtracting and copying keep the list current
+    inform_dist *other = inform_dist_alloc(1000);
+    ASSERT_NOT_NULL(other);
+    inform_dist_tick(other, 998);
+    inform_dist_tick(other, 10);
+    ASSERT_NOT_NULL(inform_dist_merge(other, dist));
+    assert_nonzero(dist);
+    ASSERT_NOT_NULL(inform_dist_subtract(other, dist));
+    assert_nonzero(dist);
+
+    ASSERT_NOT_NULL(inform_dist_copy(dist, other));
+    assert_nonzero(other);
+    assert_same_dist(dist, other);
+    inform_dist *dup = inform_dist_dup(dist);
+    assert_nonzero(dup);
+    assert_same_dist(dist, dup);
+
+    dup = inform_dist_realloc(dup, 400);
+    ASSERT_NOT_NULL(dup);
+    assert_nonzero(dup);
+
+    // clearing only resets the observed events
+    uint64_t const counts = inform_dist_counts(dist);
+    ASSERT_TRUE(counts != 0);
+    inform_dist_clear(dist);
+    ASSERT_EQUAL(0, inform_dist_counts(dist));
+    assert_nonzero(dist);
+    for (size_t i = 0; i < inform_dist_size(dist); ++i)
+    {
+        ASSERT_EQUAL(0, inform_dist_get(dist, i));
+    }
+
+    // an untracked copy stops tracking the destination
+    inform_dist *plain = inform_dist_alloc(1000);
+    ASSERT_NOT_NULL(inform_dist_copy(plain, other));
+    ASSERT_NULL((void *) inform_dist_nonzero(other, NULL));
+    ASSERT_TRUE(inform_dist_track_nonzero(dist, false) == dist);
+    ASSERT_NULL((void *) inform_dist_nonzero(dist, NULL));
+
+    inform_dist_free(plain);
+    inform_dist_free(dup);
+    inform_dist_free(other);
+    inform_dist_free(dist);
+}
+
+UNIT(TrackNonzeroWidths)
+{
+    inform_dist *dist = inform_dist_alloc_width(4, INFORM_COUNTER_8);
+    ASSERT_NOT_NULL(inform_dist_track_nonzero(dist, true));
+    for (size_t i = 0; i < 300; ++i)
+    {
+        inform_dist_tick(dist, 2);
+    }
+    inform_dist_tick(dist, 0);
+    ASSERT_EQUAL(INFORM_COUNTER_16, inform_dist_width(dist));
+    assert_nonzero(dist);
+
+    double probs[4];
+    ASSERT_EQUAL(4, inform_dist_dump(dist, probs, 4));
+    ASSERT_DBL_NEAR(1. / 301, probs[0]);
+    ASSERT_DBL_NEAR(0., probs[1]);
+    ASSERT_DBL_NEAR(300. / 301, probs[2]);
+    ASSERT_DBL_NEAR(0., probs[3]);
+
+    inform_dist_clear(dist);
+    ASSERT_EQUAL(INFORM_COUNTER_16, inform_dist_width(dist));
+    ASSERT_EQUAL(0, inform_dist_get(dist, 2));
+    inform_dist_free(dist);
+}
+
+UNIT(ClearUntracked)
+{
+    inform_dist *dist = inform_dist_alloc_width(5, INFORM_COUNTER_64);
+    inform_dist_tick(dist, 1);
+    inform_dist_set(dist, 4, 7);
+    inform_dist_clear(dist);
+    ASSERT_EQUAL(5, inform_dist_size(dist));
+    ASSERT_EQUAL(0, inform_dist_counts(dist));
+    for (size_t i = 0; i < 5; ++i)
+    {
+        ASSERT_EQUAL(0, inform_dist_get(dist, i));
+    }
+    inform_dist_free(dist);
+}
+
+UNIT(Untick)
+{
+    ASSERT_EQUAL(0, inform_dist_untick(NULL, 0));
+    inform_dist *dist = inform_dist_alloc(3);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(0, inform_dist_untick(dist, 1));
+    ASSERT_EQUAL(0, inform_dist_untick(dist, 3));
+    ASSERT_EQUAL(0, inform_dist_counts(dist));
+
+    inform_dist_tick(dist, 1);
+    inform_dist_tick(dist, 1);
+    inform_dist_tick(dist, 2);
+    ASSERT_EQUAL(1, inform_dist_untick(dist, 1));
+    ASSERT_EQUAL(2, inform_dist_counts(dist));
+    ASSERT_EQUAL(0, inform_dist_untick(dist, 2));
+    ASSERT_EQUAL(0, inform_dist_get(dist, 2));
+    ASSERT_EQUAL(1, inform_dist_counts(dist));
+
+    ASSERT_NOT_NULL(inform_dist_track_nonzero(dist, true));
+    ASSERT_EQUAL(0, inform_dist_untick(dist, 1));
+    assert_nonzero(dist);
+    ASSERT_EQUAL(0, inform_dist_counts(dist));
+    inform_dist_free(dist);
+}
+
+UNIT(MarginalErrors)
+{
+    size_t const shape[] = {2, 3};
+    size_t const axes[] = {1, 1};
+    inform_dist *joint = inform_dist_alloc(6);
+    inform_dist *small = inform_dist_alloc(2);
+    ASSERT_NULL(inform_dist_marginal(NULL, shape, 2, axes, 1, NULL));
+    ASSERT_NULL(inform_dist_marginal(joint, NULL, 2, axes, 1, NULL));
+    ASSERT_NULL(inform_dist_marginal(joint, shape, 0, axes, 0, NULL));
+    ASSERT_NULL(inform_dist_marginal(joint, shape, 1, axes, 1, NULL));
+    ASSERT_NULL(inform_dist_marginal(joint, shape, 2, NULL, 1, NULL));
+    ASSERT_NULL(inform_dist_marginal(joint, shape, 2, axes, 2, NULL));
+    ASSERT_NULL(inform_dist_marginal(joint, shape, 2, axes, 3, NULL));
+    size_t const out[] = {2};
+    ASSERT_NULL(inform_dist_marginal(joint, shape, 2, out, 1, NULL));
+    ASSERT_NULL(inform_dist_marginal(joint, shape, 2, axes, 1, small));
+
+    size_t const map[] = {0, 1, 2, 0, 1, 2};
+    ASSERT_NULL(inform_dist_coarse_grain(NULL, map, 3, NULL));
+    ASSERT_NULL(inform_dist_coarse_grain(joint, NULL, 3, NULL));
+    ASSERT_NULL(inform_dist_coarse_grain(joint, map, 0, NULL));
+    ASSERT_NULL(inform_dist_coarse_grain(joint, map, 2, NULL));
+    ASSERT_NULL(inform_dist_coarse_grain(joint, map, 3, small));
+
+    inform_dist_free(small);
+    inform_dist_free(joint);
+}
+
+UNIT(Marginal)
+{
+    // a joint distribution of three variables with 2, 3 and 4 values
+    size_t const shape[] = {2, 3, 4};
+    inform_dist *joint = inform_dist_alloc(24);
+    ASSERT_NOT_NULL(joint);
+    for (size_t e = 0; e < 24; ++e)
+    {
+        inform_dist_set(joint, e, (uint32_t)((e * 7) % 5));
+    }
+
+    for (int tracked = 0; tracked < 2; ++tracked)
+    {
+        ASSERT_NOT_NULL(inform_dist_track_nonzero(joint, tracked));
+
+        // keep the last and first variables, in that order
+        size_t const axes[] = {2, 0};
+        inform_dist *marginal = inform_dist_marginal(joint, shape, 3, axes, 2,
+            NULL);
+        ASSERT_NOT_NULL(marginal);
+        ASSERT_EQUAL(8, inform_dist_size(marginal));
+        ASSERT_EQUAL(inform_dist_counts(joint), inform_dist_counts(marginal));
+        for (size_t z = 0; z < 4; ++z)
+        {
+            for (size_t x = 0; x < 2; ++x)
+            {
+                uint32_t expect = 0;
+                for (size_t y = 0; y < 3; ++y)
+                {
+                    expect += inform_dist_get(joint, (x * 3 + y) * 4 + z);
+                }
+                ASSERT_EQUAL(expect, inform_dist_get(marginal, z * 2 + x));
+            }
+        }
+
+        // the middle variable, into an existing adaptive distribution
+        size_t const middle[] = {1};
+        inform_dist *narrow = inform_dist_alloc_width(3, INFORM_COUNTER_8);
+        ASSERT_NOT_NULL(inform_dist_track_nonzero(narrow, true));
+        ASSERT_NOT_NULL(inform_dist_track_entropy(narrow, true));
+        ASSERT_TRUE(inform_dist_marginal(joint, shape, 3, middle, 1, narrow)
+            == narrow);
+        for (size_t y = 0; y < 3; ++y)
+        {
+            uint32_t expect = 0;
+            for (size_t x = 0; x < 2; ++x)
+            {
+                for (size_t z = 0; z < 4; ++z)
+                {
+                    expect += inform_dist_get(joint, (x * 3 + y) * 4 + z);
+                }
+            }
+            ASSERT_EQUAL(expect, inform_dist_get(narrow, y));
+        }
+        assert_nonzero(narrow);
+
+        // keeping every variable in order is the identity, and keeping none
+        // leaves only the total
+        size_t const all[] = {0, 1, 2};
+        inform_dist *same = inform_dist_marginal(joint, shape, 3, all, 3, NULL);
+        assert_same_dist(joint, same);
+        inform_dist *none = inform_dist_marginal(joint, shape, 3, NULL, 0, NULL);
+        ASSERT_EQUAL(1, inform_dist_size(none));
+        ASSERT_EQUAL(inform_dist_counts(joint), inform_dist_get(none, 0));
+
+        inform_dist_free(none);
+        inform_dist_free(same);
+        inform_dist_free(narrow);
+        inform_dist_free(marginal);
+    }
+    inform_dist_free(joint);
+}
+
+UNIT(CoarseGrain)
+{
+    inform_dist *dist = inform_dist_alloc(6);
+    ASSERT_NOT_NULL(dist);
+    uint32_t const counts[] = {1, 0, 4, 2, 8, 3};
+    for (size_t i = 0; i < 6; ++i)
+    {
+        inform_dist_set(dist, i, counts[i]);
+    }
+    size_t const map[] = {2, 0, 0, 2, 1, 2};
+    for (int tracked = 0; tracked < 2; ++tracked)
+    {
+        ASSERT_NOT_NULL(inform_dist_track_nonzero(dist, tracked));
+        inform_dist *coarse = inform_dist_coarse_grain(dist, map, 4, NULL);
+        ASSERT_NOT_NULL(coarse);
+        ASSERT_EQUAL(4, inform_dist_size(coarse));
+        ASSERT_EQUAL(18, inform_dist_counts(coarse));
+        ASSERT_EQUAL(4, inform_dist_get(coarse, 0));
+        ASSERT_EQUAL(8, inform_dist_get(coarse, 1));
+        ASSERT_EQUAL(6, inform_dist_get(coarse, 2));
+        ASSERT_EQUAL(0, inform_dist_get(coarse, 3));
+
+        // replacing the contents of an existing distribution
+        ASSERT_TRUE(inform_dist_coarse_grain(dist, map, 4, coarse) == coarse);
+        ASSERT_EQUAL(18, inform_dist_counts(coarse));
+        ASSERT_EQUAL(6, inform_dist_get(coarse, 2));
+        inform_dist_free(coarse);
+    }
+
+    // a fixed-width destination which can't hold the counts is untouched
+    inform_dist *wide = inform_dist_alloc_width(6, INFORM_COUNTER_64);
+    inform_dist_set(wide, 0, UINT32_MAX);
+    inform_dist_set(wide, 3, 1);
+    inform_dist *legacy = inform_dist_alloc(4);
+    inform_dist_tick(legacy, 1);
+    ASSERT_NULL(inform_dist_coarse_grain(wide, map, 4, legacy));
+    ASSERT_EQUAL(1, inform_dist_get(legacy, 1));
+    inform_dist *coarse = inform_dist_coarse_grain(wide, map, 4, NULL);
+    ASSERT_EQUAL(INFORM_COUNTER_64, inform_dist_width(coarse));
+    ASSERT_EQUAL(UINT64_C(1) + UINT32_MAX, inform_dist_get64(coarse, 2));
+
+    inform_dist_free(coarse);
+    inform_dist_free(legacy);
+    inform_dist_free(wide);
+    inform_dist_free(dist);
+}
+
 BEGIN_SUITE(Distribution)
     ADD_UNIT(AllocZero)
     ADD_UNIT(AllocOne)
     ADD_UNIT(AllocTwo)
+    ADD_UNIT(AllocAligned)
     ADD_UNIT(GetNull)
     ADD_UNIT(SetNull)
     ADD_UNIT(Set)
@@ -359,6 +1190,31 @@ BEGIN_SUITE(Distribution)
     ADD_UNIT(DupNull)
     ADD_UNIT(Dup)
     ADD_UNIT(Tick)
+    ADD_UNIT(TickManyNull)
+    ADD_UNIT(TickMany)
     ADD_UNIT(Prob)
     ADD_UNIT(Dump)
+    ADD_UNIT(MergeNull)
+    ADD_UNIT(Merge)
+    ADD_UNIT(MergeOverflow)
+    ADD_UNIT(MergeShards)
+    ADD_UNIT(SerializeNull)
+    ADD_UNIT(SerializeDense)
+    ADD_UNIT(SerializeSparse)
+    ADD_UNIT(SerializeConcatenated)
+    ADD_UNIT(DeserializeMalformed)
+    ADD_UNIT(DeserializeMaxSize)
+    ADD_UNIT(AllocWidth)
+    ADD_UNIT(AdaptiveWidth)
+    ADD_UNIT(WideCounts)
+    ADD_UNIT(TickManyWidths)
+    ADD_UNIT(SerializeWide)
+    ADD_UNIT(TrackNonzeroNull)
+    ADD_UNIT(TrackNonzero)
+    ADD_UNIT(TrackNonzeroWidths)
+    ADD_UNIT(ClearUntracked)
+    ADD_UNIT(Untick)
+    ADD_UNIT(MarginalErrors)
+    ADD_UNIT(Marginal)
+    ADD_UNIT(CoarseGrain)
 END_SUITE
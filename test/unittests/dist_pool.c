@@ -0,0 +1,188 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <unit.h>
+#include <inform/allocator.h>
+#include <inform/dist_pool.h>
+#include <inform/shannon.h>
+#include <stdint.h>
+
+static size_t allocations = 0;
+
+static void *counting_alloc(size_t size, size_t alignment, void *context)
+{
+    inform_allocator const *base = context;
+    allocations += 1;
+    return base->alloc(size, alignment, base->context);
+}
+
+static void counting_free(void *ptr, size_t size, size_t alignment,
+    void *context)
+{
+    inform_allocator const *base = context;
+    base->free(ptr, size, alignment, base->context);
+}
+
+UNIT(PoolNull)
+{
+    ASSERT_EQUAL(0, inform_dist_pool_cached(NULL));
+    inform_dist_pool_trim(NULL);
+    inform_dist_pool_free(NULL);
+
+    // without a pool, distributions come from the heap
+    inform_dist *dist = inform_dist_pool_get(NULL, 5, INFORM_COUNTER_32);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_FALSE(dist->pooled);
+    inform_dist_pool_put(NULL, dist);
+
+    inform_dist_pool *pool = inform_dist_pool_alloc();
+    ASSERT_NOT_NULL(pool);
+    ASSERT_EQUAL(0, inform_dist_pool_cached(pool));
+    ASSERT_NULL(inform_dist_pool_get(pool, 0, INFORM_COUNTER_32));
+    ASSERT_NULL(inform_dist_pool_get(pool, 5, (inform_counter_width) 7));
+    ASSERT_NULL(inform_dist_pool_get(pool, SIZE_MAX / 2, INFORM_COUNTER_64));
+    inform_dist_pool_put(pool, NULL);
+
+    // a distribution from the heap goes back to the heap
+    inform_dist_pool_put(pool, inform_dist_alloc(5));
+    ASSERT_EQUAL(0, inform_dist_pool_cached(pool));
+    inform_dist_pool_free(pool);
+}
+
+UNIT(PoolGet)
+{
+    inform_dist_pool *pool = inform_dist_pool_alloc();
+    inform_counter_width const widths[] = {INFORM_COUNTER_32, INFORM_COUNTER_8,
+        INFORM_COUNTER_16, INFORM_COUNTER_64};
+    for (size_t i = 0; i < 4; ++i)
+    {
+        inform_dist *dist = inform_dist_pool_get(pool, 100, widths[i]);
+        ASSERT_NOT_NULL(dist);
+        ASSERT_TRUE(dist->pooled);
+        ASSERT_EQUAL(0, (uintptr_t) dist->counters % 64);
+        ASSERT_EQUAL(100, inform_dist_size(dist));
+        ASSERT_EQUAL(0, inform_dist_counts(dist));
+        ASSERT_EQUAL(widths[i], inform_dist_width(dist));
+        ASSERT_FALSE(inform_dist_is_valid(dist));
+        for (size_t j = 0; j < 100; ++j)
+        {
+            ASSERT_EQUAL(0, inform_dist_get(dist, j));
+        }
+        inform_dist_tick(dist, 3);
+        inform_dist_tick(dist, 3);
+        inform_dist_tick(dist, 99);
+        ASSERT_EQUAL(2, inform_dist_get(dist, 3));
+        ASSERT_EQUAL(1, inform_dist_get(dist, 99));
+        ASSERT_DBL_NEAR_TOL(0.918296, inform_shannon(dist, 2.0), 1e-6);
+        inform_dist_pool_put(pool, dist);
+    }
+    ASSERT_TRUE(inform_dist_pool_cached(pool) > 0);
+    inform_dist_pool_trim(pool);
+    ASSERT_EQUAL(0, inform_dist_pool_cached(pool));
+    inform_dist_pool_free(pool);
+}
+
+UNIT(PoolReuse)
+{
+    inform_dist_pool *pool = inform_dist_pool_alloc();
+    inform_dist *dist = inform_dist_pool_get(pool, 10, INFORM_COUNTER_32);
+    for (size_t i = 0; i < 10; ++i)
+    {
+        inform_dist_set(dist, i, (uint32_t) i + 1);
+    }
+    inform_dist_pool_put(pool, dist);
+    size_t const cached = inform_dist_pool_cached(pool);
+    ASSERT_TRUE(cached > 0);
+
+    // a distribution of a similar size takes the same block, cleared
+    inform_dist *again = inform_dist_pool_get(pool, 12, INFORM_COUNTER_32);
+    ASSERT_TRUE(again == dist);
+    ASSERT_EQUAL(0, inform_dist_pool_cached(pool));
+    ASSERT_EQUAL(12, inform_dist_size(again));
+    ASSERT_EQUAL(0, inform_dist_counts(again));
+    for (size_t i = 0; i < 12; ++i)
+    {
+        ASSERT_EQUAL(0, inform_dist_get(again, i));
+    }
+
+    // while a much larger one needs a block of its own
+    inform_dist *large = inform_dist_pool_get(pool, 10000, INFORM_COUNTER_32);
+    ASSERT_TRUE(large != again);
+    inform_dist_pool_put(pool, again);
+    inform_dist_pool_put(pool, large);
+    ASSERT_TRUE(inform_dist_pool_cached(pool) > 10000 * sizeof(uint32_t));
+    inform_dist_pool_free(pool);
+}
+
+UNIT(PoolModified)
+{
+    inform_dist_pool *pool = inform_dist_pool_alloc();
+
+    // resizing moves the counters out of the block, keeping their contents
+    inform_dist *dist = inform_dist_pool_get(pool, 4, INFORM_COUNTER_32);
+    inform_dist_tick(dist, 1);
+    inform_dist_tick(dist, 3);
+    ASSERT_TRUE(inform_dist_realloc(dist, 5000) == dist);
+    ASSERT_EQUAL(0, (uintptr_t) dist->counters % 64);
+    ASSERT_EQUAL(1, inform_dist_get(dist, 1));
+    ASSERT_EQUAL(1, inform_dist_get(dist, 3));
+    ASSERT_EQUAL(0, inform_dist_get(dist, 4999));
+    ASSERT_TRUE(inform_dist_realloc(dist, 2) == dist);
+    ASSERT_EQUAL(1, inform_dist_counts(dist));
+    inform_dist_pool_put(pool, dist);
+
+    // as does promoting the counters
+    dist = inform_dist_pool_get(pool, 4, INFORM_COUNTER_8);
+    ASSERT_NOT_NULL(inform_dist_track_nonzero(dist, true));
+    for (size_t i = 0; i < 300; ++i)
+    {
+        inform_dist_tick(dist, 2);
+    }
+    ASSERT_EQUAL(INFORM_COUNTER_16, inform_dist_width(dist));
+    ASSERT_EQUAL(300, inform_dist_get(dist, 2));
+    inform_dist_pool_put(pool, dist);
+
+    // copying into a pooled distribution of another shape
+    inform_dist *src = inform_dist_alloc(7);
+    inform_dist_tick(src, 6);
+    dist = inform_dist_pool_get(pool, 4, INFORM_COUNTER_32);
+    ASSERT_TRUE(inform_dist_copy(src, dist) == dist);
+    ASSERT_EQUAL(1, inform_dist_get(dist, 6));
+    inform_dist_free(src);
+
+    // and a pooled distribution may simply be freed
+    inform_dist_free(dist);
+    inform_dist_free(inform_dist_pool_get(pool, 4, INFORM_COUNTER_32));
+    inform_dist_pool_free(pool);
+}
+
+UNIT(PoolAvoidsHeap)
+{
+    inform_allocator base = inform_get_allocator();
+    inform_allocator a = { counting_alloc, NULL, NULL, counting_free, &base };
+    inform_dist_pool *pool = inform_dist_pool_alloc();
+    inform_set_allocator(&a);
+
+    allocations = 0;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        inform_dist *x = inform_dist_pool_get(pool, 2 + i % 3, INFORM_COUNTER_32);
+        inform_dist *xy = inform_dist_pool_get(pool, 6 + i % 5, INFORM_COUNTER_32);
+        inform_dist_tick(x, 1);
+        inform_dist_tick(xy, 5);
+        inform_dist_pool_put(pool, xy);
+        inform_dist_pool_put(pool, x);
+    }
+    ASSERT_EQUAL(2, allocations);
+
+    inform_set_allocator(NULL);
+    inform_dist_pool_free(pool);
+}
+
+BEGIN_SUITE(DistributionPool)
+    ADD_UNIT(PoolNull)
+    ADD_UNIT(PoolGet)
+    ADD_UNIT(PoolReuse)
+    ADD_UNIT(PoolModified)
+    ADD_UNIT(PoolAvoidsHeap)
+END_SUITE
@@ -388,6 +388,203 @@ UNIT(LocalEntropyRateEnsemble_Base4)
     }
 }
 
+UNIT(EntropyRateSparseSupport)
+{
+    int const series[] = {
+        0,0,1,1,1,0,1,0,0,1,1,0,1,1,1,1,0,0,0,1,
+        1,0,1,1,0,0,0,1,0,1,1,1,0,0,1,0,1,0,0,1,
+    };
+    // declaring a base of 64 makes the support far too large for the few
+    // observations, so the sparse path is taken; the bits must not change
+    double const dense = inform_entropy_rate(series, 2, 20, 2, 3, NULL);
+    double const sparse = inform_entropy_rate(series, 2, 20, 64, 3, NULL);
+    ASSERT_DBL_NEAR_TOL(dense, 6 * sparse, 1e-12);
+}
+
+UNIT(LocalEntropyRateSparseSupport)
+{
+    int const series[] = {
+        0,0,1,1,1,0,1,0,0,1,1,0,1,1,1,1,0,0,0,1,
+        1,0,1,1,0,0,0,1,0,1,1,1,0,0,1,0,1,0,0,1,
+    };
+    double dense[34], sparse[34];
+    // declaring a base of 64 makes the support far too large for the few
+    // observations, so the sparse path is taken; the bits must not change
+    ASSERT_NOT_NULL(inform_local_entropy_rate(series, 2, 20, 2, 3, dense, NULL));
+    ASSERT_NOT_NULL(inform_local_entropy_rate(series, 2, 20, 64, 3, sparse, NULL));
+    for (size_t i = 0; i < 34; ++i)
+    {
+        ASSERT_DBL_NEAR_TOL(dense[i], 6 * sparse[i], 1e-12);
+    }
+}
+
+UNIT(EntropyRateLongHistory)
+{
+    int series[100];
+    unsigned seed = 2016;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        series[i] = (seed >> 16) & 1;
+    }
+
+    // every history of length 40 is distinct, so there is no uncertainty
+    // left in the next state
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_DBL_NEAR_TOL(0.0, inform_entropy_rate(series, 1, 100, 2, 40, &err), 1e-12);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+
+    err = INFORM_SUCCESS;
+    ASSERT_TRUE(isnan(inform_entropy_rate(series, 1, 100, 2, 64, &err)));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+}
+
+static void fill_series(int *series, size_t n, int b, unsigned seed)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        series[i] = (int)((seed >> 16) % (unsigned) b);
+    }
+}
+
+UNIT(EntropyRateAccumulatorErrors)
+{
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_entropy_rate_acc_alloc(1, 2, &err));
+    ASSERT_EQUAL(INFORM_EBASE, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_entropy_rate_acc_alloc(2, 0, &err));
+    ASSERT_EQUAL(INFORM_EKZERO, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_entropy_rate_acc_alloc(2, 64, &err));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+
+    err = INFORM_SUCCESS;
+    ASSERT_TRUE(isnan(inform_entropy_rate_acc_value(NULL, &err)));
+    ASSERT_EQUAL(INFORM_EFAULT, err);
+    err = INFORM_SUCCESS;
+    inform_entropy_rate_acc_push(NULL, NULL, 0, &err);
+    ASSERT_EQUAL(INFORM_EFAULT, err);
+    inform_entropy_rate_acc_restart(NULL);
+    inform_entropy_rate_acc_clear(NULL);
+    inform_entropy_rate_acc_free(NULL);
+
+    err = INFORM_SUCCESS;
+    inform_entropy_rate_acc *acc = inform_entropy_rate_acc_alloc(2, 2, &err);
+    ASSERT_NOT_NULL(acc);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(isnan(inform_entropy_rate_acc_value(acc, &err)));
+    ASSERT_EQUAL(INFORM_EDIST, err);
+
+    // a time series no longer than the history observes nothing
+    int const series[] = {0,1,1,0,2,1};
+    err = INFORM_SUCCESS;
+    inform_entropy_rate_acc_push(acc, series, 2, &err);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(isnan(inform_entropy_rate_acc_value(acc, &err)));
+
+    // invalid states are rejected as a whole
+    err = INFORM_SUCCESS;
+    inform_entropy_rate_acc_push(acc, NULL, 1, &err);
+    ASSERT_EQUAL(INFORM_ETIMESERIES, err);
+    err = INFORM_SUCCESS;
+    inform_entropy_rate_acc_push(acc, series + 2, 4, &err);
+    ASSERT_EQUAL(INFORM_EBADSTATE, err);
+    err = INFORM_SUCCESS;
+    int const negative[] = {1,-1};
+    inform_entropy_rate_acc_push(acc, negative, 2, &err);
+    ASSERT_EQUAL(INFORM_ENEGSTATE, err);
+    ASSERT_EQUAL(0, inform_dist_counts(acc->states));
+
+    inform_entropy_rate_acc_free(acc);
+}
+
+UNIT(EntropyRateAccumulator)
+{
+    size_t const n = 6, m = 50;
+    int series[6 * 50];
+    int const bases[] = {2, 3, 4};
+    size_t const chunks[] = {1, 0, 7, 2, 13, 50};
+    for (size_t t = 0; t < 3; ++t)
+    {
+        int const b = bases[t];
+        size_t const k = 3 - t;
+        fill_series(series, n * m, b, 17 + (unsigned) t);
+
+        inform_error err = INFORM_SUCCESS;
+        inform_entropy_rate_acc *acc = inform_entropy_rate_acc_alloc(b, k, &err);
+        ASSERT_NOT_NULL(acc);
+        for (size_t i = 0; i < n; ++i)
+        {
+            // push each time series in uneven pieces
+            size_t pushed = 0;
+            for (size_t c = 0; pushed < m; ++c)
+            {
+                size_t const size = (chunks[c] < m - pushed) ? chunks[c] : m - pushed;
+                inform_entropy_rate_acc_push(acc, series + i * m + pushed, size, &err);
+                pushed += size;
+            }
+            ASSERT_EQUAL(INFORM_SUCCESS, err);
+            ASSERT_DBL_NEAR_TOL(inform_entropy_rate(series, i + 1, m, b, k, &err),
+                inform_entropy_rate_acc_value(acc, &err), 1e-10);
+            inform_entropy_rate_acc_restart(acc);
+        }
+
+        // a cleared accumulator starts over
+        inform_entropy_rate_acc_clear(acc);
+        inform_entropy_rate_acc_push(acc, series + m, m, &err);
+        ASSERT_DBL_NEAR_TOL(inform_entropy_rate(series + m, 1, m, b, k, &err),
+            inform_entropy_rate_acc_value(acc, &err), 1e-10);
+        ASSERT_EQUAL(INFORM_SUCCESS, err);
+        inform_entropy_rate_acc_free(acc);
+    }
+}
+
+UNIT(EntropyRateSweep)
+{
+    size_t const n = 4, m = 100;
+    int series[4 * 100];
+    int const bases[] = {2, 3, 2};
+    // the last history is long enough that its histograms are sparse
+    size_t const Ks[] = {7, 4, 20};
+    for (size_t t = 0; t < 3; ++t)
+    {
+        int const b = bases[t];
+        size_t const K = Ks[t];
+        fill_series(series, n * m, b, 3 + (unsigned) t);
+        for (size_t i = 3; i < n * m; i += 3)
+        {
+            series[i] = series[i - 3];
+        }
+
+        inform_error err = INFORM_SUCCESS;
+        double *er = inform_entropy_rate_sweep(series, n, m, b, K, NULL, &err);
+        ASSERT_NOT_NULL(er);
+        ASSERT_EQUAL(INFORM_SUCCESS, err);
+        for (size_t k = 1; k <= K; ++k)
+        {
+            ASSERT_DBL_NEAR_TOL(inform_entropy_rate(series, n, m, b, k, &err), er[k - 1],
+                1e-10);
+        }
+        free(er);
+    }
+
+    inform_error err = INFORM_SUCCESS;
+    double out[4];
+    ASSERT_TRUE(out == inform_entropy_rate_sweep(series, n, m, 2, 4, out, &err));
+    ASSERT_DBL_NEAR(inform_entropy_rate(series, n, m, 2, 4, &err), out[3]);
+
+    ASSERT_NULL(inform_entropy_rate_sweep(series, n, m, 2, 0, NULL, &err));
+    ASSERT_EQUAL(INFORM_EKZERO, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_entropy_rate_sweep(series, n, m, 2, m, NULL, &err));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_entropy_rate_sweep(NULL, n, m, 2, 3, NULL, &err));
+    ASSERT_EQUAL(INFORM_ETIMESERIES, err);
+}
+
 BEGIN_SUITE(EntropyRate)
     ADD_UNIT(EntropyRateNULLSeries)
     ADD_UNIT(EntropyRateNoInits)
@@ -401,6 +598,8 @@ BEGIN_SUITE(EntropyRate)
     ADD_UNIT(EntropyRateSingleSeries_Base4)
     ADD_UNIT(EntropyRateEnsemble)
     ADD_UNIT(EntropyRateEnsemble_Base4)
+    ADD_UNIT(EntropyRateSparseSupport)
+    ADD_UNIT(EntropyRateLongHistory)
     ADD_UNIT(LocalEntropyRateNULLSeries)
     ADD_UNIT(LocalEntropyRateNoInits)
     ADD_UNIT(LocalEntropyRateSeriesTooShort)
@@ -414,4 +613,8 @@ BEGIN_SUITE(EntropyRate)
     ADD_UNIT(LocalEntropyRateSingleSeries_Base4)
     ADD_UNIT(LocalEntropyRateEnsemble)
     ADD_UNIT(LocalEntropyRateEnsemble_Base4)
+    ADD_UNIT(LocalEntropyRateSparseSupport)
+    ADD_UNIT(EntropyRateAccumulatorErrors)
+    ADD_UNIT(EntropyRateAccumulator)
+    ADD_UNIT(EntropyRateSweep)
 END_SUITE
@@ -0,0 +1,217 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <unit.h>
+#include <inform/active_info.h>
+#include <inform/allocator.h>
+#include <inform/block_entropy.h>
+#include <inform/entropy_rate.h>
+#include <inform/history_measures.h>
+#include <math.h>
+
+#define ALL_MEASURES (INFORM_BLOCK_ENTROPY | INFORM_ENTROPY_RATE | \
+    INFORM_ACTIVE_INFO | INFORM_LOCAL_BLOCK_ENTROPY | \
+    INFORM_LOCAL_ENTROPY_RATE | INFORM_LOCAL_ACTIVE_INFO)
+
+static void fill_series(int *series, size_t n, int b, unsigned seed)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        series[i] = (int)((seed >> 16) % (unsigned) b);
+    }
+}
+
+static void assert_separate(int const *series, size_t n, size_t m, int b,
+    size_t k, inform_history_results const *r)
+{
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_DBL_NEAR(inform_block_entropy(series, n, m, b, k, &err),
+        r->block_entropy);
+    ASSERT_DBL_NEAR(inform_entropy_rate(series, n, m, b, k, &err),
+        r->entropy_rate);
+    ASSERT_DBL_NEAR(inform_active_info(series, n, m, b, k, &err),
+        r->active_info);
+
+    double *be = inform_local_block_entropy(series, n, m, b, k, NULL, &err);
+    double *er = inform_local_entropy_rate(series, n, m, b, k, NULL, &err);
+    double *ai = inform_local_active_info(series, n, m, b, k, NULL, &err);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    for (size_t i = 0; i < n * (m - k + 1); ++i)
+    {
+        ASSERT_DBL_NEAR(be[i], r->local_block_entropy[i]);
+    }
+    for (size_t i = 0; i < n * (m - k); ++i)
+    {
+        ASSERT_DBL_NEAR(er[i], r->local_entropy_rate[i]);
+        ASSERT_DBL_NEAR(ai[i], r->local_active_info[i]);
+    }
+    inform_free(ai);
+    inform_free(er);
+    inform_free(be);
+}
+
+UNIT(HistoryMeasuresErrors)
+{
+    int series[] = {0,1,1,0,1,0,0,1};
+    inform_history_results r = { 0, 0, 0, NULL, NULL, NULL };
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_history_measures(series, 1, 8, 2, 2, ALL_MEASURES,
+        NULL, &err));
+    ASSERT_EQUAL(INFORM_EARG, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_history_measures(series, 1, 8, 2, 2,
+        INFORM_ACTIVE_INFO | (1 << 6), &r, &err));
+    ASSERT_EQUAL(INFORM_EARG, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_history_measures(NULL, 1, 8, 2, 2, ALL_MEASURES, &r,
+        &err));
+    ASSERT_EQUAL(INFORM_ETIMESERIES, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_history_measures(series, 1, 8, 2, 8, ALL_MEASURES, &r,
+        &err));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_history_measures(series, 1, 8, 2, 0, ALL_MEASURES, &r,
+        &err));
+    ASSERT_EQUAL(INFORM_EKZERO, err);
+    err = INFORM_SUCCESS;
+    series[5] = 2;
+    ASSERT_NULL(inform_history_measures(series, 1, 8, 2, 2, ALL_MEASURES, &r,
+        &err));
+    ASSERT_EQUAL(INFORM_EBADSTATE, err);
+    ASSERT_NULL(r.local_active_info);
+}
+
+UNIT(HistoryMeasuresAll)
+{
+    size_t const n = 4, m = 60;
+    int series[4 * 60];
+    int const bases[] = {2, 3, 4};
+    for (size_t t = 0; t < 3; ++t)
+    {
+        int const b = bases[t];
+        size_t const k = 3 - t;
+        fill_series(series, n * m, b, 21 + (unsigned) t);
+        for (size_t i = 2; i < n * m; i += 2)
+        {
+            series[i] = series[i - 2];
+        }
+
+        inform_error err = INFORM_SUCCESS;
+        inform_history_results r = { 0, 0, 0, NULL, NULL, NULL };
+        ASSERT_TRUE(&r == inform_history_measures(series, n, m, b, k,
+            ALL_MEASURES, &r, &err));
+        ASSERT_EQUAL(INFORM_SUCCESS, err);
+        assert_separate(series, n, m, b, k, &r);
+        inform_free(r.local_active_info);
+        inform_free(r.local_entropy_rate);
+        inform_free(r.local_block_entropy);
+    }
+}
+
+UNIT(HistoryMeasuresSome)
+{
+    size_t const n = 2, m = 30, k = 2;
+    int series[2 * 30];
+    fill_series(series, n * m, 2, 8);
+
+    // the local arrays may be provided
+    double ai[2 * 28] = {0};
+    inform_history_results r = { 0, 0, 0, NULL, NULL, ai };
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_TRUE(&r == inform_history_measures(series, n, m, 2, k,
+        INFORM_ENTROPY_RATE | INFORM_LOCAL_ACTIVE_INFO, &r, &err));
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(isnan(r.block_entropy));
+    ASSERT_TRUE(isnan(r.active_info));
+    ASSERT_NULL(r.local_block_entropy);
+    ASSERT_NULL(r.local_entropy_rate);
+    ASSERT_TRUE(r.local_active_info == ai);
+    ASSERT_DBL_NEAR(inform_entropy_rate(series, n, m, 2, k, &err),
+        r.entropy_rate);
+    double *expected = inform_local_active_info(series, n, m, 2, k, NULL, &err);
+    for (size_t i = 0; i < n * (m - k); ++i)
+    {
+        ASSERT_DBL_NEAR(expected[i], ai[i]);
+    }
+    inform_free(expected);
+}
+
+UNIT(HistoryMeasuresSparse)
+{
+    // histories this long are counted sparsely, one measure at a time
+    size_t const n = 2, m = 100, k = 20;
+    int series[2 * 100];
+    fill_series(series, n * m, 2, 13);
+    for (size_t i = 50; i < m; ++i)
+    {
+        series[i] = series[i - 30];
+    }
+
+    inform_error err = INFORM_SUCCESS;
+    inform_history_results r = { 0, 0, 0, NULL, NULL, NULL };
+    ASSERT_TRUE(&r == inform_history_measures(series, n, m, 2, k,
+        ALL_MEASURES, &r, &err));
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    assert_separate(series, n, m, 2, k, &r);
+    inform_free(r.local_active_info);
+    inform_free(r.local_entropy_rate);
+    inform_free(r.local_block_entropy);
+}
+
+static void assert_blocks(int const *series, size_t n, size_t m, int b,
+    size_t k)
+{
+    int const measures = INFORM_BLOCK_ENTROPY | INFORM_LOCAL_BLOCK_ENTROPY;
+    inform_error err = INFORM_SUCCESS;
+    inform_history_results r = { 0, 0, 0, NULL, NULL, NULL };
+    ASSERT_TRUE(&r == inform_history_measures(series, n, m, b, k, measures,
+        &r, &err));
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(isnan(r.entropy_rate));
+    ASSERT_TRUE(isnan(r.active_info));
+
+    ASSERT_TRUE(inform_block_entropy(series, n, m, b, k, &err) ==
+        r.block_entropy);
+    double *be = inform_local_block_entropy(series, n, m, b, k, NULL, &err);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    for (size_t i = 0; i < n * (m - k + 1); ++i)
+    {
+        ASSERT_TRUE(be[i] == r.local_block_entropy[i]);
+    }
+    inform_free(be);
+    inform_free(r.local_block_entropy);
+}
+
+UNIT(HistoryMeasuresBlocksOnly)
+{
+    // blocks of 63 binary states can be encoded, though histories of 63
+    // states and their futures can't
+    int series[70];
+    fill_series(series, 70, 2, 5);
+    assert_blocks(series, 1, 70, 2, 63);
+
+    inform_error err = INFORM_SUCCESS;
+    inform_history_results r = { 0, 0, 0, NULL, NULL, NULL };
+    ASSERT_NULL(inform_history_measures(series, 1, 70, 2, 63,
+        INFORM_BLOCK_ENTROPY | INFORM_ENTROPY_RATE, &r, &err));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+
+    // the histories of 16 states and their futures would be counted
+    // sparsely, while the blocks of 16 states are counted densely
+    size_t const m = 10000;
+    int *longer = malloc(m * sizeof(int));
+    ASSERT_NOT_NULL(longer);
+    fill_series(longer, m, 2, 17);
+    assert_blocks(longer, 1, m, 2, 16);
+    free(longer);
+}
+
+BEGIN_SUITE(HistoryMeasures)
+    ADD_UNIT(HistoryMeasuresErrors)
+    ADD_UNIT(HistoryMeasuresAll)
+    ADD_UNIT(HistoryMeasuresSome)
+    ADD_UNIT(HistoryMeasuresSparse)
+    ADD_UNIT(HistoryMeasuresBlocksOnly)
+END_SUITE
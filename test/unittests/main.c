@@ -4,29 +4,45 @@
 #include <unit.h>
 
 IMPORT_SUITE(ActiveInformation);
+IMPORT_SUITE(Allocator);
 IMPORT_SUITE(BlockEntropy);
 IMPORT_SUITE(Canary);
 IMPORT_SUITE(ConditionalEntropy);
+IMPORT_SUITE(DecayDistribution);
 IMPORT_SUITE(Distribution);
+IMPORT_SUITE(DistributionPool);
 IMPORT_SUITE(Entropy);
 IMPORT_SUITE(EntropyRate);
+IMPORT_SUITE(HistoryMeasures);
 IMPORT_SUITE(MutualInfo);
 IMPORT_SUITE(RelativeEntropy);
+IMPORT_SUITE(SparseDistribution);
+IMPORT_SUITE(Threads);
 IMPORT_SUITE(TransferEntropy);
 IMPORT_SUITE(Utilities);
+IMPORT_SUITE(WindowDistribution);
+IMPORT_SUITE(Workspace);
 
 BEGIN_REGISTRATION
     REGISTER(ActiveInformation)
+    REGISTER(Allocator)
     REGISTER(BlockEntropy)
     REGISTER(Canary)
     REGISTER(ConditionalEntropy)
+    REGISTER(DecayDistribution)
     REGISTER(Distribution)
+    REGISTER(DistributionPool)
     REGISTER(Entropy)
     REGISTER(EntropyRate)
+    REGISTER(HistoryMeasures)
     REGISTER(MutualInfo)
     REGISTER(RelativeEntropy)
+    REGISTER(SparseDistribution)
+    REGISTER(Threads)
     REGISTER(TransferEntropy)
     REGISTER(Utilities)
+    REGISTER(WindowDistribution)
+    REGISTER(Workspace)
 END_REGISTRATION
 
 UNIT_MAIN();
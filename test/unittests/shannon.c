@@ -4,6 +4,7 @@
 #include <unit.h>
 
 #include <inform/shannon.h>
+#include <inform/threads.h>
 #include <inform/utilities/random.h>
 
 #define inform_dist_fill_array(dist, array) \
@@ -57,6 +58,194 @@ UNIT(ShannonUniform)
     inform_dist_free(dist);
 }
 
+UNIT(ShannonCounterWidths)
+{
+    // large enough to span several blocks of the summation kernels
+    size_t const size = 3000;
+    inform_counter_width const widths[] = {INFORM_COUNTER_8, INFORM_COUNTER_16,
+        INFORM_COUNTER_32, INFORM_COUNTER_64};
+    double h[4];
+    for (size_t i = 0; i < 4; ++i)
+    {
+        inform_dist *dist = inform_dist_alloc_width(size, widths[i]);
+        ASSERT_NOT_NULL(dist);
+        for (size_t j = 0; j < size; ++j)
+        {
+            inform_dist_set(dist, j, (uint32_t)((j * j) % 251));
+        }
+        ASSERT_EQUAL(widths[i], inform_dist_width(dist));
+        h[i] = inform_shannon(dist, 2.0);
+        inform_dist_free(dist);
+    }
+    ASSERT_TRUE(h[0] == h[1]);
+    ASSERT_TRUE(h[1] == h[3]);
+    ASSERT_DBL_NEAR_TOL(h[0], h[2], 1e-12);
+}
+
+UNIT(ShannonTrackedNonzero)
+{
+    inform_dist *plain = inform_dist_alloc(100000);
+    inform_dist *tracked = inform_dist_alloc(100000);
+    ASSERT_NOT_NULL(inform_dist_track_nonzero(tracked, true));
+    for (size_t i = 0; i < 500; ++i)
+    {
+        size_t const event = (i * i * 7919) % 100000;
+        inform_dist_tick(plain, event);
+        inform_dist_tick(tracked, event);
+    }
+    ASSERT_DBL_NEAR_TOL(inform_shannon(plain, 2.0),
+        inform_shannon(tracked, 2.0), 1e-12);
+
+    inform_dist *q = inform_dist_alloc(100000);
+    ASSERT_NOT_NULL(inform_dist_copy(plain, q));
+    inform_dist_tick(q, 3);
+    ASSERT_DBL_NEAR_TOL(inform_shannon_re(plain, q, 2.0),
+        inform_shannon_re(tracked, q, 2.0), 1e-12);
+    ASSERT_TRUE(isnan(inform_shannon_re(q, tracked, 2.0)));
+
+    inform_dist_free(q);
+    inform_dist_free(tracked);
+    inform_dist_free(plain);
+}
+
+static void assert_tracked_entropy(inform_dist *tracked)
+{
+    inform_dist *plain = inform_dist_dup(tracked);
+    ASSERT_NOT_NULL(plain);
+    ASSERT_NOT_NULL(inform_dist_track_entropy(plain, false));
+    ASSERT_DBL_NEAR_TOL(inform_shannon(plain, 2.0),
+        inform_shannon(tracked, 2.0), 1e-10);
+    ASSERT_DBL_NEAR_TOL(inform_shannon(plain, 3.0),
+        inform_shannon(tracked, 3.0), 1e-10);
+    inform_dist_free(plain);
+}
+
+UNIT(ShannonTrackedEntropy)
+{
+    ASSERT_NULL(inform_dist_track_entropy(NULL, true));
+
+    inform_dist *dist = inform_dist_alloc_width(50, INFORM_COUNTER_8);
+    inform_dist_tick(dist, 3);
+    inform_dist_tick(dist, 3);
+    inform_dist_tick(dist, 7);
+    ASSERT_TRUE(inform_dist_track_entropy(dist, true) == dist);
+    assert_tracked_entropy(dist);
+
+    // a long stream, which widens the counters along the way
+    unsigned seed = 11;
+    for (size_t i = 0; i < 200000; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        inform_dist_tick(dist, ((seed >> 16) % 8 == 0) ? (seed >> 8) % 50 : 0);
+    }
+    ASSERT_EQUAL(INFORM_COUNTER_32, inform_dist_width(dist));
+    assert_tracked_entropy(dist);
+
+    inform_dist_set(dist, 0, 0);
+    inform_dist_set(dist, 49, 123456);
+    assert_tracked_entropy(dist);
+
+    size_t const events[] = {0, 0, 1, 2, 49};
+    ASSERT_EQUAL(5, inform_dist_tick_many(dist, events, 5));
+    assert_tracked_entropy(dist);
+
+    inform_dist *other = inform_dist_alloc(50);
+    ASSERT_NOT_NULL(other);
+    inform_dist_set(other, 0, 5);
+    inform_dist_set(other, 2, 3);
+    inform_dist_set(other, 30, 1);
+    ASSERT_NOT_NULL(inform_dist_merge(other, dist));
+    assert_tracked_entropy(dist);
+    ASSERT_NOT_NULL(inform_dist_subtract(other, dist));
+    assert_tracked_entropy(dist);
+
+    dist = inform_dist_realloc(dist, 20);
+    ASSERT_NOT_NULL(dist);
+    assert_tracked_entropy(dist);
+
+    // tracking both the entropy and the nonzero events
+    ASSERT_NOT_NULL(inform_dist_track_nonzero(dist, true));
+    inform_dist_clear(dist);
+    ASSERT_TRUE(isnan(inform_shannon(dist, 2.0)));
+    inform_dist_tick(dist, 4);
+    ASSERT_DBL_NEAR(0.0, inform_shannon(dist, 2.0));
+    inform_dist_tick(dist, 5);
+    ASSERT_DBL_NEAR(1.0, inform_shannon(dist, 2.0));
+    assert_tracked_entropy(dist);
+
+    inform_dist_free(other);
+    inform_dist_free(dist);
+}
+
+UNIT(ShannonJointNaN)
+{
+    inform_dist *joint = inform_dist_alloc(6);
+    ASSERT_TRUE(isnan(inform_shannon_joint_mi(NULL, 2, 3, 2.0)));
+    ASSERT_TRUE(isnan(inform_shannon_joint_mi(joint, 2, 3, 2.0)));
+    inform_dist_tick(joint, 4);
+    ASSERT_TRUE(isnan(inform_shannon_joint_mi(joint, 3, 3, 2.0)));
+    ASSERT_TRUE(isnan(inform_shannon_joint_ce(joint, 0, 3, 2.0)));
+    ASSERT_TRUE(isnan(inform_shannon_joint_cmi(joint, 1, 2, 2, 2.0)));
+    ASSERT_TRUE(isnan(inform_shannon_joint_cmi(joint, SIZE_MAX, 2, 3, 2.0)));
+    ASSERT_DBL_NEAR(0.0, inform_shannon_joint_mi(joint, 2, 3, 2.0));
+    ASSERT_DBL_NEAR(0.0, inform_shannon_joint_cmi(joint, 1, 2, 3, 2.0));
+    inform_dist_free(joint);
+}
+
+UNIT(ShannonJointMeasures)
+{
+    // a wide y, so that its sums no longer fit on the stack
+    size_t const shapes[][3] = {{1, 2, 3}, {3, 4, 5}, {2, 3, 300}};
+    inform_counter_width const widths[] = {INFORM_COUNTER_8, INFORM_COUNTER_32,
+        INFORM_COUNTER_64};
+    for (size_t t = 0; t < 3; ++t)
+    {
+        size_t const bz = shapes[t][0], bx = shapes[t][1], by = shapes[t][2];
+        size_t const shape[] = {bz, bx, by};
+        inform_dist *joint = inform_dist_alloc_width(bz * bx * by, widths[t]);
+        ASSERT_NOT_NULL(joint);
+        unsigned seed = 5;
+        for (size_t i = 0; i < 20000; ++i)
+        {
+            seed = seed * 1103515245u + 12345u;
+            size_t const z = (seed >> 8) % bz;
+            size_t const x = (seed >> 12) % bx;
+            // make y depend on x and z
+            size_t const y = ((seed >> 20) % 4 == 0) ? (seed >> 4) % by :
+                (x + 2 * z) % by;
+            inform_dist_tick(joint, (z * bx + x) * by + y);
+        }
+
+        size_t const z[] = {0}, xz[] = {0, 1}, yz[] = {0, 2}, x[] = {1},
+              y[] = {2}, xy[] = {1, 2};
+        inform_dist *mz = inform_dist_marginal(joint, shape, 3, z, 1, NULL);
+        inform_dist *mxz = inform_dist_marginal(joint, shape, 3, xz, 2, NULL);
+        inform_dist *myz = inform_dist_marginal(joint, shape, 3, yz, 2, NULL);
+        inform_dist *mx = inform_dist_marginal(joint, shape, 3, x, 1, NULL);
+        inform_dist *my = inform_dist_marginal(joint, shape, 3, y, 1, NULL);
+        inform_dist *mxy = inform_dist_marginal(joint, shape, 3, xy, 2, NULL);
+
+        ASSERT_DBL_NEAR_TOL(inform_shannon_cmi(joint, mxz, myz, mz, 2.0),
+            inform_shannon_joint_cmi(joint, bz, bx, by, 2.0), 1e-10);
+        ASSERT_DBL_NEAR_TOL(inform_shannon_mi(mxy, mx, my, 3.0),
+            inform_shannon_joint_mi(mxy, bx, by, 3.0), 1e-10);
+        ASSERT_DBL_NEAR_TOL(inform_shannon_ce(mxy, mx, 2.0),
+            inform_shannon_joint_ce(mxy, bx, by, 2.0), 1e-10);
+        // conditioning on z is the same as treating (z, x) as one variable
+        ASSERT_DBL_NEAR_TOL(inform_shannon_ce(joint, mxz, 2.0),
+            inform_shannon_joint_ce(joint, bz * bx, by, 2.0), 1e-10);
+        ASSERT_TRUE(inform_shannon_joint_mi(mxy, bx, by, 2.0) > 0.1);
+
+        inform_dist_free(mxy);
+        inform_dist_free(my);
+        inform_dist_free(mx);
+        inform_dist_free(myz);
+        inform_dist_free(mxz);
+        inform_dist_free(mz);
+        inform_dist_free(joint);
+    }
+}
+
 UNIT(ShannonNonUniform)
 {
     inform_dist *dist = inform_dist_alloc(2);
@@ -372,10 +561,117 @@ UNIT(RelativeEntropyDefined)
     inform_dist_free(p);
 }
 
+UNIT(SparseShannonInvalidDistribution)
+{
+    inform_sparse_dist *dist = NULL;
+    ASSERT_TRUE(isnan(inform_sparse_shannon(dist, 2)));
+    ASSERT_TRUE(isnan(inform_sparse_shannon_si(dist, 0, 2)));
+
+    dist = inform_sparse_dist_alloc(0);
+    ASSERT_TRUE(isnan(inform_sparse_shannon(dist, 2)));
+    ASSERT_TRUE(isnan(inform_sparse_shannon_si(dist, 0, 2)));
+    inform_sparse_dist_free(dist);
+}
+
+UNIT(SparseShannonMatchesDense)
+{
+    inform_dist *dense = inform_dist_alloc(5);
+    inform_dist_fill(dense, 2, 0, 3, 1, 4);
+
+    inform_sparse_dist *sparse = inform_sparse_dist_alloc(0);
+    for (size_t i = 0; i < inform_dist_size(dense); ++i)
+    {
+        // scatter the events far apart to exercise the hashing
+        inform_sparse_dist_set(sparse, (uint64_t) i << 33,
+            inform_dist_get(dense, i), NULL);
+    }
+
+    for (double b = 0.5; b <= 4.0; b += 0.5)
+    {
+        ASSERT_DBL_NEAR_TOL(inform_shannon(dense, b),
+            inform_sparse_shannon(sparse, b), 1e-12);
+        for (size_t i = 0; i < inform_dist_size(dense); ++i)
+        {
+            ASSERT_DBL_NEAR_TOL(inform_shannon_si(dense, i, b),
+                inform_sparse_shannon_si(sparse, (uint64_t) i << 33, b), 1e-12);
+        }
+    }
+
+    inform_sparse_dist_free(sparse);
+    inform_dist_free(dense);
+}
+
+UNIT(ShannonLargeSupport)
+{
+    // a support spanning many blocks, with a ragged tail, zeros and counts
+    // which don't fit in a signed 32-bit integer
+    size_t const n = (1 << 20) + 3;
+    inform_dist *dist = inform_dist_alloc(n);
+    ASSERT_NOT_NULL(dist);
+    unsigned seed = 2016;
+    for (size_t i = 0; i < n; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        inform_dist_set(dist, i, (seed >> 16) % 64);
+    }
+    inform_dist_set(dist, 5, UINT32_MAX - 1);
+
+    long double h = 0.;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (dist->histogram[i] != 0)
+        {
+            long double const p = (long double) dist->histogram[i] / dist->counts;
+            h -= p * log2l(p);
+        }
+    }
+
+    double const serial = inform_shannon(dist, 2);
+    ASSERT_DBL_NEAR_TOL((double) h, serial, 1e-12);
+
+    inform_set_num_threads(4);
+    double const parallel = inform_shannon(dist, 2);
+    inform_set_num_threads(1);
+    ASSERT_TRUE(serial == parallel);
+
+    inform_dist_free(dist);
+}
+
+UNIT(ShannonLargeCounts)
+{
+    // counts on either side of those which have their c log2(c) cached
+    inform_dist *dist = inform_dist_alloc(1001);
+    ASSERT_NOT_NULL(dist);
+    unsigned seed = 1999;
+    for (size_t i = 0; i < 1001; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        inform_dist_set(dist, i, (seed >> 8) % ((i % 2) ? 100 : 100000));
+    }
+
+    long double h = 0.;
+    for (size_t i = 0; i < 1001; ++i)
+    {
+        if (dist->histogram[i] != 0)
+        {
+            long double const p = (long double) dist->histogram[i] / dist->counts;
+            h -= p * log2l(p);
+        }
+    }
+    ASSERT_DBL_NEAR_TOL((double) h, inform_shannon(dist, 2), 1e-12);
+
+    inform_dist_free(dist);
+}
+
 BEGIN_SUITE(Entropy)
     ADD_UNIT(ShannonInvalidDistribution)
     ADD_UNIT(ShannonDeltaFunction)
     ADD_UNIT(ShannonUniform)
+    ADD_UNIT(ShannonCounterWidths)
+    ADD_UNIT(ShannonTrackedNonzero)
+    ADD_UNIT(ShannonTrackedEntropy)
+    ADD_UNIT(ShannonJointNaN)
+    ADD_UNIT(ShannonJointMeasures)
     ADD_UNIT(ShannonNonUniform)
 
     ADD_UNIT(MutualInformationIndependent)
@@ -394,4 +690,9 @@ BEGIN_SUITE(Entropy)
     ADD_UNIT(RelativeEntropyUndefined)
     ADD_UNIT(RelativeEntropySameDist)
     ADD_UNIT(RelativeEntropyDefined)
+
+    ADD_UNIT(SparseShannonInvalidDistribution)
+    ADD_UNIT(SparseShannonMatchesDense)
+    ADD_UNIT(ShannonLargeSupport)
+    ADD_UNIT(ShannonLargeCounts)
 END_SUITE
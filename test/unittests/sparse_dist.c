@@ -0,0 +1,188 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <unit.h>
+#include <inform/sparse_dist.h>
+
+UNIT(SparseAlloc)
+{
+    inform_sparse_dist *dist = inform_sparse_dist_alloc(0);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(0, inform_sparse_dist_size(dist));
+    ASSERT_EQUAL(0, inform_sparse_dist_counts(dist));
+    ASSERT_FALSE(inform_sparse_dist_is_valid(dist));
+    inform_sparse_dist_free(dist);
+}
+
+UNIT(SparseNull)
+{
+    inform_sparse_dist *dist = NULL;
+    ASSERT_EQUAL(0, inform_sparse_dist_size(dist));
+    ASSERT_EQUAL(0, inform_sparse_dist_counts(dist));
+    ASSERT_FALSE(inform_sparse_dist_is_valid(dist));
+    ASSERT_EQUAL(0, inform_sparse_dist_get(dist, 0));
+
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_EQUAL(0, inform_sparse_dist_set(dist, 0, 1, &err));
+    ASSERT_EQUAL(INFORM_EDIST, err);
+
+    err = INFORM_SUCCESS;
+    ASSERT_EQUAL(0, inform_sparse_dist_tick(dist, 0, &err));
+    ASSERT_EQUAL(INFORM_EDIST, err);
+
+    ASSERT_DBL_NEAR(0.0, inform_sparse_dist_prob(dist, 0));
+}
+
+UNIT(SparseEmptyEvent)
+{
+    inform_sparse_dist *dist = inform_sparse_dist_alloc(0);
+    ASSERT_NOT_NULL(dist);
+
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_EQUAL(0, inform_sparse_dist_tick(dist, INFORM_SPARSE_EMPTY, &err));
+    ASSERT_EQUAL(INFORM_EARG, err);
+
+    err = INFORM_SUCCESS;
+    ASSERT_EQUAL(0, inform_sparse_dist_set(dist, INFORM_SPARSE_EMPTY, 3, &err));
+    ASSERT_EQUAL(INFORM_EARG, err);
+
+    ASSERT_EQUAL(0, inform_sparse_dist_size(dist));
+    ASSERT_EQUAL(0, inform_sparse_dist_counts(dist));
+    inform_sparse_dist_free(dist);
+}
+
+UNIT(SparseSetGet)
+{
+    inform_sparse_dist *dist = inform_sparse_dist_alloc(0);
+    ASSERT_NOT_NULL(dist);
+
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_EQUAL(1, inform_sparse_dist_set(dist, 5, 1, &err));
+    ASSERT_EQUAL(2, inform_sparse_dist_set(dist, UINT64_C(1) << 40, 2, &err));
+    ASSERT_EQUAL(3, inform_sparse_dist_set(dist, 0, 3, &err));
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(inform_sparse_dist_is_valid(dist));
+    ASSERT_EQUAL(3, inform_sparse_dist_size(dist));
+    ASSERT_EQUAL(6, inform_sparse_dist_counts(dist));
+
+    ASSERT_EQUAL(1, inform_sparse_dist_get(dist, 5));
+    ASSERT_EQUAL(2, inform_sparse_dist_get(dist, UINT64_C(1) << 40));
+    ASSERT_EQUAL(3, inform_sparse_dist_get(dist, 0));
+    ASSERT_EQUAL(0, inform_sparse_dist_get(dist, 7));
+
+    ASSERT_EQUAL(4, inform_sparse_dist_set(dist, 5, 4, &err));
+    ASSERT_EQUAL(3, inform_sparse_dist_size(dist));
+    ASSERT_EQUAL(9, inform_sparse_dist_counts(dist));
+
+    // a count of zero is a value, not a failure
+    ASSERT_EQUAL(0, inform_sparse_dist_set(dist, 5, 0, &err));
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_EQUAL(0, inform_sparse_dist_get(dist, 5));
+    ASSERT_EQUAL(5, inform_sparse_dist_counts(dist));
+
+    inform_sparse_dist_free(dist);
+}
+
+UNIT(SparseTickGrows)
+{
+    inform_sparse_dist *dist = inform_sparse_dist_alloc(0);
+    ASSERT_NOT_NULL(dist);
+
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        for (uint64_t j = 0; j <= i % 3; ++j)
+        {
+            inform_sparse_dist_tick(dist, i * 7919, NULL);
+        }
+    }
+    ASSERT_EQUAL(1000, inform_sparse_dist_size(dist));
+    ASSERT_EQUAL(1999, inform_sparse_dist_counts(dist));
+    ASSERT_TRUE(dist->capacity >= 1000);
+    for (uint64_t i = 0; i < 1000; ++i)
+    {
+        ASSERT_EQUAL(i % 3 + 1, inform_sparse_dist_get(dist, i * 7919));
+    }
+    ASSERT_EQUAL(0, inform_sparse_dist_get(dist, 1));
+
+    inform_sparse_dist_free(dist);
+}
+
+UNIT(SparseTickOverflow)
+{
+    inform_sparse_dist *dist = inform_sparse_dist_alloc(0);
+    ASSERT_NOT_NULL(dist);
+
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_EQUAL(UINT32_MAX, inform_sparse_dist_set(dist, 3, UINT32_MAX, &err));
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+
+    ASSERT_EQUAL(0, inform_sparse_dist_tick(dist, 3, &err));
+    ASSERT_EQUAL(INFORM_EOVERFLOW, err);
+    ASSERT_EQUAL(UINT32_MAX, inform_sparse_dist_get(dist, 3));
+    ASSERT_EQUAL(UINT32_MAX, inform_sparse_dist_counts(dist));
+
+    // other events are still counted
+    err = INFORM_SUCCESS;
+    ASSERT_EQUAL(1, inform_sparse_dist_tick(dist, 4, &err));
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+
+    inform_sparse_dist_free(dist);
+}
+
+UNIT(SparseProb)
+{
+    inform_sparse_dist *dist = inform_sparse_dist_alloc(3);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_DBL_NEAR(0.0, inform_sparse_dist_prob(dist, 0));
+
+    inform_sparse_dist_set(dist, 10, 1, NULL);
+    inform_sparse_dist_set(dist, 20, 3, NULL);
+    ASSERT_DBL_NEAR(0.25, inform_sparse_dist_prob(dist, 10));
+    ASSERT_DBL_NEAR(0.75, inform_sparse_dist_prob(dist, 20));
+    ASSERT_DBL_NEAR(0.00, inform_sparse_dist_prob(dist, 30));
+
+    inform_sparse_dist_free(dist);
+}
+
+UNIT(SparseSlot)
+{
+    ASSERT_EQUAL(SIZE_MAX, inform_sparse_dist_slot(NULL, 0));
+
+    inform_sparse_dist *dist = inform_sparse_dist_alloc(0);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(SIZE_MAX, inform_sparse_dist_slot(dist, 5));
+
+    for (uint64_t i = 0; i < 100; ++i)
+    {
+        inform_sparse_dist_tick(dist, i * 7919, NULL);
+    }
+    for (uint64_t i = 0; i < 100; ++i)
+    {
+        size_t const j = inform_sparse_dist_slot(dist, i * 7919);
+        ASSERT_TRUE(j < dist->capacity);
+        ASSERT_EQUAL(i * 7919, dist->events[j]);
+    }
+    ASSERT_EQUAL(SIZE_MAX, inform_sparse_dist_slot(dist, 1));
+    ASSERT_EQUAL(SIZE_MAX, inform_sparse_dist_slot(dist, INFORM_SPARSE_EMPTY));
+
+    inform_sparse_dist_free(dist);
+}
+
+UNIT(SparsePreferred)
+{
+    ASSERT_FALSE(inform_sparse_dist_preferred(16, 1));
+    ASSERT_FALSE(inform_sparse_dist_preferred(1 << 20, 1 << 20));
+    ASSERT_TRUE(inform_sparse_dist_preferred(1 << 20, 1000));
+}
+
+BEGIN_SUITE(SparseDistribution)
+    ADD_UNIT(SparseAlloc)
+    ADD_UNIT(SparseNull)
+    ADD_UNIT(SparseEmptyEvent)
+    ADD_UNIT(SparseSetGet)
+    ADD_UNIT(SparseTickGrows)
+    ADD_UNIT(SparseTickOverflow)
+    ADD_UNIT(SparseProb)
+    ADD_UNIT(SparseSlot)
+    ADD_UNIT(SparsePreferred)
+END_SUITE
@@ -0,0 +1,163 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <unit.h>
+#include <inform/active_info.h>
+#include <inform/block_entropy.h>
+#include <inform/entropy_rate.h>
+#include <inform/threads.h>
+#include <inform/transfer_entropy.h>
+#include <math.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define ENSEMBLE_N 64
+#define ENSEMBLE_M 50
+
+static void fill_ensemble(int *series, size_t n, int b, unsigned seed)
+{
+    // a fixed linear congruential generator keeps the ensemble reproducible
+    for (size_t i = 0; i < n; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        series[i] = (int)((seed >> 16) % (unsigned) b);
+    }
+}
+
+UNIT(NumThreads)
+{
+    inform_set_num_threads(3);
+    int const threads = inform_get_num_threads();
+    ASSERT_TRUE(threads == 3 || threads == 1);
+    inform_set_num_threads(0);
+    ASSERT_TRUE(inform_get_num_threads() >= 1);
+    inform_set_num_threads(1);
+    ASSERT_EQUAL(1, inform_get_num_threads());
+}
+
+UNIT(ParallelEnsembleIsBitIdentical)
+{
+    int xs[ENSEMBLE_N * ENSEMBLE_M], ys[ENSEMBLE_N * ENSEMBLE_M];
+    fill_ensemble(xs, ENSEMBLE_N * ENSEMBLE_M, 3, 7);
+    fill_ensemble(ys, ENSEMBLE_N * ENSEMBLE_M, 3, 11);
+
+    double serial[4], parallel[4];
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        inform_set_num_threads(pass == 0 ? 1 : 4);
+        double *result = (pass == 0) ? serial : parallel;
+        result[0] = inform_active_info(xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+        result[1] = inform_entropy_rate(xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+        result[2] = inform_block_entropy(xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+        result[3] = inform_transfer_entropy(ys, xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+    }
+    inform_set_num_threads(1);
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+        ASSERT_FALSE(isnan(serial[i]));
+        ASSERT_TRUE(serial[i] == parallel[i]);
+    }
+}
+
+UNIT(ParallelLocalEnsembleIsBitIdentical)
+{
+    int xs[ENSEMBLE_N * ENSEMBLE_M], ys[ENSEMBLE_N * ENSEMBLE_M];
+    fill_ensemble(xs, ENSEMBLE_N * ENSEMBLE_M, 2, 13);
+    fill_ensemble(ys, ENSEMBLE_N * ENSEMBLE_M, 2, 17);
+
+    size_t const N = ENSEMBLE_N * ENSEMBLE_M;
+    double *serial = malloc(4 * N * sizeof(double));
+    double *parallel = malloc(4 * N * sizeof(double));
+    ASSERT_NOT_NULL(serial);
+    ASSERT_NOT_NULL(parallel);
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        inform_set_num_threads(pass == 0 ? 1 : 4);
+        double *result = (pass == 0) ? serial : parallel;
+        inform_local_active_info(xs, ENSEMBLE_N, ENSEMBLE_M, 2, 3, result, NULL);
+        inform_local_entropy_rate(xs, ENSEMBLE_N, ENSEMBLE_M, 2, 3, result + N, NULL);
+        inform_local_block_entropy(xs, ENSEMBLE_N, ENSEMBLE_M, 2, 3, result + 2*N, NULL);
+        inform_local_transfer_entropy(ys, xs, ENSEMBLE_N, ENSEMBLE_M, 2, 3, result + 3*N, NULL);
+    }
+    inform_set_num_threads(1);
+
+    // only the first n * (m - k) values of each measure are written
+    size_t const written = ENSEMBLE_N * (ENSEMBLE_M - 3);
+    for (size_t j = 0; j < 4; ++j)
+    {
+        for (size_t i = 0; i < written; ++i)
+        {
+            ASSERT_TRUE(serial[j*N + i] == parallel[j*N + i]);
+        }
+    }
+
+    free(parallel);
+    free(serial);
+}
+
+UNIT(ParallelEnsembleInsideParallelRegion)
+{
+    int xs[ENSEMBLE_N * ENSEMBLE_M], ys[ENSEMBLE_N * ENSEMBLE_M];
+    fill_ensemble(xs, ENSEMBLE_N * ENSEMBLE_M, 3, 19);
+    fill_ensemble(ys, ENSEMBLE_N * ENSEMBLE_M, 3, 23);
+
+    double serial[4];
+    inform_set_num_threads(1);
+    serial[0] = inform_active_info(xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+    serial[1] = inform_entropy_rate(xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+    serial[2] = inform_block_entropy(xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+    serial[3] = inform_transfer_entropy(ys, xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+
+    // with nesting disabled each inner region gets a team of one thread,
+    // which must still count every initial condition
+    double nested[2][4];
+    int team = 1;
+    inform_set_num_threads(4);
+#ifdef _OPENMP
+    int const levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(1);
+    #pragma omp parallel num_threads(2)
+#endif
+    {
+#ifdef _OPENMP
+        int const t = omp_get_thread_num();
+        if (t == 0)
+        {
+            team = omp_get_num_threads();
+        }
+#else
+        int const t = 0;
+#endif
+        if (t < 2)
+        {
+            double *result = nested[t];
+            result[0] = inform_active_info(xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+            result[1] = inform_entropy_rate(xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+            result[2] = inform_block_entropy(xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+            result[3] = inform_transfer_entropy(ys, xs, ENSEMBLE_N, ENSEMBLE_M, 3, 2, NULL);
+        }
+    }
+#ifdef _OPENMP
+    omp_set_max_active_levels(levels);
+#endif
+    inform_set_num_threads(1);
+
+    for (int t = 0; t < team; ++t)
+    {
+        for (size_t i = 0; i < 4; ++i)
+        {
+            ASSERT_TRUE(serial[i] == nested[t][i]);
+        }
+    }
+}
+
+BEGIN_SUITE(Threads)
+    ADD_UNIT(NumThreads)
+    ADD_UNIT(ParallelEnsembleIsBitIdentical)
+    ADD_UNIT(ParallelLocalEnsembleIsBitIdentical)
+    ADD_UNIT(ParallelEnsembleInsideParallelRegion)
+END_SUITE
@@ -513,6 +513,245 @@ UNIT(LocalTransferEntropyEnsemble_Base2)
     }
 }
 
+UNIT(TransferEntropySparseSupport)
+{
+    int const xs[] = {
+        0,0,1,1,1,0,1,0,0,1,1,0,1,1,1,1,0,0,0,1,
+        1,0,1,1,0,0,0,1,0,1,1,1,0,0,1,0,1,0,0,1,
+    };
+    int const ys[] = {
+        1,0,0,1,0,1,1,1,0,0,1,0,0,1,1,0,1,0,1,1,
+        0,0,1,0,1,1,0,1,1,0,0,1,0,1,1,1,0,0,1,0,
+    };
+    // declaring a base of 64 makes the support far too large for the few
+    // observations, so the sparse path is taken; the bits must not change
+    double const dense = inform_transfer_entropy(ys, xs, 2, 20, 2, 3, NULL);
+    double const sparse = inform_transfer_entropy(ys, xs, 2, 20, 64, 3, NULL);
+    ASSERT_DBL_NEAR_TOL(dense, 6 * sparse, 1e-12);
+}
+
+UNIT(LocalTransferEntropySparseSupport)
+{
+    int const xs[] = {
+        0,0,1,1,1,0,1,0,0,1,1,0,1,1,1,1,0,0,0,1,
+        1,0,1,1,0,0,0,1,0,1,1,1,0,0,1,0,1,0,0,1,
+    };
+    int const ys[] = {
+        1,0,0,1,0,1,1,1,0,0,1,0,0,1,1,0,1,0,1,1,
+        0,0,1,0,1,1,0,1,1,0,0,1,0,1,1,1,0,0,1,0,
+    };
+    double dense[34], sparse[34];
+    // declaring a base of 64 makes the support far too large for the few
+    // observations, so the sparse path is taken; the bits must not change
+    ASSERT_NOT_NULL(inform_local_transfer_entropy(ys, xs, 2, 20, 2, 3, dense, NULL));
+    ASSERT_NOT_NULL(inform_local_transfer_entropy(ys, xs, 2, 20, 64, 3, sparse, NULL));
+    for (size_t i = 0; i < 34; ++i)
+    {
+        ASSERT_DBL_NEAR_TOL(dense[i], 6 * sparse[i], 1e-12);
+    }
+}
+
+UNIT(TransferEntropyLongHistory)
+{
+    int series[100];
+    unsigned seed = 2016;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        series[i] = (seed >> 16) & 1;
+    }
+
+    // every history of length 40 is distinct, so the source can't add any
+    // information about the next state of the target
+    int source[100];
+    for (size_t i = 0; i < 100; ++i)
+    {
+        source[i] = series[(i + 7) % 100];
+    }
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_DBL_NEAR_TOL(0.0, inform_transfer_entropy(source, series, 1, 100, 2, 40, &err), 1e-12);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+
+    err = INFORM_SUCCESS;
+    ASSERT_TRUE(isnan(inform_transfer_entropy(source, series, 1, 100, 2, 63, &err)));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+}
+
+static void fill_series(int *series, size_t n, int b, unsigned seed)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        series[i] = (int)((seed >> 16) % (unsigned) b);
+    }
+}
+
+UNIT(TransferEntropyAccumulatorErrors)
+{
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_transfer_entropy_acc_alloc(1, 2, &err));
+    ASSERT_EQUAL(INFORM_EBASE, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_transfer_entropy_acc_alloc(2, 0, &err));
+    ASSERT_EQUAL(INFORM_EKZERO, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_transfer_entropy_acc_alloc(2, 63, &err));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+
+    err = INFORM_SUCCESS;
+    ASSERT_TRUE(isnan(inform_transfer_entropy_acc_value(NULL, &err)));
+    ASSERT_EQUAL(INFORM_EFAULT, err);
+    err = INFORM_SUCCESS;
+    inform_transfer_entropy_acc_push(NULL, NULL, NULL, 0, &err);
+    ASSERT_EQUAL(INFORM_EFAULT, err);
+    inform_transfer_entropy_acc_restart(NULL);
+    inform_transfer_entropy_acc_clear(NULL);
+    inform_transfer_entropy_acc_free(NULL);
+
+    err = INFORM_SUCCESS;
+    inform_transfer_entropy_acc *acc = inform_transfer_entropy_acc_alloc(2, 2, &err);
+    ASSERT_NOT_NULL(acc);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(isnan(inform_transfer_entropy_acc_value(acc, &err)));
+    ASSERT_EQUAL(INFORM_EDIST, err);
+
+    int const ys[] = {0,1,1,0,1,1};
+    int const xs[] = {1,0,1,0,2,1};
+    err = INFORM_SUCCESS;
+    inform_transfer_entropy_acc_push(acc, ys, xs, 2, &err);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(isnan(inform_transfer_entropy_acc_value(acc, &err)));
+
+    // invalid states are rejected as a whole
+    err = INFORM_SUCCESS;
+    inform_transfer_entropy_acc_push(acc, ys, NULL, 1, &err);
+    ASSERT_EQUAL(INFORM_ETIMESERIES, err);
+    err = INFORM_SUCCESS;
+    inform_transfer_entropy_acc_push(acc, ys, xs, 6, &err);
+    ASSERT_EQUAL(INFORM_EBADSTATE, err);
+    err = INFORM_SUCCESS;
+    inform_transfer_entropy_acc_push(acc, xs, ys, 6, &err);
+    ASSERT_EQUAL(INFORM_EBADSTATE, err);
+    ASSERT_EQUAL(0, inform_dist_counts(acc->states));
+
+    inform_transfer_entropy_acc_free(acc);
+}
+
+UNIT(TransferEntropyAccumulator)
+{
+    size_t const n = 6, m = 50;
+    int ys[6 * 50], xs[6 * 50];
+    int const bases[] = {2, 3, 4};
+    size_t const chunks[] = {1, 0, 7, 2, 13, 50};
+    for (size_t t = 0; t < 3; ++t)
+    {
+        int const b = bases[t];
+        size_t const k = 3 - t;
+        fill_series(ys, n * m, b, 17 + (unsigned) t);
+        fill_series(xs, n * m, b, 31 + (unsigned) t);
+        // let the target follow the source some of the time
+        for (size_t i = 1; i < n * m; i += 2)
+        {
+            xs[i] = ys[i - 1];
+        }
+
+        inform_error err = INFORM_SUCCESS;
+        inform_transfer_entropy_acc *acc = inform_transfer_entropy_acc_alloc(b, k, &err);
+        ASSERT_NOT_NULL(acc);
+        for (size_t i = 0; i < n; ++i)
+        {
+            // push each pair of time series in uneven pieces
+            size_t pushed = 0;
+            for (size_t c = 0; pushed < m; ++c)
+            {
+                size_t const size = (chunks[c] < m - pushed) ? chunks[c] : m - pushed;
+                inform_transfer_entropy_acc_push(acc, ys + i * m + pushed,
+                    xs + i * m + pushed, size, &err);
+                pushed += size;
+            }
+            ASSERT_EQUAL(INFORM_SUCCESS, err);
+            ASSERT_DBL_NEAR_TOL(inform_transfer_entropy(ys, xs, i + 1, m, b, k, &err),
+                inform_transfer_entropy_acc_value(acc, &err), 1e-10);
+            inform_transfer_entropy_acc_restart(acc);
+        }
+        ASSERT_TRUE(inform_transfer_entropy_acc_value(acc, &err) > 0.1);
+
+        // a cleared accumulator starts over
+        inform_transfer_entropy_acc_clear(acc);
+        inform_transfer_entropy_acc_push(acc, ys + m, xs + m, m, &err);
+        ASSERT_DBL_NEAR_TOL(inform_transfer_entropy(ys + m, xs + m, 1, m, b, k, &err),
+            inform_transfer_entropy_acc_value(acc, &err), 1e-10);
+        ASSERT_EQUAL(INFORM_SUCCESS, err);
+        inform_transfer_entropy_acc_free(acc);
+    }
+}
+
+UNIT(WindowedTransferEntropyErrors)
+{
+    int const ys[] = {0,1,1,0,1,0,0,1};
+    int const xs[] = {1,1,0,0,1,0,1,1};
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_windowed_transfer_entropy(ys, NULL, 1, 8, 2, 2, 4, NULL, &err));
+    ASSERT_EQUAL(INFORM_ETIMESERIES, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_windowed_transfer_entropy(ys, xs, 1, 8, 2, 2, 1, NULL, &err));
+    ASSERT_EQUAL(INFORM_EKLONG, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_windowed_transfer_entropy(ys, xs, 1, 8, 2, 2, 9, NULL, &err));
+    ASSERT_EQUAL(INFORM_EARG, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_windowed_transfer_entropy(ys, xs, 1, 8, 2, 0, 4, NULL, &err));
+    ASSERT_EQUAL(INFORM_EKZERO, err);
+}
+
+UNIT(WindowedTransferEntropy)
+{
+    size_t const n = 3, m = 80;
+    int ys[3 * 80], xs[3 * 80], wy[3 * 80], wx[3 * 80];
+    size_t const ws[] = {3, 12, 80};
+    for (size_t t = 0; t < 3; ++t)
+    {
+        int const b = 2 + (int) t;
+        size_t const k = 1 + t % 2, w = ws[t];
+        fill_series(ys, n * m, b, 7 + (unsigned) t);
+        fill_series(xs, n * m, b, 11 + (unsigned) t);
+        // let the target start following the source half way through
+        for (size_t i = 0; i < n; ++i)
+        {
+            for (size_t j = m / 2; j < m; ++j)
+            {
+                xs[i * m + j] = ys[i * m + j - 1];
+            }
+        }
+
+        inform_error err = INFORM_SUCCESS;
+        double *te = inform_windowed_transfer_entropy(ys, xs, n, m, b, k, w,
+            NULL, &err);
+        ASSERT_NOT_NULL(te);
+        ASSERT_EQUAL(INFORM_SUCCESS, err);
+        for (size_t j = 0; j + w <= m; ++j)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                for (size_t l = 0; l < w; ++l)
+                {
+                    wy[i * w + l] = ys[i * m + j + l];
+                    wx[i * w + l] = xs[i * m + j + l];
+                }
+            }
+            ASSERT_DBL_NEAR_TOL(inform_transfer_entropy(wy, wx, n, w, b, k, &err),
+                te[j], 1e-10);
+        }
+
+        // the output may be provided
+        double out[80];
+        ASSERT_TRUE(out == inform_windowed_transfer_entropy(ys, xs, n, m, b, k,
+            w, out, &err));
+        ASSERT_DBL_NEAR(te[0], out[0]);
+        free(te);
+    }
+}
+
 BEGIN_SUITE(TransferEntropy)
     ADD_UNIT(TransferEntropyNULLSeries)
     ADD_UNIT(TransferEntropyNoInits)
@@ -524,6 +763,8 @@ BEGIN_SUITE(TransferEntropy)
     ADD_UNIT(TransferEntropyBadState)
     ADD_UNIT(TransferEntropySingleSeries_Base2)
     ADD_UNIT(TransferEntropyEnsemble_Base2)
+    ADD_UNIT(TransferEntropySparseSupport)
+    ADD_UNIT(TransferEntropyLongHistory)
     ADD_UNIT(LocalTransferEntropyNULLSeries)
     ADD_UNIT(LocalTransferEntropyNoInits)
     ADD_UNIT(LocalTransferEntropySeriesTooShort)
@@ -535,4 +776,9 @@ BEGIN_SUITE(TransferEntropy)
     ADD_UNIT(LocalTransferEntropyAllocatesOutput)
     ADD_UNIT(LocalTransferEntropySingleSeries_Base2)
     ADD_UNIT(LocalTransferEntropyEnsemble_Base2)
+    ADD_UNIT(LocalTransferEntropySparseSupport)
+    ADD_UNIT(TransferEntropyAccumulatorErrors)
+    ADD_UNIT(TransferEntropyAccumulator)
+    ADD_UNIT(WindowedTransferEntropyErrors)
+    ADD_UNIT(WindowedTransferEntropy)
 END_SUITE
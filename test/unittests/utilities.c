@@ -583,6 +583,51 @@ UNIT(RandomIntMinMax)
     }
 }
 
+UNIT(Encode64ToLarge)
+{
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_EQUAL(-1, inform_encode64((int[]){0,0,1}, 64, 2, &err));
+    ASSERT_EQUAL(INFORM_EENCODE, err);
+
+    err = INFORM_SUCCESS;
+    ASSERT_EQUAL(-1, inform_encode64((int[]){0,0,1}, 32, 4, &err));
+    ASSERT_EQUAL(INFORM_EENCODE, err);
+}
+
+UNIT(Encode64BadState)
+{
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_EQUAL(-1, inform_encode64((int[]){0,2,1}, 3, 2, &err));
+    ASSERT_EQUAL(INFORM_EENCODE, err);
+
+    err = INFORM_SUCCESS;
+    ASSERT_EQUAL(-1, inform_encode64((int[]){0,-1,1}, 3, 2, &err));
+    ASSERT_EQUAL(INFORM_EENCODE, err);
+}
+
+UNIT(DecodeEncode64)
+{
+    int state[40], decoded[40];
+    for (size_t i = 0; i < 40; ++i)
+    {
+        state[i] = (i % 3 == 0);
+    }
+    inform_error err = INFORM_SUCCESS;
+    int64_t const encoding = inform_encode64(state, 40, 2, &err);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(encoding > INT32_MAX);
+
+    inform_decode64(encoding, 2, decoded, 40, &err);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    for (size_t i = 0; i < 40; ++i)
+    {
+        ASSERT_EQUAL(state[i], decoded[i]);
+    }
+
+    inform_decode64(encoding, 2, decoded, 20, &err);
+    ASSERT_EQUAL(INFORM_EENCODE, err);
+}
+
 BEGIN_SUITE(Utilities)
     ADD_UNIT(RangeNullSeries)
     ADD_UNIT(RangeEmpty)
@@ -639,6 +684,9 @@ BEGIN_SUITE(Utilities)
     ADD_UNIT(DecodeBaseThree)
 
     ADD_UNIT(DecodeEncode)
+    ADD_UNIT(Encode64ToLarge)
+    ADD_UNIT(Encode64BadState)
+    ADD_UNIT(DecodeEncode64)
 
     ADD_UNIT(RandomInt)
     ADD_UNIT(RandomIntMinMax)
@@ -0,0 +1,125 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <unit.h>
+#include <inform/shannon.h>
+#include <inform/window_dist.h>
+
+UNIT(WindowAlloc)
+{
+    ASSERT_NULL(inform_window_dist_alloc(0, 5));
+    ASSERT_NULL(inform_window_dist_alloc(5, 0));
+
+    inform_window_dist *dist = inform_window_dist_alloc(4, 3);
+    ASSERT_NOT_NULL(dist);
+    ASSERT_EQUAL(0, inform_window_dist_counts(dist));
+    ASSERT_EQUAL(4, inform_dist_size(inform_window_dist_dist(dist)));
+    ASSERT_FALSE(inform_dist_is_valid(inform_window_dist_dist(dist)));
+    inform_window_dist_free(dist);
+}
+
+UNIT(WindowNull)
+{
+    ASSERT_NULL((void *) inform_window_dist_dist(NULL));
+    ASSERT_EQUAL(0, inform_window_dist_counts(NULL));
+    ASSERT_EQUAL(0, inform_window_dist_tick(NULL, 0));
+    inform_window_dist_clear(NULL);
+    inform_window_dist_free(NULL);
+}
+
+UNIT(WindowTick)
+{
+    inform_window_dist *dist = inform_window_dist_alloc(4, 3);
+    ASSERT_NOT_NULL(dist);
+    inform_dist const *d = inform_window_dist_dist(dist);
+
+    ASSERT_EQUAL(0, inform_window_dist_tick(dist, 4));
+    ASSERT_EQUAL(1, inform_window_dist_tick(dist, 0));
+    ASSERT_EQUAL(2, inform_window_dist_tick(dist, 0));
+    ASSERT_EQUAL(1, inform_window_dist_tick(dist, 1));
+    ASSERT_EQUAL(3, inform_window_dist_counts(dist));
+
+    // the oldest 0 falls out of the window
+    ASSERT_EQUAL(1, inform_window_dist_tick(dist, 2));
+    ASSERT_EQUAL(3, inform_window_dist_counts(dist));
+    ASSERT_EQUAL(1, inform_dist_get(d, 0));
+    ASSERT_EQUAL(1, inform_dist_get(d, 1));
+    ASSERT_EQUAL(1, inform_dist_get(d, 2));
+
+    ASSERT_EQUAL(1, inform_window_dist_tick(dist, 3));
+    ASSERT_EQUAL(2, inform_window_dist_tick(dist, 3));
+    ASSERT_EQUAL(0, inform_dist_get(d, 0));
+    ASSERT_EQUAL(0, inform_dist_get(d, 1));
+    ASSERT_EQUAL(1, inform_dist_get(d, 2));
+    ASSERT_EQUAL(2, inform_dist_get(d, 3));
+
+    inform_window_dist_clear(dist);
+    ASSERT_EQUAL(0, inform_window_dist_counts(dist));
+    ASSERT_EQUAL(1, inform_window_dist_tick(dist, 1));
+    ASSERT_EQUAL(1, inform_dist_get(d, 1));
+    ASSERT_EQUAL(0, inform_dist_get(d, 3));
+    inform_window_dist_free(dist);
+}
+
+UNIT(WindowEntropyTrace)
+{
+    size_t const n = 5000, window = 300, size = 6;
+    int series[5000];
+    unsigned seed = 3;
+    for (size_t i = 0; i < n; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        // drift from a low to a high entropy stream
+        series[i] = ((seed >> 16) % n < i) ? (int)((seed >> 8) % size) : 0;
+    }
+
+    inform_window_dist *dist = inform_window_dist_alloc(size, window);
+    ASSERT_NOT_NULL(dist);
+    for (size_t i = 0; i < n; ++i)
+    {
+        ASSERT_TRUE(inform_window_dist_tick(dist, series[i]) != 0);
+        if (i % 97 == 0 || i + 1 == n)
+        {
+            // rebuild the window from scratch
+            inform_dist *expect = inform_dist_alloc(size);
+            size_t const begin = (i + 1 > window) ? i + 1 - window : 0;
+            for (size_t j = begin; j <= i; ++j)
+            {
+                inform_dist_tick(expect, series[j]);
+            }
+            inform_dist const *got = inform_window_dist_dist(dist);
+            ASSERT_EQUAL(inform_dist_counts(expect), inform_dist_counts(got));
+            for (size_t j = 0; j < size; ++j)
+            {
+                ASSERT_EQUAL(inform_dist_get(expect, j), inform_dist_get(got, j));
+            }
+            ASSERT_DBL_NEAR_TOL(inform_shannon(expect, 2.0),
+                inform_shannon(got, 2.0), 1e-10);
+            inform_dist_free(expect);
+        }
+    }
+    inform_window_dist_free(dist);
+}
+
+UNIT(WindowWide)
+{
+    // a window larger than the narrowest counters can count
+    inform_window_dist *dist = inform_window_dist_alloc(2, 1000);
+    ASSERT_NOT_NULL(dist);
+    for (size_t i = 0; i < 1500; ++i)
+    {
+        inform_window_dist_tick(dist, 1);
+    }
+    ASSERT_EQUAL(1000, inform_dist_get(inform_window_dist_dist(dist), 1));
+    ASSERT_EQUAL(1, inform_window_dist_tick(dist, 0));
+    ASSERT_EQUAL(999, inform_dist_get(inform_window_dist_dist(dist), 1));
+    inform_window_dist_free(dist);
+}
+
+BEGIN_SUITE(WindowDistribution)
+    ADD_UNIT(WindowAlloc)
+    ADD_UNIT(WindowNull)
+    ADD_UNIT(WindowTick)
+    ADD_UNIT(WindowEntropyTrace)
+    ADD_UNIT(WindowWide)
+END_SUITE
@@ -0,0 +1,363 @@
+// Copyright 2016 ELIFE. All rights reserved.
+// Use of this source code is governed by a MIT
+// license that can be found in the LICENSE file.
+#include <unit.h>
+#include <inform/active_info.h>
+#include <inform/block_entropy.h>
+#include <inform/conditional_entropy.h>
+#include <inform/entropy_rate.h>
+#include <inform/mutual_info.h>
+#include <inform/relative_entropy.h>
+#include <inform/transfer_entropy.h>
+#include <inform/workspace.h>
+#include <math.h>
+#include <string.h>
+
+#define SERIES_N 4
+#define SERIES_M 40
+
+static void fill_series(int *series, size_t n, int b, unsigned seed)
+{
+    // a fixed linear congruential generator keeps the series reproducible
+    for (size_t i = 0; i < n; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        series[i] = (int)((seed >> 16) % (unsigned) b);
+    }
+}
+
+UNIT(WorkspaceAlloc)
+{
+    inform_workspace *ws = inform_workspace_alloc(0);
+    ASSERT_NOT_NULL(ws);
+    ASSERT_EQUAL(0, inform_workspace_size(ws));
+    inform_workspace_free(ws);
+
+    ws = inform_workspace_alloc(100);
+    ASSERT_NOT_NULL(ws);
+    ASSERT_EQUAL(100, inform_workspace_size(ws));
+    ASSERT_NOT_NULL(ws->buffer);
+    inform_workspace_free(ws);
+
+    ASSERT_EQUAL(0, inform_workspace_size(NULL));
+    inform_workspace_free(NULL);
+}
+
+UNIT(WorkspaceReserve)
+{
+    ASSERT_NULL(inform_workspace_reserve(NULL, 10));
+
+    inform_workspace *ws = inform_workspace_alloc(16);
+    ASSERT_NOT_NULL(ws);
+
+    void *buffer = inform_workspace_reserve(ws, 8);
+    ASSERT_TRUE(buffer == ws->buffer);
+    ASSERT_EQUAL(16, inform_workspace_size(ws));
+
+    buffer = inform_workspace_reserve(ws, 1024);
+    ASSERT_NOT_NULL(buffer);
+    ASSERT_EQUAL(1024, inform_workspace_size(ws));
+    for (size_t i = 0; i < 1024; ++i)
+    {
+        ASSERT_EQUAL(0, ((unsigned char *) buffer)[i]);
+    }
+
+    // the buffer never shrinks
+    ASSERT_TRUE(buffer == inform_workspace_reserve(ws, 32));
+    ASSERT_EQUAL(1024, inform_workspace_size(ws));
+
+    inform_workspace_free(ws);
+}
+
+UNIT(WorkspaceMeasuresMatch)
+{
+    int xs[SERIES_N * SERIES_M], ys[SERIES_N * SERIES_M];
+    fill_series(xs, SERIES_N * SERIES_M, 3, 5);
+    fill_series(ys, SERIES_N * SERIES_M, 3, 13);
+
+    inform_workspace *ws = inform_workspace_alloc(0);
+    ASSERT_NOT_NULL(ws);
+
+    inform_error err = INFORM_SUCCESS;
+    // run everything twice, so that the second pass gets a dirty workspace
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (size_t k = 1; k <= 3; ++k)
+        {
+            ASSERT_TRUE(inform_active_info(xs, SERIES_N, SERIES_M, 3, k, &err) ==
+                inform_active_info_ws(xs, SERIES_N, SERIES_M, 3, k, ws, &err));
+            ASSERT_TRUE(inform_entropy_rate(xs, SERIES_N, SERIES_M, 3, k, &err) ==
+                inform_entropy_rate_ws(xs, SERIES_N, SERIES_M, 3, k, ws, &err));
+            ASSERT_TRUE(inform_block_entropy(xs, SERIES_N, SERIES_M, 3, k, &err) ==
+                inform_block_entropy_ws(xs, SERIES_N, SERIES_M, 3, k, ws, &err));
+            ASSERT_TRUE(inform_transfer_entropy(ys, xs, SERIES_N, SERIES_M, 3, k, &err) ==
+                inform_transfer_entropy_ws(ys, xs, SERIES_N, SERIES_M, 3, k, ws, &err));
+        }
+        size_t const n = SERIES_N * SERIES_M;
+        ASSERT_TRUE(inform_mutual_info(xs, ys, n, 3, 3, 2, &err) ==
+            inform_mutual_info_ws(xs, ys, n, 3, 3, 2, ws, &err));
+        ASSERT_TRUE(inform_conditional_entropy(xs, ys, n, 3, 3, 2, &err) ==
+            inform_conditional_entropy_ws(xs, ys, n, 3, 3, 2, ws, &err));
+        ASSERT_TRUE(inform_relative_entropy(xs, ys, n, 3, 2, &err) ==
+            inform_relative_entropy_ws(xs, ys, n, 3, 2, ws, &err));
+    }
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+
+    inform_workspace_free(ws);
+}
+
+UNIT(WorkspaceLocalMeasuresMatch)
+{
+    int xs[SERIES_N * SERIES_M], ys[SERIES_N * SERIES_M];
+    fill_series(xs, SERIES_N * SERIES_M, 3, 17);
+    fill_series(ys, SERIES_N * SERIES_M, 3, 19);
+
+    double expect[SERIES_N * SERIES_M], got[SERIES_N * SERIES_M];
+    size_t const n = SERIES_N * SERIES_M;
+
+    inform_workspace *ws = inform_workspace_alloc(0);
+    ASSERT_NOT_NULL(ws);
+
+    inform_error err = INFORM_SUCCESS;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        size_t const k = 2 + pass;
+        size_t const N = SERIES_N * (SERIES_M - k);
+
+        inform_local_active_info(xs, SERIES_N, SERIES_M, 3, k, expect, &err);
+        inform_local_active_info_ws(xs, SERIES_N, SERIES_M, 3, k, got, ws, &err);
+        for (size_t i = 0; i < N; ++i) ASSERT_TRUE(expect[i] == got[i]);
+
+        inform_local_entropy_rate(xs, SERIES_N, SERIES_M, 3, k, expect, &err);
+        inform_local_entropy_rate_ws(xs, SERIES_N, SERIES_M, 3, k, got, ws, &err);
+        for (size_t i = 0; i < N; ++i) ASSERT_TRUE(expect[i] == got[i]);
+
+        inform_local_block_entropy(xs, SERIES_N, SERIES_M, 3, k, expect, &err);
+        inform_local_block_entropy_ws(xs, SERIES_N, SERIES_M, 3, k, got, ws, &err);
+        for (size_t i = 0; i < N + SERIES_N; ++i) ASSERT_TRUE(expect[i] == got[i]);
+
+        inform_local_transfer_entropy(ys, xs, SERIES_N, SERIES_M, 3, k, expect, &err);
+        inform_local_transfer_entropy_ws(ys, xs, SERIES_N, SERIES_M, 3, k, got, ws, &err);
+        for (size_t i = 0; i < N; ++i) ASSERT_TRUE(expect[i] == got[i]);
+
+        inform_local_mutual_info(xs, ys, n, 3, 3, 2, expect, &err);
+        inform_local_mutual_info_ws(xs, ys, n, 3, 3, 2, got, ws, &err);
+        for (size_t i = 0; i < n; ++i) ASSERT_TRUE(expect[i] == got[i]);
+
+        inform_local_conditional_entropy(xs, ys, n, 3, 3, 2, expect, &err);
+        inform_local_conditional_entropy_ws(xs, ys, n, 3, 3, 2, got, ws, &err);
+        for (size_t i = 0; i < n; ++i) ASSERT_TRUE(expect[i] == got[i]);
+
+        inform_local_relative_entropy(xs, ys, n, 3, 2, expect, &err);
+        inform_local_relative_entropy_ws(xs, ys, n, 3, 2, got, ws, &err);
+        for (size_t i = 0; i < 3; ++i) ASSERT_TRUE(expect[i] == got[i]);
+    }
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+
+    // a repeated call of the same size doesn't grow the workspace
+    size_t const size = inform_workspace_size(ws);
+    inform_local_transfer_entropy_ws(ys, xs, SERIES_N, SERIES_M, 3, 3, got, ws, &err);
+    ASSERT_EQUAL(size, inform_workspace_size(ws));
+
+    inform_workspace_free(ws);
+}
+
+UNIT(WorkspaceNull)
+{
+    int xs[SERIES_N * SERIES_M];
+    fill_series(xs, SERIES_N * SERIES_M, 2, 23);
+
+    inform_error err = INFORM_SUCCESS;
+    ASSERT_TRUE(inform_active_info(xs, SERIES_N, SERIES_M, 2, 2, &err) ==
+        inform_active_info_ws(xs, SERIES_N, SERIES_M, 2, 2, NULL, &err));
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+}
+
+UNIT(WorkspacePlanMatchesGrowth)
+{
+    int xs[SERIES_N * SERIES_M], ys[SERIES_N * SERIES_M];
+    fill_series(xs, SERIES_N * SERIES_M, 3, 29);
+    fill_series(ys, SERIES_N * SERIES_M, 3, 31);
+    double out[SERIES_N * SERIES_M];
+    size_t const n = SERIES_N * SERIES_M;
+
+    inform_error err = INFORM_SUCCESS;
+    inform_workspace_plan p;
+    inform_workspace *ws;
+
+#define ASSERT_PLAN_MATCHES(PLAN, CALL) \
+    p = PLAN; \
+    ASSERT_FALSE(p.sparse); \
+    ws = inform_workspace_alloc(0); \
+    CALL; \
+    ASSERT_EQUAL(p.workspace, inform_workspace_size(ws)); \
+    inform_workspace_free(ws);
+
+    size_t const k = 2;
+    ASSERT_PLAN_MATCHES(inform_active_info_plan(SERIES_N, SERIES_M, 3, k, &err),
+        inform_active_info_ws(xs, SERIES_N, SERIES_M, 3, k, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_local_active_info_plan(SERIES_N, SERIES_M, 3, k, &err),
+        inform_local_active_info_ws(xs, SERIES_N, SERIES_M, 3, k, out, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_entropy_rate_plan(SERIES_N, SERIES_M, 3, k, &err),
+        inform_entropy_rate_ws(xs, SERIES_N, SERIES_M, 3, k, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_local_entropy_rate_plan(SERIES_N, SERIES_M, 3, k, &err),
+        inform_local_entropy_rate_ws(xs, SERIES_N, SERIES_M, 3, k, out, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_block_entropy_plan(SERIES_N, SERIES_M, 3, k, &err),
+        inform_block_entropy_ws(xs, SERIES_N, SERIES_M, 3, k, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_local_block_entropy_plan(SERIES_N, SERIES_M, 3, k, &err),
+        inform_local_block_entropy_ws(xs, SERIES_N, SERIES_M, 3, k, out, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_transfer_entropy_plan(SERIES_N, SERIES_M, 3, k, &err),
+        inform_transfer_entropy_ws(ys, xs, SERIES_N, SERIES_M, 3, k, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_local_transfer_entropy_plan(SERIES_N, SERIES_M, 3, k, &err),
+        inform_local_transfer_entropy_ws(ys, xs, SERIES_N, SERIES_M, 3, k, out, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_mutual_info_plan(n, 3, 3, &err),
+        inform_mutual_info_ws(xs, ys, n, 3, 3, 2, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_local_mutual_info_plan(n, 3, 3, &err),
+        inform_local_mutual_info_ws(xs, ys, n, 3, 3, 2, out, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_conditional_entropy_plan(n, 3, 3, &err),
+        inform_conditional_entropy_ws(xs, ys, n, 3, 3, 2, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_local_conditional_entropy_plan(n, 3, 3, &err),
+        inform_local_conditional_entropy_ws(xs, ys, n, 3, 3, 2, out, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_relative_entropy_plan(n, 3, &err),
+        inform_relative_entropy_ws(xs, ys, n, 3, 2, ws, &err));
+    ASSERT_PLAN_MATCHES(inform_local_relative_entropy_plan(n, 3, &err),
+        inform_local_relative_entropy_ws(xs, ys, n, 3, 2, out, ws, &err));
+
+#undef ASSERT_PLAN_MATCHES
+
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+
+    p = inform_local_active_info_plan(SERIES_N, SERIES_M, 3, k, &err);
+    ASSERT_EQUAL(SERIES_N * (SERIES_M - k) * sizeof(double), p.output);
+}
+
+UNIT(WorkspaceWrap)
+{
+    int xs[SERIES_N * SERIES_M], ys[SERIES_N * SERIES_M];
+    fill_series(xs, SERIES_N * SERIES_M, 3, 37);
+    fill_series(ys, SERIES_N * SERIES_M, 3, 41);
+    double expect[SERIES_N * SERIES_M], got[SERIES_N * SERIES_M];
+    size_t const N = SERIES_N * (SERIES_M - 2);
+
+    inform_error err = INFORM_SUCCESS;
+    inform_workspace_plan p = inform_local_transfer_entropy_plan(SERIES_N,
+        SERIES_M, 3, 2, &err);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+
+    void *buffer = malloc(p.workspace);
+    ASSERT_NOT_NULL(buffer);
+    // fill the buffer with garbage, which the measures must clear
+    memset(buffer, 0xff, p.workspace);
+
+    inform_workspace ws = inform_workspace_wrap(buffer, p.workspace);
+    ASSERT_FALSE(ws.owned);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        inform_local_transfer_entropy(ys, xs, SERIES_N, SERIES_M, 3, 2, expect, &err);
+        inform_local_transfer_entropy_ws(ys, xs, SERIES_N, SERIES_M, 3, 2, got, &ws, &err);
+        ASSERT_EQUAL(INFORM_SUCCESS, err);
+        for (size_t i = 0; i < N; ++i) ASSERT_TRUE(expect[i] == got[i]);
+
+        // smaller problems fit in the same buffer
+        ASSERT_TRUE(inform_active_info(xs, SERIES_N, SERIES_M, 3, 2, &err) ==
+            inform_active_info_ws(xs, SERIES_N, SERIES_M, 3, 2, &ws, &err));
+        ASSERT_EQUAL(INFORM_SUCCESS, err);
+    }
+    ASSERT_TRUE(ws.buffer == buffer);
+    ASSERT_EQUAL(p.workspace, inform_workspace_size(&ws));
+
+    // a buffer which is too small is never replaced
+    ws = inform_workspace_wrap(buffer, p.workspace - 1);
+    ASSERT_NULL(inform_local_transfer_entropy_ws(ys, xs, SERIES_N, SERIES_M, 3, 2,
+        got, &ws, &err));
+    ASSERT_EQUAL(INFORM_ENOMEM, err);
+    ASSERT_TRUE(ws.buffer == buffer);
+
+    // nor does an output array allocated for the caller outlive the failure
+    ws = inform_workspace_wrap(buffer, 1);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_local_active_info_ws(xs, SERIES_N, SERIES_M, 3, 2,
+        NULL, &ws, &err));
+    ASSERT_EQUAL(INFORM_ENOMEM, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_local_entropy_rate_ws(xs, SERIES_N, SERIES_M, 3, 2,
+        NULL, &ws, &err));
+    ASSERT_EQUAL(INFORM_ENOMEM, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_local_block_entropy_ws(xs, SERIES_N, SERIES_M, 3, 2,
+        NULL, &ws, &err));
+    ASSERT_EQUAL(INFORM_ENOMEM, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_local_transfer_entropy_ws(ys, xs, SERIES_N, SERIES_M, 3,
+        2, NULL, &ws, &err));
+    ASSERT_EQUAL(INFORM_ENOMEM, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_local_mutual_info_ws(xs, ys, SERIES_N, 3, 3, 2, NULL,
+        &ws, &err));
+    ASSERT_EQUAL(INFORM_ENOMEM, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_local_conditional_entropy_ws(xs, ys, SERIES_N, 3, 3, 2,
+        NULL, &ws, &err));
+    ASSERT_EQUAL(INFORM_ENOMEM, err);
+    err = INFORM_SUCCESS;
+    ASSERT_NULL(inform_local_relative_entropy_ws(xs, ys, SERIES_N, 3, 2, NULL,
+        &ws, &err));
+    ASSERT_EQUAL(INFORM_ENOMEM, err);
+
+    err = INFORM_SUCCESS;
+    ws = inform_workspace_wrap(NULL, 0);
+    ASSERT_TRUE(isnan(inform_mutual_info_ws(xs, ys, SERIES_N, 3, 3, 2, &ws, &err)));
+    ASSERT_EQUAL(INFORM_ENOMEM, err);
+
+    free(buffer);
+}
+
+UNIT(WorkspacePlanSparse)
+{
+    inform_error err = INFORM_SUCCESS;
+    inform_workspace_plan p = inform_active_info_plan(1, 50, 2, 40, &err);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(p.sparse);
+    ASSERT_EQUAL(0, p.workspace);
+    ASSERT_TRUE(p.histogram > 0);
+    ASSERT_EQUAL(0, p.output);
+
+    p = inform_local_transfer_entropy_plan(1, 50, 2, 40, &err);
+    ASSERT_EQUAL(INFORM_SUCCESS, err);
+    ASSERT_TRUE(p.sparse);
+    ASSERT_EQUAL(0, p.workspace);
+    ASSERT_TRUE(p.scratch > 0);
+    ASSERT_EQUAL(10 * sizeof(double), p.output);
+}
+
+UNIT(WorkspacePlanErrors)
+{
+    inform_error err = INFORM_SUCCESS;
+    inform_workspace_plan p = inform_active_info_plan(1, 5, 1, 2, &err);
+    ASSERT_EQUAL(INFORM_EBASE, err);
+    ASSERT_EQUAL(0, p.workspace);
+
+    err = INFORM_SUCCESS;
+    p = inform_local_block_entropy_plan(1, 5, 2, 0, &err);
+    ASSERT_EQUAL(INFORM_EKZERO, err);
+
+    err = INFORM_SUCCESS;
+    p = inform_mutual_info_plan(0, 2, 2, &err);
+    ASSERT_EQUAL(INFORM_ESHORTSERIES, err);
+
+    err = INFORM_SUCCESS;
+    p = inform_relative_entropy_plan(4, 1, &err);
+    ASSERT_EQUAL(INFORM_EBASE, err);
+}
+
+BEGIN_SUITE(Workspace)
+    ADD_UNIT(WorkspaceAlloc)
+    ADD_UNIT(WorkspaceReserve)
+    ADD_UNIT(WorkspaceMeasuresMatch)
+    ADD_UNIT(WorkspaceLocalMeasuresMatch)
+    ADD_UNIT(WorkspaceNull)
+    ADD_UNIT(WorkspacePlanMatchesGrowth)
+    ADD_UNIT(WorkspaceWrap)
+    ADD_UNIT(WorkspacePlanSparse)
+    ADD_UNIT(WorkspacePlanErrors)
+END_SUITE